@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/*
+	CRC32 (gdb flavour, polynomial 0x04c11db7, MSB first) of a memory
+	block, bit by bit.
+
+	parameters:
+	x0 - crc in - crc out
+	x1 - address
+	x2 - byte count
+*/
+
+	.text
+	.arch	armv8-a
+
+	.align	2
+
+_start:
+main:
+	mov		w6, #0x1db7
+	movk	w6, #0x04c1, lsl #16
+	cbz		x2, done
+nbyte:
+	ldrb	w3, [x1], #1
+	eor		w0, w0, w3, lsl #24
+	mov		w4, #8
+loop:
+	lsl		w5, w0, #1
+	eor		w7, w5, w6
+	tst		w0, #0x80000000
+	csel	w0, w7, w5, ne
+	subs	w4, w4, #1
+	b.ne	loop
+	subs	x2, x2, #1
+	b.ne	nbyte
+done:
+	hlt		#0
+
+	.end
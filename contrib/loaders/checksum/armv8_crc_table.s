@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/*
+	CRC32 (gdb flavour, polynomial 0x04c11db7, MSB first) of a memory
+	block, one byte at a time through a 256 entry lookup table.
+
+	parameters:
+	x0 - crc in - crc out
+	x1 - address
+	x2 - byte count
+	x3 - address of the table, in target byte order
+*/
+
+	.text
+	.arch	armv8-a
+
+	.align	2
+
+_start:
+main:
+	cbz		x2, done
+nbyte:
+	ldrb	w4, [x1], #1
+	eor		w4, w4, w0, lsr #24
+	ldr		w4, [x3, x4, lsl #2]
+	eor		w0, w4, w0, lsl #8
+	subs	x2, x2, #1
+	b.ne	nbyte
+done:
+	hlt		#0
+
+	.end
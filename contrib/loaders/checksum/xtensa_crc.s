@@ -0,0 +1,37 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/*
+	CRC32 (gdb flavour, polynomial 0x04c11db7, MSB first) of a memory
+	block, bit by bit.  Uses only the current register window and ends
+	with a break instruction, as xtensa_run_algorithm() expects.
+
+	parameters:
+	a2 - crc in - crc out
+	a3 - address
+	a4 - byte count
+	a5 - polynomial (0x04c11db7)
+*/
+
+	.text
+
+	.align	4
+	.global	_start
+_start:
+	beqz	a4, done
+nbyte:
+	l8ui	a6, a3, 0
+	addi	a3, a3, 1
+	slli	a6, a6, 24
+	xor		a2, a2, a6
+	.rept	8
+	srai	a7, a2, 31
+	and		a7, a7, a5
+	slli	a2, a2, 1
+	xor		a2, a2, a7
+	.endr
+	addi	a4, a4, -1
+	bnez	a4, nbyte
+done:
+	break	1, 15
+
+	.end
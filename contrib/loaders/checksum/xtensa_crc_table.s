@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/*
+	CRC32 (gdb flavour, polynomial 0x04c11db7, MSB first) of a memory
+	block, one byte at a time through a 256 entry lookup table.  Uses
+	only the current register window and ends with a break instruction,
+	as xtensa_run_algorithm() expects.
+
+	parameters:
+	a2 - crc in - crc out
+	a3 - address
+	a4 - byte count
+	a5 - address of the table, in target byte order
+*/
+
+	.text
+
+	.align	4
+	.global	_start
+_start:
+	beqz	a4, done
+nbyte:
+	l8ui	a6, a3, 0
+	addi	a3, a3, 1
+	extui	a7, a2, 24, 8
+	xor		a6, a6, a7
+	addx4	a6, a6, a5
+	l32i	a6, a6, 0
+	slli	a2, a2, 8
+	xor		a2, a2, a6
+	addi	a4, a4, -1
+	bnez	a4, nbyte
+done:
+	break	1, 15
+
+	.end
@@ -7,20 +7,43 @@
 
 /*
 	parameters:
-	r0 - address in
-	r1 - byte count
-	r2 - mask - result out
+	r0 - pointer to struct { uint32_t size_in_result_out, uint32_t addr }
+	r1 - value to check
 */
 
 	.text
 	.arm
 
-loop:
-	ldrb r3, [r0], #1
-	and r2, r2, r3
-	subs r1, r1, #1
-	bne loop
-end:
+BLOCK_SIZE_RESULT	= 0
+BLOCK_ADDRESS		= 4
+SIZEOF_STRUCT_BLOCK	= 8
+
+start:
+block_loop:
+	ldr	r2, [r0, #BLOCK_SIZE_RESULT]	/* get size in words */
+	cmp	r2, #0
+	beq	done
+
+	ldr	r3, [r0, #BLOCK_ADDRESS]	/* get address */
+
+word_loop:
+	ldr	r4, [r3], #4	/* read word */
+	cmp	r4, r1
+	bne	not_erased
+
+	subs	r2, r2, #1
+	bne	word_loop
+
+	mov	r4, #1		/* block is erased */
+save_result:
+	str	r4, [r0], #SIZEOF_STRUCT_BLOCK
+	b	block_loop
+
+not_erased:
+	mov	r4, #0
+	b	save_result
+
+done:
 	bkpt	#0
 
 	.end
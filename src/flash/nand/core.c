@@ -484,8 +484,31 @@ int nand_probe(struct nand_device *nand)
 		}
 	}
 
-	nand->num_blocks = (nand->device->chip_size * 1024) / (nand->erase_size / 1024);
+	int num_blocks = (nand->device->chip_size * 1024) / (nand->erase_size / 1024);
+	uint16_t chip_id = (manufacturer_id << 8) | device_id;
+
+	/* Re-probing the same chip keeps the bad block table built so far;
+	 * scanning the OOB of every block is slow over JTAG and the factory
+	 * markers don't change behind our back.
+	 */
+	if (nand->blocks && nand->num_blocks == num_blocks &&
+			nand->blocks_chip_id == chip_id &&
+			nand->blocks[0].size == (uint32_t)nand->erase_size) {
+		LOG_DEBUG("reusing cached bad block table for chip id 0x%4.4" PRIx16, chip_id);
+		for (i = 0; i < num_blocks; i++)
+			nand->blocks[i].is_erased = -1;
+		return ERROR_OK;
+	}
+
+	free(nand->blocks);
+	nand->num_blocks = num_blocks;
+	nand->blocks_chip_id = chip_id;
 	nand->blocks = malloc(sizeof(struct nand_block) * nand->num_blocks);
+	if (!nand->blocks) {
+		nand->num_blocks = 0;
+		LOG_ERROR("no memory for NAND block table");
+		return ERROR_FAIL;
+	}
 
 	for (i = 0; i < nand->num_blocks; i++) {
 		nand->blocks[i].size = nand->erase_size;
@@ -510,12 +533,12 @@ int nand_erase(struct nand_device *nand, int first_block, int last_block)
 	if ((first_block < 0) || (last_block >= nand->num_blocks))
 		return ERROR_COMMAND_SYNTAX_ERROR;
 
-	/* make sure we know if a block is bad before erasing it */
+	/* make sure we know if a block is bad before erasing it, but only
+	 * scan the blocks whose state isn't cached yet
+	 */
 	for (i = first_block; i <= last_block; i++) {
-		if (nand->blocks[i].is_bad == -1) {
-			nand_build_bbt(nand, i, last_block);
-			break;
-		}
+		if (nand->blocks[i].is_bad == -1)
+			nand_build_bbt(nand, i, i);
 	}
 
 	for (i = first_block; i <= last_block; i++) {
@@ -783,6 +806,19 @@ int nand_read_page_raw(struct nand_device *nand, uint32_t page,
 	if (retval != ERROR_OK)
 		return retval;
 
+	/* OOB directly follows a full page; fetch both in one transfer */
+	if (data && oob && data_size == (uint32_t)nand->page_size &&
+			nand->controller->read_block_data) {
+		uint8_t *buf = malloc(data_size + oob_size);
+		if (buf) {
+			retval = nand_read_data_page(nand, buf, data_size + oob_size);
+			memcpy(data, buf, data_size);
+			memcpy(oob, buf + data_size, oob_size);
+			free(buf);
+			return retval;
+		}
+	}
+
 	if (data)
 		nand_read_data_page(nand, data, data_size);
 
@@ -860,6 +896,25 @@ int nand_write_page_raw(struct nand_device *nand, uint32_t page,
 	if (retval != ERROR_OK)
 		return retval;
 
+	/* OOB directly follows a full page; push both in one transfer so
+	 * on-target copy loops run once per page instead of twice
+	 */
+	if (data && oob && data_size == (uint32_t)nand->page_size &&
+			nand->controller->write_block_data) {
+		uint8_t *buf = malloc(data_size + oob_size);
+		if (buf) {
+			memcpy(buf, data, data_size);
+			memcpy(buf + data_size, oob, oob_size);
+			retval = nand_write_data_page(nand, buf, data_size + oob_size);
+			free(buf);
+			if (retval != ERROR_OK) {
+				LOG_ERROR("Unable to write data to NAND device");
+				return retval;
+			}
+			return nand_write_finish(nand);
+		}
+	}
+
 	if (data) {
 		retval = nand_write_data_page(nand, data, data_size);
 		if (retval != ERROR_OK) {
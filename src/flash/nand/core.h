@@ -58,6 +58,8 @@ struct nand_device {
 	bool use_raw;
 	int num_blocks;
 	struct nand_block *blocks;
+	/** Manufacturer and device ID the cached block table was built for. */
+	uint16_t blocks_chip_id;
 	struct nand_device *next;
 };
 
@@ -48,10 +48,12 @@ static const uint8_t nand_ecc_precalc_table[] = {
 int nand_calculate_ecc(struct nand_device *nand, const uint8_t *dat, uint8_t *ecc_code)
 {
 	uint8_t idx, reg1, reg2, reg3, tmp1, tmp2;
+	unsigned int odd;
 	int i;
 
 	/* Initialize variables */
-	reg1 = reg2 = reg3 = 0;
+	reg1 = reg3 = 0;
+	odd = 0;
 
 	/* Build up column parity */
 	for (i = 0; i < 256; i++) {
@@ -62,10 +64,15 @@ int nand_calculate_ecc(struct nand_device *nand, const uint8_t *dat, uint8_t *ec
 		/* All bit XOR = 1 ? */
 		if (idx & 0x40) {
 			reg3 ^= (uint8_t) i;
-			reg2 ^= ~((uint8_t) i);
+			odd ^= 1;
 		}
 	}
 
+	/* reg2 accumulates ~i wherever reg3 accumulates i, so it only
+	 * differs from reg3 by the parity of the number of such rows
+	 */
+	reg2 = odd ? ~reg3 : reg3;
+
 	/* Create non-inverted ECC code from line parity */
 	tmp1  = (reg3 & 0x80) >> 0; /* B7 -> B7 */
 	tmp1 |= (reg2 & 0x80) >> 1; /* B7 -> B6 */
@@ -22,7 +22,7 @@ S3C24XX_DEVICE_COMMAND()
 	*info = NULL;
 
 	struct s3c24xx_nand_controller *s3c24xx_info;
-	s3c24xx_info = malloc(sizeof(struct s3c24xx_nand_controller));
+	s3c24xx_info = calloc(1, sizeof(struct s3c24xx_nand_controller));
 	if (!s3c24xx_info) {
 		LOG_ERROR("no memory for nand controller");
 		return -ENOMEM;
@@ -31,6 +31,9 @@ S3C24XX_DEVICE_COMMAND()
 	nand->controller_priv = s3c24xx_info;
 	*info = s3c24xx_info;
 
+	s3c24xx_info->io.target = nand->target;
+	s3c24xx_info->io.op = ARM_NAND_NONE;
+
 	return ERROR_OK;
 }
 
@@ -751,6 +751,7 @@ COMMAND_HANDLER(ambiqmicro_handle_mass_erase_command)
 	if (retval != ERROR_OK)
 		return retval;
 
+	flash_cache_invalidate_all();
 	if (ambiqmicro_mass_erase(bank) == ERROR_OK)
 		command_print(CMD, "ambiqmicro mass erase complete");
 	else
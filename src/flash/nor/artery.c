@@ -2526,6 +2526,7 @@ COMMAND_HANDLER(artery_handle_mass_erase_command)
 	if (retval != ERROR_OK)
 		return retval;
 
+	flash_cache_invalidate_all();
 	retval = artery_mass_erase(bank);
 
 	if (retval != ERROR_OK)  {
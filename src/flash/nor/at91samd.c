@@ -970,6 +970,8 @@ COMMAND_HANDLER(samd_handle_chip_erase_command)
 	int res = ERROR_FAIL;
 
 	if (target) {
+		flash_cache_invalidate_all();
+
 		/* Enable access to the DSU by disabling the write protect bit */
 		target_write_u32(target, SAMD_PAC1, (1<<1));
 		/* intentionally without error checking - not accessible on secured chip */
@@ -791,6 +791,8 @@ COMMAND_HANDLER(same5_handle_chip_erase_command)
 	if (!target)
 		return ERROR_FAIL;
 
+	flash_cache_invalidate_all();
+
 	/* Enable access to the DSU by disabling the write protect bit */
 	target_write_u32(target, SAME5_PAC, (1<<16) | (1<<5) | (1<<1));
 	/* intentionally without error checking - not accessible on secured chip */
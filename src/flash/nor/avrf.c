@@ -428,6 +428,7 @@ COMMAND_HANDLER(avrf_handle_mass_erase_command)
 	if (retval != ERROR_OK)
 		return retval;
 
+	flash_cache_invalidate_all();
 	if (avrf_mass_erase(bank) == ERROR_OK)
 		command_print(CMD, "avr mass erase complete");
 	else
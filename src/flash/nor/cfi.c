@@ -1241,35 +1241,27 @@ static int cfi_intel_write_block(struct flash_bank *bank, const uint8_t *buffer,
 
 	target_buffer_set_u32_array(target, target_code, target_code_size / 4, target_code_src);
 
-	/* Get memory for block write handler */
-	retval = target_alloc_working_area(target,
-			target_code_size,
-			&write_algorithm);
-	if (retval != ERROR_OK) {
+	/* Get memory for block write handler and write algorithm code to it */
+	retval = target_alloc_working_area_resident(target, target_code,
+			target_code_size, &write_algorithm);
+	if (retval == ERROR_TARGET_RESOURCE_NOT_AVAILABLE) {
 		LOG_WARNING("No working area available, can't do block memory writes");
 		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
-	}
-
-	/* write algorithm code to working area */
-	retval = target_write_buffer(target, write_algorithm->address,
-			target_code_size, target_code);
-	if (retval != ERROR_OK) {
+	} else if (retval != ERROR_OK) {
 		LOG_ERROR("Unable to write block write code to target");
-		goto cleanup;
+		return retval;
 	}
 
-	/* Get a workspace buffer for the data to flash starting with 32k size.
-	 * Half size until buffer would be smaller 256 Bytes then fail back */
+	/* Get the largest workspace buffer for the data to flash up to 32k size,
+	 * fail back if it would be smaller 256 Bytes */
 	/* FIXME Why 256 bytes, why not 32 bytes (smallest flash write page */
-	while (target_alloc_working_area_try(target, buffer_size, &source) != ERROR_OK) {
-		buffer_size /= 2;
-		if (buffer_size <= 256) {
-			LOG_WARNING(
-				"no large enough working area available, can't do block memory writes");
-			retval = ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
-			goto cleanup;
-		}
+	if (target_alloc_working_area_max(target, 256, buffer_size, &source) != ERROR_OK) {
+		LOG_WARNING(
+			"no large enough working area available, can't do block memory writes");
+		retval = ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+		goto cleanup;
 	}
+	buffer_size = source->size;
 
 	/* setup algo registers */
 	init_reg_param(&reg_params[0], "r0", 32, PARAM_OUT);
@@ -1498,18 +1490,16 @@ static int cfi_spansion_write_block_mips(struct flash_bank *bank, const uint8_t
 
 	/* the following code still assumes target code is fixed 24*4 bytes */
 
-	while (target_alloc_working_area_try(target, buffer_size, &source) != ERROR_OK) {
-		buffer_size /= 2;
-		if (buffer_size <= 256) {
-			/* we already allocated the writing code, but failed to get a
-			 * buffer, free the algorithm */
-			target_free_working_area(target, write_algorithm);
+	if (target_alloc_working_area_max(target, 256, buffer_size, &source) != ERROR_OK) {
+		/* we already allocated the writing code, but failed to get a
+		 * buffer, free the algorithm */
+		target_free_working_area(target, write_algorithm);
 
-			LOG_WARNING(
-				"not enough working area available, can't do block memory writes");
-			return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
-		}
+		LOG_WARNING(
+			"not enough working area available, can't do block memory writes");
+		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
 	}
+	buffer_size = source->size;
 
 	init_reg_param(&reg_params[0], "r4", 32, PARAM_OUT);
 	init_reg_param(&reg_params[1], "r5", 32, PARAM_OUT);
@@ -1877,18 +1867,16 @@ static int cfi_spansion_write_block(struct flash_bank *bank, const uint8_t *buff
 
 	/* the following code still assumes target code is fixed 24*4 bytes */
 
-	while (target_alloc_working_area_try(target, buffer_size, &source) != ERROR_OK) {
-		buffer_size /= 2;
-		if (buffer_size <= 256) {
-			/* we already allocated the writing code, but failed to get a
-			 * buffer, free the algorithm */
-			target_free_working_area(target, write_algorithm);
+	if (target_alloc_working_area_max(target, 256, buffer_size, &source) != ERROR_OK) {
+		/* we already allocated the writing code, but failed to get a
+		 * buffer, free the algorithm */
+		target_free_working_area(target, write_algorithm);
 
-			LOG_WARNING(
-				"not enough working area available, can't do block memory writes");
-			return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
-		}
+		LOG_WARNING(
+			"not enough working area available, can't do block memory writes");
+		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
 	}
+	buffer_size = source->size;
 
 	init_reg_param(&reg_params[0], "r0", 32, PARAM_OUT);
 	init_reg_param(&reg_params[1], "r1", 32, PARAM_OUT);
@@ -15,6 +15,7 @@
 #include <flash/common.h>
 #include <flash/nor/core.h>
 #include <flash/nor/imp.h>
+#include <helper/bits.h>
 #include <target/image.h>
 
 /**
@@ -26,18 +27,417 @@
 
 static struct flash_bank *flash_banks;
 
+/* bumped whenever a bank is added or removed */
+static unsigned int flash_banks_generation;
+
+/* next bank to look at from flash_background_probe_callback() */
+static unsigned int flash_background_probe_bank;
+
+/* nesting depth of flash driver calls made by the flash core, whose
+ * algorithm runs don't modify flash behind the core's back */
+static unsigned int flash_driver_busy;
+
+static void flash_blank_cache_invalidate(struct flash_bank *bank)
+{
+	free(bank->blank_sectors);
+	bank->blank_sectors = NULL;
+	bank->num_blank_sectors = 0;
+}
+
+/* Make sure the blank sector map matches the current sector layout,
+ * which changes when a bank is probed again */
+static bool flash_blank_cache_prepare(struct flash_bank *bank)
+{
+	if (bank->blank_sectors && bank->num_blank_sectors == bank->num_sectors)
+		return true;
+
+	flash_blank_cache_invalidate(bank);
+	if (!bank->num_sectors)
+		return false;
+
+	bank->blank_sectors = calloc(BITS_TO_LONGS(bank->num_sectors), sizeof(unsigned long));
+	if (!bank->blank_sectors)
+		return false;
+
+	bank->num_blank_sectors = bank->num_sectors;
+	return true;
+}
+
+static bool flash_sector_known_blank(struct flash_bank *bank, unsigned int sector)
+{
+	return bank->erase_skip_blank && bank->blank_sectors &&
+		bank->num_blank_sectors == bank->num_sectors &&
+		test_bit(sector, bank->blank_sectors);
+}
+
+/* Forget blank sectors overlapping an address range in every bank,
+ * including aliases such as virtual banks on top of a real one */
+static void flash_blank_cache_clear_range(struct target *target,
+		target_addr_t addr, uint32_t count)
+{
+	for (struct flash_bank *c = flash_banks; c; c = c->next) {
+		if (c->target != target || !c->blank_sectors ||
+				c->num_blank_sectors != c->num_sectors)
+			continue;
+
+		for (unsigned int i = 0; i < c->num_sectors; i++) {
+			target_addr_t sector_addr = c->base + c->sectors[i].offset;
+			if (addr < sector_addr + c->sectors[i].size &&
+					sector_addr < addr + count)
+				clear_bit(i, c->blank_sectors);
+		}
+	}
+}
+
+void flash_blank_cache_update(struct flash_bank *bank)
+{
+	if (!bank->erase_skip_blank || !flash_blank_cache_prepare(bank))
+		return;
+
+	for (unsigned int i = 0; i < bank->num_sectors; i++) {
+		if (bank->sectors[i].is_erased == 1)
+			set_bit(i, bank->blank_sectors);
+		else
+			clear_bit(i, bank->blank_sectors);
+	}
+}
+
+/**
+ * Host copy of a bank's contents.  A sector is @c valid when its content
+ * is known, from a read, an erase or a write over known erased content,
+ * and @c confirmed when that content was also read back or verified.
+ * Only confirmed sectors stand in for the flash, so reads and verifies
+ * never just echo what was written.
+ */
+struct flash_shadow {
+	uint32_t size;
+	unsigned int num_sectors;
+	uint8_t *data;
+	unsigned long *valid;
+	unsigned long *confirmed;
+};
+
+static void flash_shadow_free(struct flash_bank *bank)
+{
+	if (!bank->shadow)
+		return;
+
+	free(bank->shadow->data);
+	free(bank->shadow->valid);
+	free(bank->shadow->confirmed);
+	free(bank->shadow);
+	bank->shadow = NULL;
+}
+
+static void flash_shadow_invalidate(struct flash_bank *bank)
+{
+	if (!bank->shadow)
+		return;
+
+	bitmap_zero(bank->shadow->valid, bank->shadow->num_sectors);
+	bitmap_zero(bank->shadow->confirmed, bank->shadow->num_sectors);
+}
+
+/* Returns the bank's shadow, (re)allocated to its current layout,
+ * or NULL if shadowing is disabled or impossible */
+static struct flash_shadow *flash_shadow_prepare(struct flash_bank *bank)
+{
+	struct flash_shadow *shadow = bank->shadow;
+
+	if (!bank->shadow_enabled || !bank->num_sectors || !bank->size) {
+		flash_shadow_free(bank);
+		return NULL;
+	}
+
+	if (shadow && shadow->size == bank->size && shadow->num_sectors == bank->num_sectors)
+		return shadow;
+
+	flash_shadow_free(bank);
+
+	shadow = calloc(1, sizeof(*shadow));
+	if (!shadow)
+		return NULL;
+
+	shadow->size = bank->size;
+	shadow->num_sectors = bank->num_sectors;
+	shadow->data = malloc(bank->size);
+	shadow->valid = calloc(BITS_TO_LONGS(bank->num_sectors), sizeof(unsigned long));
+	shadow->confirmed = calloc(BITS_TO_LONGS(bank->num_sectors), sizeof(unsigned long));
+	bank->shadow = shadow;
+	if (!shadow->data || !shadow->valid || !shadow->confirmed) {
+		LOG_WARNING("no memory to shadow flash bank %s", bank->name);
+		flash_shadow_free(bank);
+		return NULL;
+	}
+
+	return shadow;
+}
+
+/* Clips sector i to offset..offset+count-1, false if they don't overlap */
+static bool flash_sector_overlap(struct flash_bank *bank, unsigned int i,
+		uint32_t offset, uint32_t count, uint32_t *start, uint32_t *end)
+{
+	*start = MAX(offset, bank->sectors[i].offset);
+	*end = MIN(offset + count, bank->sectors[i].offset + bank->sectors[i].size);
+	return *start < *end;
+}
+
+/* Are all sectors overlapping the range marked in the bitmap? */
+static bool flash_shadow_covers(struct flash_bank *bank, unsigned long *bitmap,
+		uint32_t offset, uint32_t count)
+{
+	uint32_t start, end;
+
+	for (unsigned int i = 0; i < bank->num_sectors; i++) {
+		if (flash_sector_overlap(bank, i, offset, count, &start, &end) &&
+				!test_bit(i, bitmap))
+			return false;
+	}
+	return true;
+}
+
+/* Record data read back from, or verified against, the flash */
+static void flash_shadow_update_confirmed(struct flash_bank *bank,
+		const uint8_t *buffer, uint32_t offset, uint32_t count)
+{
+	struct flash_shadow *shadow = flash_shadow_prepare(bank);
+	if (!shadow)
+		return;
+
+	uint32_t start, end;
+
+	for (unsigned int i = 0; i < bank->num_sectors; i++) {
+		if (!flash_sector_overlap(bank, i, offset, count, &start, &end))
+			continue;
+
+		bool whole = start == bank->sectors[i].offset &&
+			end == bank->sectors[i].offset + bank->sectors[i].size;
+
+		/* a partial read can only refresh a sector already known */
+		if (!whole && !test_bit(i, shadow->valid))
+			continue;
+
+		memcpy(shadow->data + start, buffer + (start - offset), end - start);
+		set_bit(i, shadow->valid);
+		if (whole)
+			set_bit(i, shadow->confirmed);
+	}
+}
+
+/* Record data just programmed.  Programming only gives predictable
+ * results over erased content, so anything else drops the sector. */
+static void flash_shadow_update_written(struct flash_bank *bank,
+		const uint8_t *buffer, uint32_t offset, uint32_t count)
+{
+	struct flash_shadow *shadow = bank->shadow;
+	if (!shadow || shadow->size != bank->size || shadow->num_sectors != bank->num_sectors)
+		return;
+
+	uint32_t start, end;
+
+	for (unsigned int i = 0; i < bank->num_sectors; i++) {
+		if (!flash_sector_overlap(bank, i, offset, count, &start, &end))
+			continue;
+
+		clear_bit(i, shadow->confirmed);
+		if (!test_bit(i, shadow->valid))
+			continue;
+
+		for (uint32_t j = start; j < end; j++) {
+			if (shadow->data[j] != bank->erased_value) {
+				clear_bit(i, shadow->valid);
+				break;
+			}
+		}
+		if (test_bit(i, shadow->valid))
+			memcpy(shadow->data + start, buffer + (start - offset), end - start);
+	}
+}
+
+static void flash_shadow_drop_range(struct flash_bank *bank, uint32_t offset, uint32_t count)
+{
+	struct flash_shadow *shadow = bank->shadow;
+	if (!shadow || shadow->size != bank->size || shadow->num_sectors != bank->num_sectors)
+		return;
+
+	uint32_t start, end;
+
+	for (unsigned int i = 0; i < bank->num_sectors; i++) {
+		if (flash_sector_overlap(bank, i, offset, count, &start, &end)) {
+			clear_bit(i, shadow->valid);
+			clear_bit(i, shadow->confirmed);
+		}
+	}
+}
+
+/* Forget the shadow of other banks aliasing an address range, such as
+ * virtual banks on top of a real one */
+static void flash_shadow_drop_aliases(struct flash_bank *bank,
+		target_addr_t addr, uint32_t count)
+{
+	for (struct flash_bank *c = flash_banks; c; c = c->next) {
+		if (c == bank || c->target != bank->target || !c->shadow)
+			continue;
+		if (addr >= c->base + c->size || c->base >= addr + count)
+			continue;
+
+		target_addr_t start = MAX(addr, c->base);
+		target_addr_t end = MIN(addr + count, c->base + c->size);
+		flash_shadow_drop_range(c, start - c->base, end - start);
+	}
+}
+
+/* Code running on any core may have written to flash, as may algorithms
+ * not run on behalf of the flash core, or the boot code after a reset */
+static int flash_cache_event(struct target *target,
+		enum target_event event, void *priv)
+{
+	switch (event) {
+	case TARGET_EVENT_RESUMED:
+	case TARGET_EVENT_HALTED:
+	case TARGET_EVENT_RESET_ASSERT:
+		break;
+	case TARGET_EVENT_DEBUG_RESUMED:
+		if (flash_driver_busy)
+			return ERROR_OK;
+		break;
+	default:
+		return ERROR_OK;
+	}
+
+	flash_cache_invalidate_all();
+	return ERROR_OK;
+}
+
+void flash_cache_invalidate_all(void)
+{
+	for (struct flash_bank *c = flash_banks; c; c = c->next) {
+		flash_blank_cache_invalidate(c);
+		flash_shadow_invalidate(c);
+	}
+}
+
+void flash_target_memory_written(struct target *target,
+		target_addr_t addr, uint32_t count)
+{
+	flash_blank_cache_clear_range(target, addr, count);
+
+	for (struct flash_bank *c = flash_banks; c; c = c->next) {
+		if (c->target != target || !c->shadow)
+			continue;
+		if (addr >= c->base + c->size || c->base >= addr + count)
+			continue;
+
+		target_addr_t start = MAX(addr, c->base);
+		target_addr_t end = MIN(addr + count, c->base + c->size);
+		flash_shadow_drop_range(c, start - c->base, end - start);
+	}
+}
+
 int flash_driver_erase(struct flash_bank *bank, unsigned int first,
 		unsigned int last)
 {
 	int retval;
 
+	uint32_t offset = bank->sectors[first].offset;
+	uint32_t count = bank->sectors[last].offset + bank->sectors[last].size - offset;
+	flash_shadow_drop_aliases(bank, bank->base + offset, count);
+
+	flash_driver_busy++;
 	retval = bank->driver->erase(bank, first, last);
-	if (retval != ERROR_OK)
+	flash_driver_busy--;
+	if (retval != ERROR_OK) {
 		LOG_ERROR("failed erasing sectors %u to %u", first, last);
+		/* whatever got erased, the rest may be half-erased */
+		flash_blank_cache_invalidate(bank);
+		flash_shadow_drop_range(bank, offset, count);
+		return retval;
+	}
+
+	if (bank->erase_skip_blank && flash_blank_cache_prepare(bank)) {
+		for (unsigned int i = first; i <= last; i++)
+			set_bit(i, bank->blank_sectors);
+	}
+
+	struct flash_shadow *shadow = flash_shadow_prepare(bank);
+	if (shadow) {
+		memset(shadow->data + offset, bank->erased_value, count);
+		for (unsigned int i = first; i <= last; i++) {
+			set_bit(i, shadow->valid);
+			clear_bit(i, shadow->confirmed);
+		}
+	}
 
 	return retval;
 }
 
+/* Erase only the sectors in first..last not known to be blank.  Sectors
+ * of unknown state are checked on the target first when the bank trusts
+ * blank checks and the target has a blank check algorithm. */
+static int flash_driver_erase_nonblank(struct flash_bank *bank,
+		unsigned int first, unsigned int last)
+{
+	if (bank->erase_skip_blank && bank->target->state == TARGET_HALTED &&
+			flash_blank_cache_prepare(bank)) {
+		struct target_memory_check_block *blocks;
+		unsigned int num_blocks = 0;
+
+		blocks = malloc((last - first + 1) * sizeof(*blocks));
+		if (blocks) {
+			for (unsigned int i = first; i <= last; i++) {
+				if (test_bit(i, bank->blank_sectors))
+					continue;
+				blocks[num_blocks].address = bank->base + bank->sectors[i].offset;
+				blocks[num_blocks].size = bank->sectors[i].size;
+				blocks[num_blocks].result = UINT32_MAX;
+				num_blocks++;
+			}
+
+			flash_driver_busy++;
+			for (unsigned int done = 0; done < num_blocks; ) {
+				unsigned int checked = 0;
+				if (target_blank_check_memory(bank->target, blocks + done,
+						num_blocks - done, bank->erased_value, &checked) != ERROR_OK ||
+						!checked)
+					break;
+				done += checked;
+			}
+			flash_driver_busy--;
+
+			for (unsigned int i = first, b = 0; i <= last && b < num_blocks; i++) {
+				if (test_bit(i, bank->blank_sectors))
+					continue;
+				if (blocks[b++].result == 1)
+					set_bit(i, bank->blank_sectors);
+			}
+			free(blocks);
+		}
+	}
+
+	unsigned int skipped = 0;
+	for (unsigned int i = first; i <= last; ) {
+		if (flash_sector_known_blank(bank, i)) {
+			skipped++;
+			i++;
+			continue;
+		}
+
+		unsigned int end = i;
+		while (end < last && !flash_sector_known_blank(bank, end + 1))
+			end++;
+
+		int retval = flash_driver_erase(bank, i, end);
+		if (retval != ERROR_OK)
+			return retval;
+		i = end + 1;
+	}
+
+	if (skipped)
+		LOG_INFO("skipped erasing %u blank sector(s) of %u", skipped, last - first + 1);
+
+	return ERROR_OK;
+}
+
 int flash_driver_protect(struct flash_bank *bank, int set, unsigned int first,
 		unsigned int last)
 {
@@ -79,6 +479,9 @@ int flash_driver_protect(struct flash_bank *bank, int set, unsigned int first,
 	if (retval != ERROR_OK)
 		LOG_ERROR("failed setting protection for blocks %u to %u", first, last);
 
+	/* some parts erase flash when protection is lifted */
+	flash_cache_invalidate_all();
+
 	return retval;
 }
 
@@ -87,15 +490,24 @@ int flash_driver_write(struct flash_bank *bank,
 {
 	int retval;
 
+	flash_blank_cache_clear_range(bank->target, bank->base + offset, count);
+	flash_shadow_drop_aliases(bank, bank->base + offset, count);
+
+	flash_driver_busy++;
 	retval = bank->driver->write(bank, buffer, offset, count);
+	flash_driver_busy--;
 	if (retval != ERROR_OK) {
 		LOG_ERROR(
 			"error writing to flash at address " TARGET_ADDR_FMT
 			" at offset 0x%8.8" PRIx32,
 			bank->base,
 			offset);
+		flash_shadow_drop_range(bank, offset, count);
+		return retval;
 	}
 
+	flash_shadow_update_written(bank, buffer, offset, count);
+
 	return retval;
 }
 
@@ -106,15 +518,28 @@ int flash_driver_read(struct flash_bank *bank,
 
 	LOG_DEBUG("call flash_driver_read()");
 
+	struct flash_shadow *shadow = flash_shadow_prepare(bank);
+	if (shadow && offset + count <= shadow->size &&
+			flash_shadow_covers(bank, shadow->confirmed, offset, count)) {
+		LOG_DEBUG("reading 0x%" PRIx32 " bytes from flash shadow", count);
+		memcpy(buffer, shadow->data + offset, count);
+		return ERROR_OK;
+	}
+
+	flash_driver_busy++;
 	retval = bank->driver->read(bank, buffer, offset, count);
+	flash_driver_busy--;
 	if (retval != ERROR_OK) {
 		LOG_ERROR(
 			"error reading to flash at address " TARGET_ADDR_FMT
 			" at offset 0x%8.8" PRIx32,
 			bank->base,
 			offset);
+		return retval;
 	}
 
+	flash_shadow_update_confirmed(bank, buffer, offset, count);
+
 	return retval;
 }
 
@@ -129,8 +554,21 @@ int flash_driver_verify(struct flash_bank *bank,
 {
 	int retval;
 
-	retval = bank->driver->verify ? bank->driver->verify(bank, buffer, offset, count) :
-		default_flash_verify(bank, buffer, offset, count);
+	/* content read back or verified before can't have changed since */
+	struct flash_shadow *shadow = flash_shadow_prepare(bank);
+	if (shadow && offset + count <= shadow->size &&
+			flash_shadow_covers(bank, shadow->confirmed, offset, count)) {
+		LOG_DEBUG("verifying 0x%" PRIx32 " bytes against flash shadow", count);
+		retval = memcmp(buffer, shadow->data + offset, count) ? ERROR_FAIL : ERROR_OK;
+	} else {
+		flash_driver_busy++;
+		retval = bank->driver->verify ? bank->driver->verify(bank, buffer, offset, count) :
+			default_flash_verify(bank, buffer, offset, count);
+		flash_driver_busy--;
+		if (retval == ERROR_OK)
+			flash_shadow_update_confirmed(bank, buffer, offset, count);
+	}
+
 	if (retval != ERROR_OK) {
 		LOG_ERROR("verify failed in bank at " TARGET_ADDR_FMT " starting at 0x%8.8" PRIx32,
 			bank->base, offset);
@@ -174,10 +612,13 @@ void flash_bank_add(struct flash_bank *bank)
 		}
 		p->next = bank;
 		bank_num += 1;
-	} else
+	} else {
 		flash_banks = bank;
+		target_register_event_callback(flash_cache_event, NULL);
+	}
 
 	bank->bank_number = bank_num;
+	flash_banks_generation++;
 }
 
 struct flash_bank *flash_bank_list(void)
@@ -225,12 +666,95 @@ void flash_free_all_banks(void)
 
 		free(bank->sectors);
 		free(bank->prot_blocks);
+		free(bank->blank_sectors);
+		flash_shadow_free(bank);
 
 		free(bank->name);
 		free(bank);
 		bank = next;
 	}
+	if (flash_banks)
+		target_unregister_event_callback(flash_cache_event, NULL);
 	flash_banks = NULL;
+	flash_banks_generation++;
+}
+
+static inline uint64_t flash_layout_hash(uint64_t hash, uint64_t value)
+{
+	/* FNV-1a, one 64-bit word at a time */
+	for (unsigned int i = 0; i < 8; i++) {
+		hash ^= (value >> (8 * i)) & 0xff;
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+uint64_t flash_layout_signature(struct target *target)
+{
+	uint64_t hash = flash_layout_hash(0xcbf29ce484222325ull, flash_banks_generation);
+
+	for (struct flash_bank *p = flash_banks; p; p = p->next) {
+		if (p->target != target)
+			continue;
+
+		hash = flash_layout_hash(hash, p->base);
+		hash = flash_layout_hash(hash, p->size);
+		hash = flash_layout_hash(hash, p->read_only);
+		hash = flash_layout_hash(hash, p->num_sectors);
+		for (unsigned int i = 0; i < p->num_sectors && p->sectors; i++) {
+			hash = flash_layout_hash(hash, p->sectors[i].offset);
+			hash = flash_layout_hash(hash, p->sectors[i].size);
+		}
+	}
+
+	return hash;
+}
+
+static int flash_background_probe_callback(void *priv)
+{
+	unsigned int i = 0;
+	struct flash_bank *bank = flash_banks;
+	while (bank && i < flash_background_probe_bank) {
+		bank = bank->next;
+		i++;
+	}
+
+	if (!bank) {
+		LOG_DEBUG("background probe of flash banks done");
+		target_unregister_timer_callback(flash_background_probe_callback, priv);
+		return ERROR_OK;
+	}
+
+	/* Don't touch the flash controller while polling is masked (e.g. during
+	 * reset and the reset-init handler that configures the clocks), or from
+	 * within an event handler: retry on the next tick. */
+	if (!is_jtag_poll_safe() || target_event_handler_running())
+		return ERROR_OK;
+
+	/* Probe only one bank per tick, so that the servers stay responsive.
+	 * Banks that can't be probed yet are left for the next auto_probe:
+	 * those of running targets, and those of targets with a reset-init
+	 * handler, whose controller may not be set up before it has run. */
+	flash_background_probe_bank++;
+	if (!target_was_examined(bank->target) || bank->target->state != TARGET_HALTED)
+		return ERROR_OK;
+	if (target_has_event_action(bank->target, TARGET_EVENT_RESET_INIT))
+		return ERROR_OK;
+
+	int retval = bank->driver->auto_probe(bank);
+	if (retval != ERROR_OK)
+		LOG_DEBUG("background probe of flash bank '%s' failed (%d)",
+			bank->name, retval);
+
+	return ERROR_OK;
+}
+
+int flash_background_probe_start(void)
+{
+	flash_background_probe_bank = 0;
+	target_unregister_timer_callback(flash_background_probe_callback, NULL);
+	return target_register_timer_callback(flash_background_probe_callback,
+		FLASH_BACKGROUND_PROBE_MS, TARGET_TIMER_TYPE_PERIODIC, NULL);
 }
 
 struct flash_bank *get_flash_bank_by_name_noprobe(const char *name)
@@ -617,6 +1141,13 @@ int flash_erase_address_range(struct target *target,
 		addr, length, false, &flash_driver_erase);
 }
 
+static int flash_erase_nonblank_address_range(struct target *target,
+	target_addr_t addr, uint32_t length)
+{
+	return flash_iterate_address_range(target, "erase",
+		addr, length, false, &flash_driver_erase_nonblank);
+}
+
 static int flash_driver_unprotect(struct flash_bank *bank, unsigned int first,
 		unsigned int last)
 {
@@ -961,9 +1492,9 @@ int flash_write_unlock_verify(struct target *target, struct image *image,
 			retval = flash_unlock_address_range(target, run_address, run_size);
 		if (retval == ERROR_OK) {
 			if (erase) {
-				/* calculate and erase sectors */
-				retval = flash_erase_address_range(target,
-						true, run_address, run_size);
+				/* calculate and erase sectors, skipping blank ones */
+				retval = flash_erase_nonblank_address_range(target,
+						run_address, run_size);
 			}
 		}
 
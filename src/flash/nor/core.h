@@ -13,6 +13,8 @@
 
 #include <flash/common.h>
 
+struct flash_shadow;
+
 /**
  * @file
  * Upper level NOR flash interfaces.
@@ -127,6 +129,23 @@ struct flash_bank {
 	/** Array of protection blocks, allocated and initialized by the flash driver */
 	struct flash_sector *prot_blocks;
 
+	/**
+	 * Bitmap of sectors known to hold only the erased value, maintained
+	 * by the flash core while @c erase_skip_blank is enabled.  Bits are
+	 * set by erase and erase check, cleared by writes to the range, and
+	 * the whole map is dropped whenever any target runs or resets.
+	 */
+	unsigned long *blank_sectors;
+	/** Number of sectors @c blank_sectors was sized for */
+	unsigned int num_blank_sectors;
+	/** Trust blank check results, letting erase skip blank sectors */
+	bool erase_skip_blank;
+
+	/** Keep a host copy of the bank contents, see 'flash shadow' */
+	bool shadow_enabled;
+	/** Host copy of the bank contents, private to the flash core */
+	struct flash_shadow *shadow;
+
 	struct flash_bank *next; /**< The next flash bank on this chip */
 };
 
@@ -181,6 +200,27 @@ int flash_write(struct target *target,
  */
 void flash_set_dirty(void);
 
+/**
+ * Records the flash_sector::is_erased results of an erase check in the
+ * bank's blank sector map, if the bank trusts blank checks.
+ */
+void flash_blank_cache_update(struct flash_bank *bank);
+
+/**
+ * Forgets the blank sector maps and flash shadows of all banks.  Driver
+ * commands changing flash behind the flash core's back, like mass erase,
+ * must call this.
+ */
+void flash_cache_invalidate_all(void);
+
+/**
+ * Tells the flash core that @a count bytes at @a addr of @a target memory
+ * were written by other means than the flash drivers, so it forgets what
+ * it knows about flash in that range.
+ */
+void flash_target_memory_written(struct target *target,
+		target_addr_t addr, uint32_t count);
+
 /** @returns The number of flash banks currently defined. */
 unsigned int flash_get_bank_count(void);
 
@@ -190,6 +230,24 @@ void default_flash_free_driver_priv(struct flash_bank *bank);
 /** Deallocates all flash banks */
 void flash_free_all_banks(void);
 
+/**
+ * Computes a fingerprint of the geometry of all banks belonging to
+ * @a target, as reported in the gdb memory map.  It changes whenever
+ * banks are added or removed or a probe changes their sector layout,
+ * so callers can cache anything derived from it.
+ * No bank is probed.
+ */
+uint64_t flash_layout_signature(struct target *target);
+
+/** Interval between banks probed by flash_background_probe_start() */
+#define FLASH_BACKGROUND_PROBE_MS 10
+
+/**
+ * Probes all flash banks from a timer callback, one bank per tick, so
+ * that the first gdb connection doesn't have to wait for slow probes.
+ */
+int flash_background_probe_start(void);
+
 /**
  * Provides default read implementation for flash memory.
  * @param bank The bank to read.
@@ -863,6 +863,7 @@ COMMAND_HANDLER(em357_handle_mass_erase_command)
 	if (retval != ERROR_OK)
 		return retval;
 
+	flash_cache_invalidate_all();
 	retval = em357_mass_erase(bank);
 	if (retval == ERROR_OK)
 		command_print(CMD, "em357 mass erase complete");
@@ -502,6 +502,7 @@ COMMAND_HANDLER(handle_esirisc_flash_mass_erase_command)
 	if (retval != ERROR_OK)
 		return retval;
 
+	flash_cache_invalidate_all();
 	retval = esirisc_flash_mass_erase(bank);
 
 	command_print(CMD, "mass erase %s",
@@ -940,6 +940,7 @@ COMMAND_HANDLER(fm3_handle_chip_erase_command)
 	if (retval != ERROR_OK)
 		return retval;
 
+	flash_cache_invalidate_all();
 	if (fm3_chip_erase(bank) == ERROR_OK) {
 		command_print(CMD, "fm3 chip erase complete");
 	} else {
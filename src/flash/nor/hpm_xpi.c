@@ -435,6 +435,7 @@ COMMAND_HANDLER(hpm_xpi_handle_erase_chip_command)
 		return ERROR_TARGET_NOT_HALTED;
 	}
 
+	flash_cache_invalidate_all();
 	return hpm_xpi_erase_chip(bank);
 }
 
@@ -10,12 +10,21 @@
 
 #include "imp.h"
 #include <jtag/jtag.h>
+#include <jtag/adapter.h>
 #include <flash/nor/spi.h>
+#include <flash/nor/sfdp.h>
 #include <helper/time_support.h>
 #include <pld/pld.h>
 
 #define JTAGSPI_MAX_TIMEOUT 3000
 
+/* number of bytes programmed per JTAG queue flush in pipelined mode */
+#define JTAGSPI_BATCH_SIZE		0x8000
+/* page program time assumed when SFDP doesn't provide one */
+#define JTAGSPI_DEF_PPROG_TIME	1000 /* us */
+/* upper limit for status reads queued after each page program */
+#define JTAGSPI_MAX_STATUS_POLLS	256
+
 
 struct jtagspi_flash_bank {
 	struct jtag_tap *tap;
@@ -27,6 +36,8 @@ struct jtagspi_flash_bank {
 	struct pld_device *pld_device; /* if not NULL, the PLD has special instructions for JTAGSPI */
 	uint32_t ir;                   /* when !pld_device, this instruction code is used in
 									  jtagspi_set_user_ir to connect through a proxy bitstream */
+	bool pipelined;                /* queue several pages with their status reads per flush */
+	unsigned int status_polls;     /* status reads queued after each page program */
 };
 
 FLASH_BANK_COMMAND_HANDLER(jtagspi_flash_bank_command)
@@ -76,6 +87,7 @@ FLASH_BANK_COMMAND_HANDLER(jtagspi_flash_bank_command)
 
 	info->ir = ir;
 	info->pld_device = device;
+	info->pipelined = true;
 
 	return ERROR_OK;
 }
@@ -85,7 +97,7 @@ static void jtagspi_set_user_ir(struct jtagspi_flash_bank *info)
 	struct scan_field field;
 	uint8_t buf[4] = { 0 };
 
-	LOG_DEBUG("loading jtagspi ir(0x%" PRIx32 ")", info->ir);
+	LOG_DEBUG_IO("loading jtagspi ir(0x%" PRIx32 ")", info->ir);
 	buf_set_u32(buf, 0, info->tap->ir_length, info->ir);
 	field.num_bits = info->tap->ir_length;
 	field.out_value = buf;
@@ -99,8 +111,21 @@ static void flip_u8(const uint8_t *in, uint8_t *out, unsigned int len)
 		out[i] = flip_u32(in[i], 8);
 }
 
-static int jtagspi_cmd(struct flash_bank *bank, uint8_t cmd,
-		uint8_t *write_buffer, unsigned int write_len, uint8_t *data_buffer, int data_len)
+static uint8_t *fill_addr(uint32_t addr, unsigned int addr_len, uint8_t *buffer)
+{
+	for (buffer += addr_len; addr_len > 0; --addr_len) {
+		*--buffer = addr;
+		addr >>= 8;
+	}
+
+	return buffer;
+}
+
+/* Queue a single SPI transaction without flushing the JTAG queue. Data read
+ * into data_buffer is bit reversed until jtag_execute_queue() has completed
+ * and the caller has applied flip_u8(). Write buffers are left unmodified. */
+static int jtagspi_queue_cmd(struct flash_bank *bank, uint8_t cmd,
+		const uint8_t *write_buffer, unsigned int write_len, uint8_t *data_buffer, int data_len)
 {
 	assert(write_buffer || write_len == 0);
 	assert(data_buffer || data_len == 0);
@@ -108,7 +133,7 @@ static int jtagspi_cmd(struct flash_bank *bank, uint8_t cmd,
 	struct scan_field fields[6];
 	struct jtagspi_flash_bank *info = bank->driver_priv;
 
-	LOG_DEBUG("cmd=0x%02x write_len=%d data_len=%d", cmd, write_len, data_len);
+	LOG_DEBUG_IO("cmd=0x%02x write_len=%d data_len=%d", cmd, write_len, data_len);
 
 	/* negative data_len == read operation */
 	const bool is_read = (data_len < 0);
@@ -127,6 +152,16 @@ static int jtagspi_cmd(struct flash_bank *bank, uint8_t cmd,
 	int n = 0;
 	const uint8_t marker = 1;
 	uint8_t xfer_bits[4];
+	uint8_t *out_bits = NULL;
+	unsigned int out_len = write_len + (is_read ? 0 : data_len);
+	if (out_len) {
+		/* keep the caller's buffers intact, bit reversal happens in a copy */
+		out_bits = malloc(out_len);
+		if (!out_bits) {
+			LOG_ERROR("not enough memory");
+			return ERROR_FAIL;
+		}
+	}
 	if (!info->pld_device) { /* mode == JTAGSPI_MODE_PROXY_BITSTREAM */
 		facing_read_bits = jtag_tap_count_enabled();
 		fields[n].num_bits = 1;
@@ -151,9 +186,9 @@ static int jtagspi_cmd(struct flash_bank *bank, uint8_t cmd,
 	n++;
 
 	if (write_len) {
-		flip_u8(write_buffer, write_buffer, write_len);
+		flip_u8(write_buffer, out_bits, write_len);
 		fields[n].num_bits = write_len * CHAR_BIT;
-		fields[n].out_value = write_buffer;
+		fields[n].out_value = out_bits;
 		fields[n].in_value = NULL;
 		n++;
 	}
@@ -170,8 +205,8 @@ static int jtagspi_cmd(struct flash_bank *bank, uint8_t cmd,
 			fields[n].out_value = NULL;
 			fields[n].in_value = data_buffer;
 		} else {
-			flip_u8(data_buffer, data_buffer, data_len);
-			fields[n].out_value = data_buffer;
+			flip_u8(data_buffer, out_bits + write_len, data_len);
+			fields[n].out_value = out_bits + write_len;
 			fields[n].in_value = NULL;
 		}
 		fields[n].num_bits = data_len * CHAR_BIT;
@@ -184,22 +219,42 @@ static int jtagspi_cmd(struct flash_bank *bank, uint8_t cmd,
 		n++;
 	}
 
+	if (!info->pld_device)
+		jtagspi_set_user_ir(info);
+
+	/* passing from an IR scan to SHIFT-DR clears BYPASS registers,
+	 * out values are copied into the command queue */
+	jtag_add_dr_scan(info->tap, n, fields, TAP_IDLE);
+	free(out_bits);
+
+	return ERROR_OK;
+}
+
+static int jtagspi_cmd(struct flash_bank *bank, uint8_t cmd,
+		const uint8_t *write_buffer, unsigned int write_len, uint8_t *data_buffer, int data_len)
+{
+	struct jtagspi_flash_bank *info = bank->driver_priv;
+	int retval;
+
+	LOG_DEBUG("cmd=0x%02x write_len=%d data_len=%d", cmd, write_len, data_len);
+
 	if (info->pld_device) {
-		int retval = pld_connect_spi_to_jtag(info->pld_device);
+		retval = pld_connect_spi_to_jtag(info->pld_device);
 		if (retval != ERROR_OK)
 			return retval;
-	} else {
-		jtagspi_set_user_ir(info);
 	}
 
-	/* passing from an IR scan to SHIFT-DR clears BYPASS registers */
-	jtag_add_dr_scan(info->tap, n, fields, TAP_IDLE);
-	int retval = jtag_execute_queue();
+	retval = jtagspi_queue_cmd(bank, cmd, write_buffer, write_len, data_buffer, data_len);
 	if (retval != ERROR_OK)
 		return retval;
 
-	if (is_read)
-		flip_u8(data_buffer, data_buffer, data_len);
+	retval = jtag_execute_queue();
+	if (retval != ERROR_OK)
+		return retval;
+
+	/* negative data_len == read operation */
+	if (data_len < 0)
+		flip_u8(data_buffer, data_buffer, -data_len);
 
 	if (info->pld_device)
 		return pld_disconnect_spi_from_jtag(info->pld_device);
@@ -345,6 +400,7 @@ COMMAND_HANDLER(jtagspi_handle_set)
 	}
 
 	bank->sectors = sectors;
+	info->status_polls = 0;
 	info->dev.name = info->devname;
 	if (info->dev.size_in_bytes / 4096)
 		LOG_INFO("flash \'%s\' id = unknown\nflash size = %" PRIu32 " kbytes",
@@ -433,6 +489,89 @@ COMMAND_HANDLER(jtagspi_handle_always_4byte)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(jtagspi_handle_pipelined)
+{
+	struct flash_bank *bank;
+	struct jtagspi_flash_bank *jtagspi_info;
+	int retval;
+
+	LOG_DEBUG("%s", __func__);
+
+	if ((CMD_ARGC != 1) && (CMD_ARGC != 2))
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	retval = CALL_COMMAND_HANDLER(flash_command_get_bank, 0, &bank);
+	if (retval != ERROR_OK)
+		return retval;
+
+	jtagspi_info = bank->driver_priv;
+
+	if (CMD_ARGC == 1)
+		command_print(CMD, jtagspi_info->pipelined ? "on" : "off");
+	else
+		COMMAND_PARSE_BOOL(CMD_ARGV[1], jtagspi_info->pipelined, "on", "off");
+
+	return ERROR_OK;
+}
+
+static int jtagspi_read_sfdp_block(struct flash_bank *bank, uint32_t addr,
+		unsigned int words, uint32_t *buffer)
+{
+	/* 3-byte address followed by 8 dummy clocks, as mandated by JESD216 */
+	uint8_t addr_dummy[4] = { 0 };
+	uint8_t data[4 * words];
+
+	fill_addr(addr, 3, addr_dummy);
+	int retval = jtagspi_cmd(bank, SPIFLASH_READ_SFDP, addr_dummy, sizeof(addr_dummy),
+		data, -(int)sizeof(data));
+	if (retval != ERROR_OK)
+		return retval;
+
+	for (unsigned int i = 0; i < words; i++)
+		buffer[i] = le_to_h_u32(&data[4 * i]);
+	return ERROR_OK;
+}
+
+/* For devices from the table which need 4-byte addresses, check SFDP for
+ * dedicated 4-byte address instructions. These don't require switching the
+ * device's address mode by an extra command. */
+/* whether reads, page programs and sector erases all use 4-byte addresses */
+static bool jtagspi_4byte_cmds(const struct flash_device *dev)
+{
+	if (dev->read_cmd != 0x13 || dev->pprog_cmd != 0x12)
+		return false;
+
+	switch (dev->erase_cmd) {
+	case 0x00:	/* no sector erase */
+	case 0x21:
+	case 0x5c:
+	case 0xdc:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void jtagspi_probe_4byte_cmds(struct flash_bank *bank)
+{
+	struct jtagspi_flash_bank *info = bank->driver_priv;
+	struct flash_device temp;
+
+	if (spi_sfdp(bank, &temp, jtagspi_read_sfdp_block) != ERROR_OK)
+		return;
+
+	info->dev.pprog_time = temp.pprog_time;
+	if (temp.read_cmd != 0x13 || temp.pprog_cmd != 0x12)
+		return;
+
+	LOG_INFO("using 4-byte address instructions");
+	info->dev.read_cmd = temp.read_cmd;
+	info->dev.pprog_cmd = temp.pprog_cmd;
+	/* the table may have chosen a different erase block size */
+	if (temp.sectorsize == info->dev.sectorsize)
+		info->dev.erase_cmd = temp.erase_cmd;
+}
+
 static int jtagspi_probe(struct flash_bank *bank)
 {
 	struct jtagspi_flash_bank *info = bank->driver_priv;
@@ -458,13 +597,21 @@ static int jtagspi_probe(struct flash_bank *bank)
 			break;
 		}
 
-	if (!(p->name)) {
-		LOG_ERROR("Unknown flash device (ID 0x%06" PRIx32 ")", id & 0xFFFFFF);
-		return ERROR_FAIL;
-	}
+	if (p->name) {
+		LOG_INFO("Found flash device \'%s\' (ID 0x%06" PRIx32 ")",
+			info->dev.name, info->dev.device_id & 0xFFFFFF);
 
-	LOG_INFO("Found flash device \'%s\' (ID 0x%06" PRIx32 ")",
-		info->dev.name, info->dev.device_id & 0xFFFFFF);
+		if (info->dev.size_in_bytes > (1UL << 24))
+			jtagspi_probe_4byte_cmds(bank);
+	} else {
+		LOG_INFO("Unknown flash device (ID 0x%06" PRIx32 "), trying SFDP", id & 0xFFFFFF);
+		int retval = spi_sfdp(bank, &info->dev, jtagspi_read_sfdp_block);
+		if (retval != ERROR_OK) {
+			LOG_ERROR("Unknown flash device (ID 0x%06" PRIx32 ")", id & 0xFFFFFF);
+			return ERROR_FAIL;
+		}
+		info->dev.device_id = id;
+	}
 
 	/* Set correct size value */
 	bank->size = info->dev.size_in_bytes;
@@ -478,7 +625,8 @@ static int jtagspi_probe(struct flash_bank *bank)
 		info->addr_len = 3;
 	else {
 		info->addr_len = 4;
-		LOG_WARNING("4-byte addresses needed, might need extra command to enable");
+		if (!jtagspi_4byte_cmds(&info->dev))
+			LOG_WARNING("4-byte addresses needed, might need extra command to enable");
 	}
 
 	/* if no sectors, treat whole bank as single sector */
@@ -501,6 +649,7 @@ static int jtagspi_probe(struct flash_bank *bank)
 	}
 
 	bank->sectors = sectors;
+	info->status_polls = 0;
 	info->probed = true;
 	return ERROR_OK;
 }
@@ -587,16 +736,6 @@ static int jtagspi_bulk_erase(struct flash_bank *bank)
 	return retval;
 }
 
-static uint8_t *fill_addr(uint32_t addr, unsigned int addr_len, uint8_t *buffer)
-{
-	for (buffer += addr_len; addr_len > 0; --addr_len) {
-		*--buffer = addr;
-		addr >>= 8;
-	}
-
-	return buffer;
-}
-
 static int jtagspi_sector_erase(struct flash_bank *bank, unsigned int sector)
 {
 	struct jtagspi_flash_bank *info = bank->driver_priv;
@@ -740,6 +879,141 @@ static int jtagspi_page_write(struct flash_bank *bank, const uint8_t *buffer, ui
 	return jtagspi_wait(bank, JTAGSPI_MAX_TIMEOUT);
 }
 
+/* Number of status reads which cover the typical page program time at the
+ * current adapter speed. Used as initial value, jtagspi_write_batch() adjusts
+ * it to the times actually observed. */
+static unsigned int jtagspi_status_polls(struct flash_bank *bank)
+{
+	struct jtagspi_flash_bank *info = bank->driver_priv;
+	unsigned int khz = adapter_get_speed_khz();
+	uint32_t pprog_time = info->dev.pprog_time ? info->dev.pprog_time : JTAGSPI_DEF_PPROG_TIME;
+
+	/* unknown (e.g. RCLK) speed, start with the maximum */
+	if (khz == 0)
+		return JTAGSPI_MAX_STATUS_POLLS;
+
+	/* IR scan, marker, length, command and status byte, bypass bits and
+	 * about a dozen TCK for TAP state transitions */
+	unsigned int scan_bits = info->tap->ir_length + 1 + 32 + 2 * CHAR_BIT +
+		jtag_tap_count_enabled() + 12;
+	unsigned int scan_us = DIV_ROUND_UP(scan_bits * 1000, khz);
+	unsigned int polls = DIV_ROUND_UP(pprog_time, scan_us);
+
+	return MIN(MAX(polls, 1U), (unsigned int)JTAGSPI_MAX_STATUS_POLLS);
+}
+
+/* Program up to JTAGSPI_BATCH_SIZE bytes with a single JTAG queue flush.
+ * Each page is preceded by write enable and a status read checking WEL,
+ * and followed by info->status_polls status reads in the same queue. A page
+ * is complete if one of those shows the device idle, only if the last one
+ * still has busy set the device is polled until done. *written returns the
+ * number of bytes known to be programmed. */
+static int jtagspi_write_batch(struct flash_bank *bank, const uint8_t *buffer,
+		uint32_t offset, uint32_t count, uint32_t *written)
+{
+	struct jtagspi_flash_bank *info = bank->driver_priv;
+	uint8_t addr[sizeof(uint32_t)];
+	uint32_t pagesize, currsize;
+	int retval = ERROR_OK;
+
+	/* if no write pagesize, use reasonable default */
+	pagesize = info->dev.pagesize ? info->dev.pagesize : SPIFLASH_DEF_PAGESIZE;
+
+	/* ATXP032/064/128 use always 4-byte addresses except for 0x03 read */
+	unsigned int addr_len = ((info->dev.read_cmd != 0x03) && info->always_4byte) ? 4 : info->addr_len;
+
+	const unsigned int polls = info->status_polls;
+	const unsigned int max_pages = MAX(JTAGSPI_BATCH_SIZE / pagesize, 1U);
+	uint8_t *status = malloc(max_pages * (polls + 1));
+	if (!status) {
+		LOG_ERROR("not enough memory");
+		return ERROR_FAIL;
+	}
+
+	if (info->pld_device) {
+		retval = pld_connect_spi_to_jtag(info->pld_device);
+		if (retval != ERROR_OK)
+			goto out;
+	}
+
+	unsigned int pages = 0;
+	for (uint32_t done = 0; done < count && pages < max_pages; pages++) {
+		uint8_t *page_status = status + pages * (polls + 1);
+		uint32_t page_offset = offset + done;
+
+		/* length up to end of current page, but no more than remaining size */
+		currsize = ((page_offset + pagesize) & ~(pagesize - 1)) - page_offset;
+		currsize = MIN(count - done, currsize);
+
+		retval = jtagspi_queue_cmd(bank, SPIFLASH_WRITE_ENABLE, NULL, 0, NULL, 0);
+		if (retval == ERROR_OK)
+			retval = jtagspi_queue_cmd(bank, SPIFLASH_READ_STATUS, NULL, 0, &page_status[0], -1);
+		if (retval == ERROR_OK)
+			retval = jtagspi_queue_cmd(bank, info->dev.pprog_cmd,
+				fill_addr(page_offset, addr_len, addr), addr_len,
+				(uint8_t *)buffer + done, currsize);
+		for (unsigned int i = 1; i <= polls && retval == ERROR_OK; i++)
+			retval = jtagspi_queue_cmd(bank, SPIFLASH_READ_STATUS, NULL, 0, &page_status[i], -1);
+		if (retval != ERROR_OK)
+			goto out;
+
+		done += currsize;
+	}
+
+	retval = jtag_execute_queue();
+	if (retval != ERROR_OK)
+		goto out;
+
+	if (info->pld_device) {
+		retval = pld_disconnect_spi_from_jtag(info->pld_device);
+		if (retval != ERROR_OK)
+			goto out;
+	}
+
+	*written = 0;
+	unsigned int max_ready = 1;
+	for (unsigned int page = 0; page < pages; page++) {
+		uint8_t *page_status = status + page * (polls + 1);
+		uint32_t page_offset = offset + *written;
+
+		flip_u8(page_status, page_status, polls + 1);
+		if ((page_status[0] & SPIFLASH_WE_BIT) == 0) {
+			LOG_ERROR("Cannot enable write to flash. Status=0x%02" PRIx8, page_status[0]);
+			retval = ERROR_FAIL;
+			goto out;
+		}
+
+		unsigned int ready;
+		for (ready = 1; ready <= polls; ready++)
+			if ((page_status[ready] & SPIFLASH_BSY_BIT) == 0)
+				break;
+
+		currsize = ((page_offset + pagesize) & ~(pagesize - 1)) - page_offset;
+		*written += MIN(count - *written, currsize);
+		LOG_DEBUG_IO("wrote page at 0x%08" PRIx32 ", ready after %u status reads",
+			page_offset, ready);
+
+		if (ready > polls) {
+			/* Still busy: subsequent pages of this batch were most likely
+			 * ignored by the device. Wait here and let the caller send them
+			 * again, reprogramming identical data is harmless in case one
+			 * did get through. Queue more status reads from now on. */
+			info->status_polls = MIN(2 * polls, (unsigned int)JTAGSPI_MAX_STATUS_POLLS);
+			LOG_DEBUG("page program exceeded %u status reads", polls);
+			retval = jtagspi_wait(bank, JTAGSPI_MAX_TIMEOUT);
+			goto out;
+		}
+		max_ready = MAX(max_ready, ready);
+	}
+
+	/* drop surplus status reads, but keep some margin */
+	info->status_polls = MIN(max_ready + max_ready / 4 + 1, (unsigned int)JTAGSPI_MAX_STATUS_POLLS);
+
+out:
+	free(status);
+	return retval;
+}
+
 static int jtagspi_write(struct flash_bank *bank, const uint8_t *buffer, uint32_t offset, uint32_t count)
 {
 	struct jtagspi_flash_bank *info = bank->driver_priv;
@@ -751,6 +1025,25 @@ static int jtagspi_write(struct flash_bank *bank, const uint8_t *buffer, uint32_
 		return ERROR_FLASH_BANK_NOT_PROBED;
 	}
 
+	if (info->pipelined) {
+		if (info->status_polls == 0)
+			info->status_polls = jtagspi_status_polls(bank);
+
+		while (count > 0) {
+			uint32_t written = 0;
+			retval = jtagspi_write_batch(bank, buffer, offset, count, &written);
+			if (retval != ERROR_OK) {
+				LOG_ERROR("page write error");
+				return retval;
+			}
+			LOG_DEBUG("wrote 0x%08" PRIx32 " bytes at 0x%08" PRIx32, written, offset);
+			offset += written;
+			buffer += written;
+			count -= written;
+		}
+		return ERROR_OK;
+	}
+
 	/* if no write pagesize, use reasonable default */
 	pagesize = info->dev.pagesize ? info->dev.pagesize : SPIFLASH_DEF_PAGESIZE;
 
@@ -823,6 +1116,13 @@ static const struct command_registration jtagspi_exec_command_handlers[] = {
 		.usage = "bank_id [ on | off ]",
 		.help = "Use always 4-byte address except for basic 0x03.",
 	},
+	{
+		.name = "pipelined",
+		.handler = jtagspi_handle_pipelined,
+		.mode = COMMAND_EXEC,
+		.usage = "bank_id [ on | off ]",
+		.help = "Queue several page programs with their status reads per JTAG flush.",
+	},
 
 	COMMAND_REGISTRATION_DONE
 };
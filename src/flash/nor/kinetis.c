@@ -621,6 +621,8 @@ COMMAND_HANDLER(kinetis_mdm_mass_erase)
 
 	int retval;
 
+	flash_cache_invalidate_all();
+
 	/*
 	 * ... Power on the processor, or if power has already been
 	 * applied, assert the RESET pin to reset the processor. For
@@ -512,6 +512,8 @@ COMMAND_HANDLER(kinetis_ke_mdm_mass_erase)
 
 	/* According to chapter 18.3.7.2 of the KE02 reference manual */
 
+	flash_cache_invalidate_all();
+
 	/* assert SRST */
 	if (jtag_get_reset_config() & RESET_HAS_SRST)
 		adapter_assert_reset();
@@ -511,6 +511,7 @@ COMMAND_HANDLER(msp432_mass_erase_command)
 		all = false;
 	}
 
+	flash_cache_invalidate_all();
 	retval = msp432_mass_erase(bank, all);
 	if (retval != ERROR_OK)
 		return retval;
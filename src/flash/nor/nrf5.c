@@ -1144,8 +1144,9 @@ static int nrf5_ll_flash_write(struct nrf5_info *chip, uint32_t address, const u
 	assert(bytes % 4 == 0);
 
 	/* allocate working area with flash programming code */
-	if (target_alloc_working_area(target, sizeof(nrf5_flash_write_code),
-			&write_algorithm) != ERROR_OK) {
+	retval = target_alloc_working_area_resident(target, nrf5_flash_write_code,
+			sizeof(nrf5_flash_write_code), &write_algorithm);
+	if (retval == ERROR_TARGET_RESOURCE_NOT_AVAILABLE) {
 		LOG_WARNING("no working area available, falling back to slow memory writes");
 
 		for (; bytes > 0; bytes -= 4) {
@@ -1162,25 +1163,17 @@ static int nrf5_ll_flash_write(struct nrf5_info *chip, uint32_t address, const u
 		}
 
 		return ERROR_OK;
-	}
-
-	retval = target_write_buffer(target, write_algorithm->address,
-				sizeof(nrf5_flash_write_code),
-				nrf5_flash_write_code);
-	if (retval != ERROR_OK)
+	} else if (retval != ERROR_OK) {
 		return retval;
+	}
 
 	/* memory buffer */
-	while (target_alloc_working_area(target, buffer_size, &source) != ERROR_OK) {
-		buffer_size /= 2;
-		buffer_size &= ~3UL; /* Make sure it's 4 byte aligned */
-		if (buffer_size <= 256) {
-			/* free working area, write algorithm already allocated */
-			target_free_working_area(target, write_algorithm);
-
-			LOG_WARNING("No large enough working area available, can't do block memory writes");
-			return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
-		}
+	if (target_alloc_working_area_max(target, 256, buffer_size, &source) != ERROR_OK) {
+		/* free working area, write algorithm already allocated */
+		target_free_working_area(target, write_algorithm);
+
+		LOG_WARNING("No large enough working area available, can't do block memory writes");
+		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
 	}
 
 	armv7m_info.common_magic = ARMV7M_COMMON_MAGIC;
@@ -1454,6 +1447,7 @@ COMMAND_HANDLER(nrf5_handle_mass_erase_command)
 		}
 	}
 
+	flash_cache_invalidate_all();
 	res = nrf5_nvmc_erase_enable(chip);
 	if (res != ERROR_OK)
 		goto error;
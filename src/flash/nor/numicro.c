@@ -1204,6 +1204,7 @@ COMMAND_HANDLER(numicro_handle_chip_erase_command)
 	if (retval != ERROR_OK)
 		return retval;
 
+	flash_cache_invalidate_all();
 	retval = numicro_fmc_cmd(target, ISPCMD_CHIPERASE, 0, 0, &rdat);
 	if (retval != ERROR_OK) {
 		command_print(CMD, "numicro chip_erase failed");
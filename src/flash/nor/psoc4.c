@@ -878,6 +878,7 @@ COMMAND_HANDLER(psoc4_handle_mass_erase_command)
 	if (retval != ERROR_OK)
 		return retval;
 
+	flash_cache_invalidate_all();
 	retval = psoc4_mass_erase(bank);
 	if (retval == ERROR_OK)
 		command_print(CMD, "psoc mass erase complete");
@@ -1458,6 +1458,7 @@ COMMAND_HANDLER(psoc5lp_handle_mass_erase_command)
 	if (retval != ERROR_OK)
 		return retval;
 
+	flash_cache_invalidate_all();
 	retval = psoc5lp_spc_erase_all(bank->target);
 	if (retval == ERROR_OK)
 		command_print(CMD, "PSoC 5LP erase succeeded");
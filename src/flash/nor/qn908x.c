@@ -1050,6 +1050,7 @@ COMMAND_HANDLER(qn908x_handle_mass_erase_command)
 	 * only way to unlock a chip when the flash and ram have been locked. */
 	struct target *target = get_current_target(CMD_CTX);
 
+	flash_cache_invalidate_all();
 	retval = qn908x_setup_erase(target);
 	if (retval != ERROR_OK)
 		return retval;
@@ -780,6 +780,7 @@ COMMAND_HANDLER(rsl10_mass_erase_command)
 
 	struct target *target = get_current_target(CMD_CTX);
 
+	flash_cache_invalidate_all();
 	int retval = rsl10_mass_erase(target);
 	if (retval != ERROR_OK)
 		return retval;
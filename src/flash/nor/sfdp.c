@@ -174,6 +174,9 @@ int spi_sfdp(struct flash_bank *bank, struct flash_device *dev,
 			if ((offsetof(struct sfdp_basic_flash_param, chip_byte) >> 2) < words) {
 				/* get Program Page Size, if chip_byte present, that's optional */
 				dev->pagesize = 1UL << ((table->chip_byte >> 4) & 0x0F);
+				/* typical page program time, (count + 1) units of 8 or 64 us */
+				dev->pprog_time = (((table->chip_byte >> 8) & 0x1F) + 1) <<
+					((table->chip_byte & (1UL << 13)) ? 6 : 3);
 			} else {
 				/* no explicit page size specified ... */
 				if (table->fast_addr & (1UL << 2)) {
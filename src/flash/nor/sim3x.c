@@ -953,6 +953,8 @@ COMMAND_HANDLER(sim3x_mass_erase)
 		return ERROR_FAIL;
 	}
 
+	flash_cache_invalidate_all();
+
 	/* Mass erase sequence */
 	ret = ap_write_register(dap, SIM3X_AP_CTRL1, SIM3X_AP_CTRL1_RESET_REQ);
 	if (ret != ERROR_OK)
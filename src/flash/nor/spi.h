@@ -28,6 +28,7 @@ struct flash_device {
 	uint32_t pagesize;
 	uint32_t sectorsize;
 	uint32_t size_in_bytes;
+	uint32_t pprog_time;	/* typical page program time in us, 0 if unknown */
 };
 
 #define FLASH_ID(n, re, qr, pp, es, ces, id, psize, ssize, size) \
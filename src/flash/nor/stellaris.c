@@ -1306,6 +1306,7 @@ COMMAND_HANDLER(stellaris_handle_mass_erase_command)
 	if (retval != ERROR_OK)
 		return retval;
 
+	flash_cache_invalidate_all();
 	if (stellaris_mass_erase(bank) == ERROR_OK)
 		command_print(CMD, "stellaris mass erase complete");
 	else
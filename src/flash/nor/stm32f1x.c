@@ -1658,6 +1658,7 @@ COMMAND_HANDLER(stm32x_handle_mass_erase_command)
 	if (retval != ERROR_OK)
 		return retval;
 
+	flash_cache_invalidate_all();
 	retval = stm32x_mass_erase(bank);
 	if (retval == ERROR_OK)
 		command_print(CMD, "stm32x mass erase complete");
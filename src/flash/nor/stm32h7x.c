@@ -1211,6 +1211,7 @@ COMMAND_HANDLER(stm32h7_handle_mass_erase_command)
 	if (retval != ERROR_OK)
 		return retval;
 
+	flash_cache_invalidate_all();
 	retval = stm32h7_mass_erase(bank);
 	if (retval == ERROR_OK)
 		command_print(CMD, "stm32h7x mass erase complete");
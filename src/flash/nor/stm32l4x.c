@@ -1611,17 +1611,12 @@ static int stm32l4_write_block(struct flash_bank *bank, const uint8_t *buffer,
 #include "../../../contrib/loaders/flash/stm32/stm32l4x.inc"
 	};
 
-	if (target_alloc_working_area(target, sizeof(stm32l4_flash_write_code),
-			&write_algorithm) != ERROR_OK) {
+	retval = target_alloc_working_area_resident(target, stm32l4_flash_write_code,
+			sizeof(stm32l4_flash_write_code), &write_algorithm);
+	if (retval == ERROR_TARGET_RESOURCE_NOT_AVAILABLE) {
 		LOG_WARNING("no working area available, can't do block memory writes");
 		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
-	}
-
-	retval = target_write_buffer(target, write_algorithm->address,
-			sizeof(stm32l4_flash_write_code),
-			stm32l4_flash_write_code);
-	if (retval != ERROR_OK) {
-		target_free_working_area(target, write_algorithm);
+	} else if (retval != ERROR_OK) {
 		return retval;
 	}
 
@@ -1643,6 +1638,7 @@ static int stm32l4_write_block(struct flash_bank *bank, const uint8_t *buffer,
 
 	if (target_alloc_working_area_try(target, buffer_size + extra_size, &source) != ERROR_OK) {
 		LOG_ERROR("allocating working area failed");
+		target_free_working_area(target, write_algorithm);
 		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
 	}
 
@@ -2468,6 +2464,7 @@ COMMAND_HANDLER(stm32l4_handle_mass_erase_command)
 	if (retval != ERROR_OK)
 		return retval;
 
+	flash_cache_invalidate_all();
 	retval = stm32l4_mass_erase(bank);
 	if (retval == ERROR_OK)
 		command_print(CMD, "stm32l4x mass erase complete");
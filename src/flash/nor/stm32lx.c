@@ -306,6 +306,7 @@ COMMAND_HANDLER(stm32lx_handle_mass_erase_command)
 	if (retval != ERROR_OK)
 		return retval;
 
+	flash_cache_invalidate_all();
 	retval = stm32lx_mass_erase(bank);
 	if (retval == ERROR_OK)
 		command_print(CMD, "stm32lx mass erase complete");
@@ -527,6 +527,7 @@ COMMAND_HANDLER(stmqspi_handle_mass_erase_command)
 		}
 	}
 
+	flash_cache_invalidate_all();
 	io_base = stmqspi_info->io_base;
 	duration_start(&bench);
 
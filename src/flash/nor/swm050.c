@@ -134,6 +134,7 @@ COMMAND_HANDLER(swm050_handle_mass_erase_command)
 	if (retval != ERROR_OK)
 		return retval;
 
+	flash_cache_invalidate_all();
 	retval = swm050_mass_erase(bank);
 	if (retval == ERROR_OK)
 		command_print(CMD, "swm050 mass erase complete");
@@ -188,9 +188,10 @@ COMMAND_HANDLER(handle_flash_erase_check_command)
 		return retval;
 
 	retval = p->driver->erase_check(p);
-	if (retval == ERROR_OK)
+	if (retval == ERROR_OK) {
+		flash_blank_cache_update(p);
 		command_print(CMD, "successfully checked erase state");
-	else {
+	} else {
 		command_print(CMD,
 			"Error: checking erase state of flash bank #%s at "
 			TARGET_ADDR_FMT,
@@ -1192,6 +1193,44 @@ COMMAND_HANDLER(handle_flash_padded_value_command)
 	return retval;
 }
 
+COMMAND_HANDLER(handle_flash_erase_skip_blank_command)
+{
+	if (CMD_ARGC < 1 || CMD_ARGC > 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	struct flash_bank *p;
+	int retval = CALL_COMMAND_HANDLER(flash_command_get_bank, 0, &p);
+	if (retval != ERROR_OK)
+		return retval;
+
+	if (CMD_ARGC == 2)
+		COMMAND_PARSE_ON_OFF(CMD_ARGV[1], p->erase_skip_blank);
+
+	command_print(CMD, "erase of blank sectors is %s for flash bank %u",
+			p->erase_skip_blank ? "skipped" : "not skipped", p->bank_number);
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_flash_shadow_command)
+{
+	if (CMD_ARGC < 1 || CMD_ARGC > 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	struct flash_bank *p;
+	int retval = CALL_COMMAND_HANDLER(flash_command_get_bank, 0, &p);
+	if (retval != ERROR_OK)
+		return retval;
+
+	if (CMD_ARGC == 2)
+		COMMAND_PARSE_ON_OFF(CMD_ARGV[1], p->shadow_enabled);
+
+	command_print(CMD, "flash bank %u shadow is %s", p->bank_number,
+			p->shadow_enabled ? "enabled" : "disabled");
+
+	return ERROR_OK;
+}
+
 static const struct command_registration flash_exec_command_handlers[] = {
 	{
 		.name = "probe",
@@ -1355,6 +1394,22 @@ static const struct command_registration flash_exec_command_handlers[] = {
 		.usage = "bank_id value",
 		.help = "Set default flash padded value",
 	},
+	{
+		.name = "erase_skip_blank",
+		.handler = handle_flash_erase_skip_blank_command,
+		.mode = COMMAND_EXEC,
+		.usage = "bank_id ['on'|'off']",
+		.help = "Trust blank checks and skip erasing blank sectors "
+			"in 'write_image erase'",
+	},
+	{
+		.name = "shadow",
+		.handler = handle_flash_shadow_command,
+		.mode = COMMAND_EXEC,
+		.usage = "bank_id ['on'|'off']",
+		.help = "Keep a host copy of the flash bank to serve reads "
+			"and verifies while the target is halted",
+	},
 	COMMAND_REGISTRATION_DONE
 };
 
@@ -1488,7 +1543,14 @@ COMMAND_HANDLER(handle_flash_init_command)
 	flash_initialized = true;
 
 	LOG_DEBUG("Initializing flash devices...");
-	return flash_init_drivers(CMD_CTX);
+	int retval = flash_init_drivers(CMD_CTX);
+	if (retval != ERROR_OK)
+		return retval;
+
+	if (!flash_bank_list())
+		return ERROR_OK;
+
+	return flash_background_probe_start();
 }
 
 static const struct command_registration flash_config_command_handlers[] = {
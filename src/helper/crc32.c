@@ -13,6 +13,7 @@
 #endif
 
 #include "crc32.h"
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 
@@ -30,21 +31,31 @@ static uint32_t crc_le_step(uint32_t poly, uint32_t crc, uint32_t data_in,
 	return crc;
 }
 
+/* Byte-wise lookup table for the polynomial used last, built on demand */
+static uint32_t crc_le_table[256];
+static uint32_t crc_le_table_poly;
+static bool crc_le_table_valid;
+
+static const uint32_t *crc_le_get_table(uint32_t poly)
+{
+	if (!crc_le_table_valid || crc_le_table_poly != poly) {
+		for (unsigned int i = 0; i < 256; i++)
+			crc_le_table[i] = crc_le_step(poly, i, 0, 8);
+		crc_le_table_poly = poly;
+		crc_le_table_valid = true;
+	}
+
+	return crc_le_table;
+}
+
 uint32_t crc32_le(uint32_t poly, uint32_t seed, const void *_data,
 		size_t data_len)
 {
-	if (((uintptr_t)_data & 0x3) || (data_len & 0x3)) {
-		/* data is unaligned, processing data one byte at a time */
-		const uint8_t *data = _data;
-		for (size_t i = 0; i < data_len; i++)
-			seed = crc_le_step(poly, seed, data[i], 8);
-	} else {
-		/* data is aligned, processing 32 bit at a time */
-		data_len >>= 2;
-		const uint32_t *data = _data;
-		for (size_t i = 0; i < data_len; i++)
-			seed = crc_le_step(poly, seed, data[i], 32);
-	}
+	const uint32_t *table = crc_le_get_table(poly);
+	const uint8_t *data = _data;
+
+	for (size_t i = 0; i < data_len; i++)
+		seed = table[(seed ^ data[i]) & 0xff] ^ (seed >> 8);
 
 	return seed;
 }
@@ -37,6 +37,9 @@ static int64_t last_time;
 
 static int64_t start;
 
+/* time of the last flush of a log file, see log_output_flush() */
+static int64_t last_flush;
+
 static const char * const log_strings[7] = {
 	"User : ",
 	"Error: ",
@@ -49,6 +52,12 @@ static const char * const log_strings[7] = {
 
 static unsigned int count;
 
+/* Messages shorter than this are formatted on the stack */
+#define LOG_BUF_SIZE 256
+
+/* Debug output to a log file is flushed at most this often */
+#define LOG_FLUSH_INTERVAL_MS 100
+
 /* forward the log to the listeners */
 static void log_forward(const char *file, unsigned int line, const char *function, const char *string)
 {
@@ -88,6 +97,65 @@ static void get_free_memory_space(char *s)
 	*s = 0;
 }
 
+/*
+ * Flushing after every line makes -d3 and LOG_DEBUG_IO output to a file
+ * very slow. Let stdio buffer debug messages and flush them periodically,
+ * but make anything the user is meant to see available right away.
+ */
+static void log_output_flush(enum log_levels level)
+{
+	int64_t now = timeval_ms();
+
+	if (level <= LOG_LVL_INFO || now - last_flush >= LOG_FLUSH_INTERVAL_MS) {
+		fflush(log_output);
+		last_flush = now;
+	}
+}
+
+/* Write out debug output still buffered for the log file */
+void log_flush(void)
+{
+	if (!log_output)
+		return;
+
+	fflush(log_output);
+	last_flush = timeval_ms();
+}
+
+/*
+ * Format a message into @a buf if it fits, which is the common case, and
+ * only fall back to a heap allocation for long messages. A newline is
+ * appended when @a lf is set. The caller must free() the result if it
+ * differs from @a buf.
+ */
+static char *log_vformat(char *buf, size_t size, bool lf, const char *format, va_list args)
+{
+	va_list ap;
+
+	va_copy(ap, args);
+	int len = vsnprintf(buf, size, format, ap);
+	va_end(ap);
+
+	if (len < 0)
+		return NULL;
+
+	char *string = buf;
+	if ((size_t)len + 1 >= size) {
+		string = alloc_vprintf(format, args);
+		if (!string)
+			return NULL;
+	}
+
+	/*
+	 * Note: alloc_vprintf() guarantees that the buffer is at least one
+	 * character longer.
+	 */
+	if (lf)
+		strcat(string, "\n");
+
+	return string;
+}
+
 /* The log_puts() serves two somewhat different goals:
  *
  * - logging
@@ -116,7 +184,7 @@ static void log_puts(enum log_levels level,
 	if (level == LOG_LVL_OUTPUT) {
 		/* do not prepend any headers, just print out what we were given and return */
 		fputs(string, log_output);
-		fflush(log_output);
+		log_output_flush(level);
 		return;
 	}
 
@@ -141,7 +209,7 @@ static void log_puts(enum log_levels level,
 			(level > LOG_LVL_USER) ? log_strings[level + 1] : "", string);
 	}
 
-	fflush(log_output);
+	log_output_flush(level);
 
 	/* Never forward LOG_LVL_DEBUG, too verbose and they can be found in the log if need be */
 	if (level <= LOG_LVL_INFO)
@@ -155,6 +223,7 @@ void log_printf(enum log_levels level,
 	const char *format,
 	...)
 {
+	char buf[LOG_BUF_SIZE];
 	char *string;
 	va_list ap;
 
@@ -165,10 +234,11 @@ void log_printf(enum log_levels level,
 
 	va_start(ap, format);
 
-	string = alloc_vprintf(format, ap);
+	string = log_vformat(buf, sizeof(buf), false, format, ap);
 	if (string) {
 		log_puts(level, file, line, function, string);
-		free(string);
+		if (string != buf)
+			free(string);
 	}
 
 	va_end(ap);
@@ -177,6 +247,7 @@ void log_printf(enum log_levels level,
 void log_vprintf_lf(enum log_levels level, const char *file, unsigned int line,
 		const char *function, const char *format, va_list args)
 {
+	char buf[LOG_BUF_SIZE];
 	char *tmp;
 
 	if (level > debug_level)
@@ -184,18 +255,13 @@ void log_vprintf_lf(enum log_levels level, const char *file, unsigned int line,
 
 	count++;
 
-	tmp = alloc_vprintf(format, args);
-
+	tmp = log_vformat(buf, sizeof(buf), true, format, args);
 	if (!tmp)
 		return;
 
-	/*
-	 * Note: alloc_vprintf() guarantees that the buffer is at least one
-	 * character longer.
-	 */
-	strcat(tmp, "\n");
 	log_puts(level, file, line, function, tmp);
-	free(tmp);
+	if (tmp != buf)
+		free(tmp);
 }
 
 void log_printf_lf(enum log_levels level,
@@ -445,6 +511,10 @@ void keep_alive(void)
 		gdb_timeout_warning(delta_time);
 	}
 
+	/* don't let buffered debug output lag behind during long operations */
+	if (current_time - last_flush >= LOG_FLUSH_INTERVAL_MS)
+		log_flush();
+
 	if (delta_time > KEEP_ALIVE_KICK_TIME_MS) {
 		last_time = current_time;
 
@@ -74,6 +74,7 @@ __attribute__ ((format (PRINTF_ATTRIBUTE_FORMAT, 5, 6)));
  */
 void log_init(void);
 void log_exit(void);
+void log_flush(void);
 
 int log_register_commands(struct command_context *cmd_ctx);
 
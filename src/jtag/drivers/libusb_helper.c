@@ -22,6 +22,13 @@
  */
 #define MAX_USB_PORTS	7
 
+/* Granularity of the event loop while a bulk transfer is in flight; must stay
+ * well below KEEP_ALIVE_KICK_TIME_MS so that gdb does not time out */
+#define JTAG_LIBUSB_POLL_MS	100
+
+/* Event loop rounds to wait for a cancelled transfer to be given back */
+#define JTAG_LIBUSB_CANCEL_RETRIES	10
+
 static struct libusb_context *jtag_libusb_context; /**< Libusb context **/
 static struct libusb_device **devs; /**< The usb device list **/
 
@@ -246,6 +253,89 @@ int jtag_libusb_control_transfer(struct libusb_device_handle *dev, uint8_t reque
 	return ERROR_OK;
 }
 
+static LIBUSB_CALL void jtag_libusb_transfer_cb(struct libusb_transfer *transfer)
+{
+	int *completed = transfer->user_data;
+
+	*completed = 1;
+}
+
+static int jtag_libusb_transfer_status(enum libusb_transfer_status status)
+{
+	switch (status) {
+	case LIBUSB_TRANSFER_COMPLETED:
+		return LIBUSB_SUCCESS;
+	case LIBUSB_TRANSFER_TIMED_OUT:
+		return LIBUSB_ERROR_TIMEOUT;
+	case LIBUSB_TRANSFER_STALL:
+		return LIBUSB_ERROR_PIPE;
+	case LIBUSB_TRANSFER_OVERFLOW:
+		return LIBUSB_ERROR_OVERFLOW;
+	case LIBUSB_TRANSFER_NO_DEVICE:
+		return LIBUSB_ERROR_NO_DEVICE;
+	default:
+		return LIBUSB_ERROR_IO;
+	}
+}
+
+/**
+ * Equivalent of libusb_bulk_transfer() that does not block the caller for
+ * the whole timeout: libusb events are handled in short slices and
+ * keep_alive() runs in between, so gdb does not time out while a slow
+ * adapter works through a long transfer.
+ */
+static int jtag_libusb_bulk_transfer(struct libusb_device_handle *dev, int ep,
+		char *bytes, int size, int timeout, int *transferred)
+{
+	struct libusb_transfer *transfer = libusb_alloc_transfer(0);
+	if (!transfer)
+		return LIBUSB_ERROR_NO_MEM;
+
+	int completed = 0;
+	libusb_fill_bulk_transfer(transfer, dev, ep, (unsigned char *)bytes, size,
+		jtag_libusb_transfer_cb, &completed, timeout);
+
+	int ret = libusb_submit_transfer(transfer);
+	if (ret != LIBUSB_SUCCESS) {
+		libusb_free_transfer(transfer);
+		return ret;
+	}
+
+	int error = LIBUSB_SUCCESS;
+	unsigned int retries = 0;
+
+	while (!completed) {
+		struct timeval tv = {
+			.tv_sec = 0,
+			.tv_usec = JTAG_LIBUSB_POLL_MS * 1000,
+		};
+
+		ret = libusb_handle_events_timeout_completed(jtag_libusb_context, &tv, &completed);
+		keep_alive();
+
+		if (error == LIBUSB_SUCCESS) {
+			if (ret == LIBUSB_SUCCESS || ret == LIBUSB_ERROR_INTERRUPTED)
+				continue;
+
+			error = ret;
+			libusb_cancel_transfer(transfer);
+		}
+
+		if (!completed && ++retries > JTAG_LIBUSB_CANCEL_RETRIES) {
+			/* libusb still owns the transfer, it can't be released */
+			LOG_ERROR("libusb transfer cancel did not complete: %s",
+				libusb_error_name(error));
+			return error;
+		}
+	}
+
+	*transferred = transfer->actual_length;
+	ret = jtag_libusb_transfer_status(transfer->status);
+	libusb_free_transfer(transfer);
+
+	return error != LIBUSB_SUCCESS ? error : ret;
+}
+
 int jtag_libusb_bulk_write(struct libusb_device_handle *dev, int ep, char *bytes,
 			   int size, int timeout, int *transferred)
 {
@@ -253,8 +343,7 @@ int jtag_libusb_bulk_write(struct libusb_device_handle *dev, int ep, char *bytes
 
 	*transferred = 0;
 
-	ret = libusb_bulk_transfer(dev, ep, (unsigned char *)bytes, size,
-				   transferred, timeout);
+	ret = jtag_libusb_bulk_transfer(dev, ep, bytes, size, timeout, transferred);
 	if (ret != LIBUSB_SUCCESS) {
 		LOG_ERROR("libusb_bulk_write error: %s", libusb_error_name(ret));
 		return jtag_libusb_error(ret);
@@ -270,8 +359,7 @@ int jtag_libusb_bulk_read(struct libusb_device_handle *dev, int ep, char *bytes,
 
 	*transferred = 0;
 
-	ret = libusb_bulk_transfer(dev, ep, (unsigned char *)bytes, size,
-				   transferred, timeout);
+	ret = jtag_libusb_bulk_transfer(dev, ep, bytes, size, timeout, transferred);
 	if (ret != LIBUSB_SUCCESS) {
 		LOG_ERROR("libusb_bulk_read error: %s", libusb_error_name(ret));
 		return jtag_libusb_error(ret);
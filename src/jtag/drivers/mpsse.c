@@ -898,8 +898,9 @@ int mpsse_flush(struct mpsse_ctx *ctx)
 	while (!write_result.done || !read_result.done) {
 		struct timeval timeout_usb;
 
-		timeout_usb.tv_sec = 1;
-		timeout_usb.tv_usec = 0;
+		/* wake up often enough for keep_alive() to meet its deadline */
+		timeout_usb.tv_sec = 0;
+		timeout_usb.tv_usec = 100000;
 
 		retval = libusb_handle_events_timeout_completed(ctx->usb_ctx, &timeout_usb, NULL);
 		keep_alive();
@@ -86,6 +86,13 @@
  */
 #define BUF_LEN 4096
 
+/*
+ * Number of TDO bytes that may be requested from the dongle before they are
+ * read back. It must stay below the read FIFO of the FT245 (384 bytes), else
+ * the dongle stops accepting writes while waiting for us to read.
+ */
+#define MAX_PENDING_TDO 256
+
 /* USB-Blaster II specific command */
 #define CMD_COPY_TDO_BUFFER	0x5F
 
@@ -96,6 +103,22 @@ enum gpio_steer {
 	TRST,
 };
 
+/*
+ * TDO requested from the dongle but not read back yet: either len bytes of a
+ * byte-shift transfer, or len bits clocked in bitbang mode, one byte each.
+ */
+struct ublast_tdo_read {
+	uint8_t *dest;
+	unsigned int len;
+	bool bitbang;
+};
+
+/* Scan whose captured bits are only complete once pending TDOs are read */
+struct ublast_deferred_scan {
+	struct scan_command *cmd;
+	uint8_t *buf;
+};
+
 struct ublast_info {
 	enum gpio_steer pin6;
 	enum gpio_steer pin8;
@@ -106,6 +129,12 @@ struct ublast_info {
 	uint8_t buf[BUF_LEN];
 	int bufidx;
 
+	struct ublast_tdo_read tdo_reads[MAX_PENDING_TDO];
+	unsigned int nb_tdo_reads;
+	unsigned int tdo_pending;
+	struct ublast_deferred_scan scans[MAX_PENDING_TDO];
+	unsigned int nb_scans;
+
 	char *lowlevel_name;
 	struct ublast_lowlevel *drv;
 	uint16_t ublast_vid, ublast_pid;
@@ -510,70 +539,78 @@ static void ublast_state_move(enum tap_state state, int skip)
 }
 
 /**
- * ublast_read_byteshifted_tdos - read TDO of byteshift writes
- * @param buf the buffer to store the bits
- * @param nb_bytes the number of bytes
- *
- * Reads back from USB Blaster TDO bits, triggered by a 'byteshift write', ie. eight
- * bits per received byte from USB interface, and store them in buffer.
- *
- * As the USB blaster stores the TDO bits in LSB (ie. first bit in (byte0,
- * bit0), second bit in (byte0, bit1), ...), which is what we want to return,
- * simply read bytes from USB interface and store them.
+ * ublast_queue_tdo_read - record TDO to be read back later
+ * @param dest where the TDO bits are to be stored
+ * @param len number of bytes (byte-shift mode) or bits (bitbang mode)
+ * @param bitbang true if TDO was requested in bitbang mode
  *
- * Returns ERROR_OK if OK, ERROR_xxx if a read error occurred
+ * The dongle answers with one byte per 8 bits in byte-shift mode, and with
+ * one byte per bit in bitbang mode.
  */
-static int ublast_read_byteshifted_tdos(uint8_t *buf, int nb_bytes)
+static void ublast_queue_tdo_read(uint8_t *dest, unsigned int len, bool bitbang)
 {
-	uint32_t retlen;
-	int ret = ERROR_OK;
+	if (!len)
+		return;
 
-	LOG_DEBUG_IO("%s(buf=%p, num_bits=%d)", __func__, buf, nb_bytes * 8);
-	ublast_flush_buffer();
-	while (ret == ERROR_OK && nb_bytes > 0) {
-		ret = ublast_buf_read(buf, nb_bytes, &retlen);
-		nb_bytes -= retlen;
-	}
-	return ret;
+	struct ublast_tdo_read *rd = &info.tdo_reads[info.nb_tdo_reads++];
+	rd->dest = dest;
+	rd->len = len;
+	rd->bitbang = bitbang;
+	info.tdo_pending += len;
 }
 
 /**
- * ublast_read_bitbang_tdos - read TDO of bitbang writes
- * @param buf the buffer to store the bits
- * @param nb_bits the number of bits
+ * ublast_read_pending_tdos - read back all requested TDO
  *
- * Reads back from USB Blaster TDO bits, triggered by a 'bitbang write', ie. one
- * bit per received byte from USB interface, and store them in buffer, where :
- *  - first bit is stored in byte0, bit0 (LSB)
- *  - second bit is stored in byte0, bit 1
- *  ...
- *  - eight bit is stored in byte0, bit 7
- *  - ninth bit is stored in byte1, bit 0
- *  - etc ...
+ * Writes out the queued bytes, reads the TDO of every pending byte-shift and
+ * bitbang transfer in one go and stores it where requested, as the USB
+ * Blaster returns TDO bits LSB first, ie. first bit in (byte0, bit0). Then
+ * completes the scans waiting for these TDOs.
  *
  * Returns ERROR_OK if OK, ERROR_xxx if a read error occurred
  */
-static int ublast_read_bitbang_tdos(uint8_t *buf, int nb_bits)
+static int ublast_read_pending_tdos(void)
 {
-	int nb1 = nb_bits;
-	int i, ret = ERROR_OK;
+	uint8_t tdos[MAX_PENDING_TDO];
+	unsigned int nb_bytes = info.tdo_pending, got = 0;
 	uint32_t retlen;
-	uint8_t tmp[8];
-
-	LOG_DEBUG_IO("%s(buf=%p, num_bits=%d)", __func__, buf, nb_bits);
+	int ret = ERROR_OK;
 
-	/*
-	 * Ensure all previous bitbang writes were issued to the dongle, so that
-	 * it returns back the read values.
-	 */
 	ublast_flush_buffer();
 
-	ret = ublast_buf_read(tmp, nb1, &retlen);
-	for (i = 0; ret == ERROR_OK && i < nb1; i++)
-		if (tmp[i] & READ_TDO)
-			*buf |= (1 << i);
-		else
-			*buf &= ~(1 << i);
+	LOG_DEBUG_IO("%s(reads=%u, bytes=%u)", __func__, info.nb_tdo_reads, nb_bytes);
+	while (ret == ERROR_OK && got < nb_bytes) {
+		ret = ublast_buf_read(&tdos[got], nb_bytes - got, &retlen);
+		got += retlen;
+	}
+
+	const uint8_t *src = tdos;
+	for (unsigned int i = 0; ret == ERROR_OK && i < info.nb_tdo_reads; i++) {
+		struct ublast_tdo_read *rd = &info.tdo_reads[i];
+
+		if (!rd->bitbang) {
+			memcpy(rd->dest, src, rd->len);
+		} else {
+			for (unsigned int bit = 0; bit < rd->len; bit++)
+				if (src[bit] & READ_TDO)
+					*rd->dest |= (1 << bit);
+				else
+					*rd->dest &= ~(1 << bit);
+		}
+		src += rd->len;
+	}
+	info.nb_tdo_reads = 0;
+	info.tdo_pending = 0;
+
+	for (unsigned int i = 0; i < info.nb_scans; i++) {
+		struct ublast_deferred_scan *scan = &info.scans[i];
+
+		if (ret == ERROR_OK)
+			ret = jtag_read_buffer(scan->buf, scan->cmd);
+		free(scan->buf);
+	}
+	info.nb_scans = 0;
+
 	return ret;
 }
 
@@ -587,8 +624,9 @@ static int ublast_read_bitbang_tdos(uint8_t *buf, int nb_bits)
  * As a side effect, the last TDI bit is sent along a TMS=1, and triggers a JTAG
  * TAP state shift if input bits were non NULL.
  *
- * In order to not saturate the USB Blaster queues, this method reads back TDO
- * if the scan type requests it, and stores them back in bits.
+ * If the scan type requests it, TDO is stored back in bits once read, which
+ * happens when too much TDO is pending for the USB Blaster queues, or at the
+ * latest when the JTAG queue is executed. Bits must stay valid until then.
  *
  * As a side note, the state of TCK when entering this function *must* be
  * low. This is because byteshift mode outputs TDI on rising TCK and reads TDO
@@ -596,12 +634,12 @@ static int ublast_read_bitbang_tdos(uint8_t *buf, int nb_bits)
  * If TCK was high, the USB blaster will queue TDI on falling edge, and read TDO
  * on rising edge !!!
  */
-static void ublast_queue_tdi(uint8_t *bits, int nb_bits, enum scan_type scan)
+static int ublast_queue_tdi(uint8_t *bits, int nb_bits, enum scan_type scan)
 {
 	int nb8 = nb_bits / 8;
 	int nb1 = nb_bits % 8;
 	int nbfree_in_packet, i, trans = 0, read_tdos;
-	uint8_t *tdos = calloc(1, nb_bits / 8 + 1);
+	int ret = ERROR_OK;
 	static uint8_t byte0[BUF_LEN];
 
 	/*
@@ -626,6 +664,13 @@ static void ublast_queue_tdi(uint8_t *bits, int nb_bits, enum scan_type scan)
 		nbfree_in_packet = (MAX_PACKET_SIZE - (info.bufidx%MAX_PACKET_SIZE));
 		trans = MIN(nbfree_in_packet - 1, nb8 - i);
 
+		if (read_tdos && info.tdo_pending + trans > MAX_PENDING_TDO) {
+			ret = ublast_read_pending_tdos();
+			if (ret != ERROR_OK)
+				return ret;
+			trans = MIN(MAX_PACKET_SIZE - 1, nb8 - i);
+		}
+
 		/*
 		 * Queue a byte-shift mode transmission, with as many bytes as
 		 * is possible with regard to :
@@ -643,10 +688,16 @@ static void ublast_queue_tdi(uint8_t *bits, int nb_bits, enum scan_type scan)
 		if (read_tdos) {
 			if (info.flags & COPY_TDO_BUFFER)
 				ublast_queue_byte(CMD_COPY_TDO_BUFFER);
-			ublast_read_byteshifted_tdos(&tdos[i], trans);
+			ublast_queue_tdo_read(&bits[i], trans, false);
 		}
 	}
 
+	if (nb1 && read_tdos && info.tdo_pending + nb1 > MAX_PENDING_TDO) {
+		ret = ublast_read_pending_tdos();
+		if (ret != ERROR_OK)
+			return ret;
+	}
+
 	/*
 	 * Queue the remaining TDI bits in bitbang mode.
 	 */
@@ -660,17 +711,14 @@ static void ublast_queue_tdi(uint8_t *bits, int nb_bits, enum scan_type scan)
 	if (nb1 && read_tdos) {
 		if (info.flags & COPY_TDO_BUFFER)
 			ublast_queue_byte(CMD_COPY_TDO_BUFFER);
-		ublast_read_bitbang_tdos(&tdos[nb8], nb1);
+		ublast_queue_tdo_read(&bits[nb8], nb1, true);
 	}
 
-	if (bits)
-		memcpy(bits, tdos, DIV_ROUND_UP(nb_bits, 8));
-	free(tdos);
-
 	/*
 	 * Ensure clock is in lower state
 	 */
 	ublast_idle_clock();
+	return ret;
 }
 
 static void ublast_runtest(unsigned int num_cycles, enum tap_state state)
@@ -720,10 +768,20 @@ static int ublast_scan(struct scan_command *cmd)
 		  scan_bits, log_buf, cmd->end_state);
 	free(log_buf);
 
-	ublast_queue_tdi(buf, scan_bits, type);
+	ret = ublast_queue_tdi(buf, scan_bits, type);
+	if (ret != ERROR_OK) {
+		free(buf);
+		return ret;
+	}
 
-	ret = jtag_read_buffer(buf, cmd);
-	free(buf);
+	/* Captured bits are handed over once their TDO is read back */
+	if (type == SCAN_OUT) {
+		free(buf);
+	} else {
+		info.scans[info.nb_scans].cmd = cmd;
+		info.scans[info.nb_scans].buf = buf;
+		info.nb_scans++;
+	}
 	/*
 	 * ublast_queue_tdi sends the last bit with TMS=1. We are therefore
 	 * already in Exit1-DR/IR and have to skip the first step on our way
@@ -810,7 +868,9 @@ static int ublast_execute_queue(struct jtag_command *cmd_queue)
 		}
 	}
 
-	ublast_flush_buffer();
+	int retval = ublast_read_pending_tdos();
+	if (ret == ERROR_OK)
+		ret = retval;
 	return ret;
 }
 
@@ -36,7 +36,7 @@ struct target *hwthread_swbp_target(struct rtos *rtos, target_addr_t address,
 
 static inline threadid_t threadid_from_target(const struct target *target)
 {
-	if (!target->smp)
+	if (!target_smp_threads(target))
 		return 1;
 
 	threadid_t threadid = 1;
@@ -107,7 +107,7 @@ static int hwthread_update_threads(struct rtos *rtos)
 	rtos_free_threadlist(rtos);
 
 	/* determine the number of "threads" */
-	if (target->smp) {
+	if (target_smp_threads(target)) {
 		foreach_smp_target(head, target->smp_targets) {
 			struct target *curr = head->target;
 
@@ -132,7 +132,7 @@ static int hwthread_update_threads(struct rtos *rtos)
 	/* create space for new thread details */
 	rtos->thread_details = malloc(sizeof(struct thread_detail) * thread_list_size);
 
-	if (target->smp) {
+	if (target_smp_threads(target)) {
 		/* loop over all threads */
 		foreach_smp_target(head, target->smp_targets) {
 			struct target *curr = head->target;
@@ -225,7 +225,7 @@ static int hwthread_smp_init(struct target *target)
 static struct target *hwthread_find_thread(struct target *target, threadid_t thread_id)
 {
 	/* Find the thread with that thread_id (index in SMP group plus 1)*/
-	if (!(target && target->smp))
+	if (!(target && target_smp_threads(target)))
 		return target;
 	struct target_list *head;
 	threadid_t tid = 1;
@@ -10,6 +10,7 @@
 #include "config.h"
 #endif
 
+#include <helper/align.h>
 #include <helper/time_support.h>
 #include <jtag/jtag.h>
 #include "target/target.h"
@@ -26,6 +27,9 @@
 #include "linux_header.h"
 #define PHYS
 #define MAX_THREADS 200
+/*  task_struct is read as one block, from state up to the end of comm  */
+#define TASK_BLOCK_SIZE \
+	ALIGN_UP(MAX(MAX(MAX(NEXT, MEM), MAX(ONCPU, PID)) + 4, COMM + 16), 4)
 /*  specific task  */
 struct linux_os {
 	const char *name;
@@ -60,6 +64,7 @@ struct threads {
 	uint32_t pid;		/* linux pid : id for identifying a thread */
 	uint32_t oncpu;		/* content cpu number in current thread */
 	uint32_t asid;		/*  filled only at creation  */
+	uint32_t next_base;	/*  base_addr of the next task, from tasks.next  */
 	int64_t threadid;
 	int status;		/* dead = 1 alive = 2 current = 3 alive and current */
 	/*  value that should not change during the live of a thread ? */
@@ -282,58 +287,35 @@ int fill_task_pid(struct target *target, struct threads *t)
 
 static int fill_task(struct target *target, struct threads *t)
 {
-	int retval;
-	uint32_t pid_addr = t->base_addr + PID;
-	uint32_t mem_addr = t->base_addr + MEM;
-	uint32_t on_cpu = t->base_addr + ONCPU;
-	uint8_t *buffer = calloc(1, 4);
-	retval = fill_buffer(target, t->base_addr, buffer);
-
-	if (retval == ERROR_OK) {
-		uint32_t val = get_buffer(target, buffer);
-		t->state = val;
-	} else
-		LOG_ERROR("fill_task: unable to read memory");
-
-	retval = fill_buffer(target, pid_addr, buffer);
-
-	if (retval == ERROR_OK) {
-		uint32_t val = get_buffer(target, buffer);
-		t->pid = val;
-	} else
-		LOG_ERROR("fill task: unable to read memory");
-
-	retval = fill_buffer(target, on_cpu, buffer);
+	uint8_t block[TASK_BLOCK_SIZE];
+	int retval = linux_read_memory(target, t->base_addr, 4,
+			TASK_BLOCK_SIZE / 4, block);
 
-	if (retval == ERROR_OK) {
-		uint32_t val = get_buffer(target, buffer);
-		t->oncpu = val;
-	} else
+	if (retval != ERROR_OK) {
 		LOG_ERROR("fill task: unable to read memory");
+		return retval;
+	}
 
-	retval = fill_buffer(target, mem_addr, buffer);
-
-	if (retval == ERROR_OK) {
-		uint32_t val = get_buffer(target, buffer);
+	t->state = get_buffer(target, block);
+	t->pid = get_buffer(target, block + PID);
+	t->oncpu = get_buffer(target, block + ONCPU);
+	t->next_base = get_buffer(target, block + NEXT) - NEXT;
+	memcpy(t->name, block + COMM, 16);
+	t->name[16] = 0;
 
-		if (val != 0) {
-			uint32_t asid_addr = val + MM_CTX;
-			retval = fill_buffer(target, asid_addr, buffer);
+	uint32_t mm = get_buffer(target, block + MEM);
+	t->asid = 0;
 
-			if (retval == ERROR_OK) {
-				val = get_buffer(target, buffer);
-				t->asid = val;
-			} else
-				LOG_ERROR
-					("fill task: unable to read memory -- ASID");
-		} else
-			t->asid = 0;
-	} else
-		LOG_ERROR("fill task: unable to read memory");
+	if (mm != 0) {
+		uint8_t buffer[4];
 
-	free(buffer);
+		if (fill_buffer(target, mm + MM_CTX, buffer) == ERROR_OK)
+			t->asid = get_buffer(target, buffer);
+		else
+			LOG_ERROR("fill task: unable to read memory -- ASID");
+	}
 
-	return retval;
+	return ERROR_OK;
 }
 
 static int get_name(struct target *target, struct threads *t)
@@ -445,7 +427,6 @@ static int get_current(struct target *target, int create)
 					t = calloc(1, sizeof(struct threads));
 					t->base_addr = ct->TS;
 					fill_task(target, t);
-					get_name(target, t);
 					t->oncpu = cpu;
 					insert_into_threadlist(target, t);
 					t->status = 3;
@@ -566,20 +547,14 @@ retry:
 
 static uint32_t next_task(struct target *target, struct threads *t)
 {
-	uint8_t *buffer = calloc(1, 4);
+	uint8_t buffer[4];
 	uint32_t next_addr = t->base_addr + NEXT;
 	int retval = fill_buffer(target, next_addr, buffer);
 
-	if (retval == ERROR_OK) {
-		uint32_t val = get_buffer(target, buffer);
-		val = val - NEXT;
-		free(buffer);
-		return val;
-	} else
-		LOG_ERROR("next task: unable to read memory");
-
-	free(buffer);
+	if (retval == ERROR_OK)
+		return get_buffer(target, buffer) - NEXT;
 
+	LOG_ERROR("next task: unable to read memory");
 	return 0;
 }
 
@@ -694,8 +669,7 @@ static int linux_get_tasks(struct target *target, int context)
 	while (((t->base_addr != linux_os->init_task_addr) &&
 		(t->base_addr != 0)) || (loop == 0)) {
 		loop++;
-		fill_task(target, t);
-		retval = get_name(target, t);
+		retval = fill_task(target, t);
 
 		if (loop > MAX_THREADS) {
 			free(t);
@@ -731,10 +705,10 @@ static int linux_get_tasks(struct target *target, int context)
 				t->context =
 					cpu_context_read(target, t->base_addr,
 						&t->thread_info_addr);
-			base_addr = next_task(target, t);
+			base_addr = t->next_base;
 		} else {
 			/*LOG_INFO("thread %s is a current thread already created",t->name); */
-			base_addr = next_task(target, t);
+			base_addr = t->next_base;
 			free(t);
 		}
 
@@ -860,7 +834,6 @@ error_handling:
 				if (fill_task(target, t) != ERROR_OK)
 					goto error_handling;
 
-				get_name(target, t);
 				insert_into_threadlist(target, t);
 				t->thread_info_addr = 0xdeadbeef;
 			}
@@ -995,7 +968,6 @@ static int linux_task_update(struct target *target, int context)
 		if (found == 0) {
 			uint32_t base_addr;
 			fill_task(target, t);
-			get_name(target, t);
 			retval = insert_into_threadlist(target, t);
 			t->thread_info_addr = 0xdeadbeef;
 
@@ -1004,12 +976,25 @@ static int linux_task_update(struct target *target, int context)
 					cpu_context_read(target, t->base_addr,
 						&t->thread_info_addr);
 
-			base_addr = next_task(target, t);
+			base_addr = t->next_base;
 			t = calloc(1, sizeof(struct threads));
 			t->base_addr = base_addr;
 			linux_os->thread_count++;
-		} else
-			t->base_addr = next_task(target, t);
+		} else {
+			/*  known task, only re-read when its linkage changed  */
+			uint32_t base_addr = next_task(target, t);
+
+			if (thread_list && base_addr != thread_list->next_base) {
+				/*  keep the cpu number get_current() set for a current thread  */
+				uint32_t oncpu = thread_list->oncpu;
+
+				fill_task(target, thread_list);
+				if (thread_list->status == 3)
+					thread_list->oncpu = oncpu;
+			}
+
+			t->base_addr = base_addr;
+		}
 	}
 
 	LOG_INFO("update thread done %" PRId64 ", mean%" PRId64 "\n",
@@ -555,7 +555,7 @@ int rtos_get_gdb_reg(struct connection *connection, int reg_num)
 	if ((target->rtos) && (current_threadid != -1) &&
 			(current_threadid != 0) &&
 			((current_threadid != target->rtos->current_thread) ||
-			(target->smp))) {	/* in smp several current thread are possible */
+			target_smp_threads(target))) {	/* in smp several current thread are possible */
 		struct rtos_reg *reg_list;
 		int num_regs;
 
@@ -612,7 +612,7 @@ int rtos_get_gdb_reg_list(struct connection *connection)
 	if ((target->rtos) && (current_threadid != -1) &&
 			(current_threadid != 0) &&
 			((current_threadid != target->rtos->current_thread) ||
-			(target->smp))) {	/* in smp several current thread are possible */
+			target_smp_threads(target))) {	/* in smp several current thread are possible */
 		struct rtos_reg *reg_list;
 		int num_regs;
 
@@ -66,6 +66,19 @@ struct target_desc_format {
 	uint32_t tdesc_length;
 };
 
+/* a core (or the single target) as seen by gdb in non-stop mode */
+struct gdb_nonstop_thread {
+	struct target *target;
+	unsigned int smp;		/* target->smp before entering non-stop mode */
+	bool stop_requested;	/* halted by vCont;t, reported with signal 0 */
+};
+
+/* flash range requested by vFlashErase, erased when vFlashDone arrives */
+struct gdb_vflash_erase {
+	target_addr_t address;
+	uint32_t length;
+};
+
 /* private connection data for GDB */
 struct gdb_connection {
 	char buffer[GDB_BUFFER_SIZE + 1]; /* Extra byte for null-termination */
@@ -74,6 +87,10 @@ struct gdb_connection {
 	bool ctrl_c;
 	enum target_state frontend_state;
 	struct image *vflash_image;
+	/* pending vFlashErase ranges, adjacent requests are merged */
+	struct gdb_vflash_erase *vflash_erase;
+	unsigned int vflash_erase_count;
+	unsigned int vflash_erase_size;
 	bool closed;
 	/* set to prevent re-entrance from log messages during gdb_get_packet()
 	 * and gdb_put_packet(). */
@@ -103,6 +120,13 @@ struct gdb_connection {
 	enum gdb_output_flag output_flag;
 	/* Unique index for this GDB connection. */
 	unsigned int unique_index;
+	/* non-stop mode: thread N is nonstop_threads[N - 1] */
+	bool non_stop;
+	struct gdb_nonstop_thread *nonstop_threads;
+	unsigned int nonstop_thread_count;
+	/* threads whose stop was notified but not yet acknowledged by vStopped */
+	unsigned int *stop_queue;
+	unsigned int stop_queue_len;
 };
 
 #if 0
@@ -122,6 +146,7 @@ static void gdb_log_callback(void *priv, const char *file, unsigned int line,
 		const char *function, const char *string);
 
 static void gdb_sig_halted(struct connection *connection);
+static void gdb_send_error(struct connection *connection, uint8_t the_error);
 
 /* number of gdb connections, mainly to suppress gdb related debugging spam
  * in helper/log.c when no gdb connections are actually active */
@@ -161,7 +186,7 @@ struct target *get_available_target_from_connection(struct connection *connectio
 {
 	struct gdb_service *gdb_service = connection->service->priv;
 	struct target *target = gdb_service->target;
-	if (target->state == TARGET_UNAVAILABLE && target->smp) {
+	if (target->state == TARGET_UNAVAILABLE && target_smp_threads(target)) {
 		struct target_list *tlist;
 		foreach_smp_target(tlist, target->smp_targets) {
 			struct target *t = tlist->target;
@@ -798,6 +823,36 @@ static int gdb_output(struct command_context *context, const char *line)
 	return ERROR_OK;
 }
 
+/* format the watchpoint part of a stop reply, if any */
+static void gdb_stop_reason(struct target *ct, char *stop_reason, size_t size)
+{
+	stop_reason[0] = '\0';
+	if (ct->debug_reason == DBG_REASON_WATCHPOINT) {
+		enum watchpoint_rw hit_wp_type;
+		target_addr_t hit_wp_address;
+
+		if (watchpoint_hit(ct, &hit_wp_type, &hit_wp_address) == ERROR_OK) {
+
+			switch (hit_wp_type) {
+				case WPT_WRITE:
+					snprintf(stop_reason, size,
+							"watch:%08" TARGET_PRIxADDR ";", hit_wp_address);
+					break;
+				case WPT_READ:
+					snprintf(stop_reason, size,
+							"rwatch:%08" TARGET_PRIxADDR ";", hit_wp_address);
+					break;
+				case WPT_ACCESS:
+					snprintf(stop_reason, size,
+							"awatch:%08" TARGET_PRIxADDR ";", hit_wp_address);
+					break;
+				default:
+					break;
+			}
+		}
+	}
+}
+
 static void gdb_signal_reply(struct target *target, struct connection *connection)
 {
 	struct gdb_connection *gdb_connection = connection->priv;
@@ -829,31 +884,7 @@ static void gdb_signal_reply(struct target *target, struct connection *connectio
 		} else
 			signal_var = gdb_last_signal(ct);
 
-		stop_reason[0] = '\0';
-		if (ct->debug_reason == DBG_REASON_WATCHPOINT) {
-			enum watchpoint_rw hit_wp_type;
-			target_addr_t hit_wp_address;
-
-			if (watchpoint_hit(ct, &hit_wp_type, &hit_wp_address) == ERROR_OK) {
-
-				switch (hit_wp_type) {
-					case WPT_WRITE:
-						snprintf(stop_reason, sizeof(stop_reason),
-								"watch:%08" TARGET_PRIxADDR ";", hit_wp_address);
-						break;
-					case WPT_READ:
-						snprintf(stop_reason, sizeof(stop_reason),
-								"rwatch:%08" TARGET_PRIxADDR ";", hit_wp_address);
-						break;
-					case WPT_ACCESS:
-						snprintf(stop_reason, sizeof(stop_reason),
-								"awatch:%08" TARGET_PRIxADDR ";", hit_wp_address);
-						break;
-					default:
-						break;
-				}
-			}
-		}
+		gdb_stop_reason(ct, stop_reason, sizeof(stop_reason));
 
 		current_thread[0] = '\0';
 		if (rtos)
@@ -983,12 +1014,309 @@ static void gdb_frontend_halted(struct target *target, struct connection *connec
 	}
 }
 
+/*
+ * gdb non-stop mode.
+ *
+ * Every core of the SMP group (or the target itself when it is not part of
+ * a group) is a thread that gdb resumes, steps and stops individually with
+ * vCont. While non-stop mode is active, smp is cleared on the cores so that
+ * halting or resuming one of them leaves the others alone. Stops are queued
+ * and announced with a %Stop notification; gdb then drains the queue with
+ * vStopped.
+ */
+static void gdb_put_notification(struct connection *connection,
+		const char *name, const char *data, int len)
+{
+	unsigned char checksum = 0;
+	char *buf = alloc_printf("%%%s:%.*s", name, len, data);
+	if (!buf)
+		return;
+
+	int buf_len = strlen(buf);
+	for (int i = 1; i < buf_len; i++)
+		checksum += buf[i];
+
+	char trailer[4];
+	snprintf(trailer, sizeof(trailer), "#%2.2x", checksum);
+
+	gdb_write(connection, buf, buf_len);
+	gdb_write(connection, trailer, 3);
+	free(buf);
+}
+
+static int gdb_nonstop_thread_index(struct gdb_connection *gdb_con, struct target *target)
+{
+	for (unsigned int i = 0; i < gdb_con->nonstop_thread_count; i++)
+		if (gdb_con->nonstop_threads[i].target == target)
+			return i;
+
+	return -1;
+}
+
+static int gdb_nonstop_stop_reply(struct connection *connection, unsigned int index,
+		char *buf, size_t size)
+{
+	struct gdb_connection *gdb_con = connection->priv;
+	struct gdb_nonstop_thread *thread = &gdb_con->nonstop_threads[index];
+	struct target *target = get_target_from_connection(connection);
+	char stop_reason[32];
+	int signal_var;
+
+	signal_var = thread->stop_requested ? 0 : gdb_last_signal(thread->target);
+	gdb_stop_reason(thread->target, stop_reason, sizeof(stop_reason));
+
+	/* without an RTOS gdb only knows a single, implicit thread */
+	if (!target->rtos)
+		return snprintf(buf, size, "T%2.2x%s", signal_var, stop_reason);
+
+	return snprintf(buf, size, "T%2.2x%sthread:%x;", signal_var, stop_reason, index + 1);
+}
+
+/* queue the stop of @a target, notifying gdb if no stop is pending */
+static void gdb_nonstop_stopped(struct connection *connection, struct target *target)
+{
+	struct gdb_connection *gdb_con = connection->priv;
+	char reply[64];
+
+	int index = gdb_nonstop_thread_index(gdb_con, target);
+	if (index < 0)
+		return;
+
+	for (unsigned int i = 0; i < gdb_con->stop_queue_len; i++)
+		if (gdb_con->stop_queue[i] == (unsigned int)index)
+			return;
+
+	gdb_con->stop_queue[gdb_con->stop_queue_len++] = index;
+	if (gdb_con->stop_queue_len > 1)
+		return;
+
+	rtos_update_threads(get_target_from_connection(connection));
+	int len = gdb_nonstop_stop_reply(connection, index, reply, sizeof(reply));
+	gdb_put_notification(connection, "Stop", reply, len);
+}
+
+/* vStopped: drop the acknowledged stop and report the next one */
+static void gdb_nonstop_vstopped(struct connection *connection)
+{
+	struct gdb_connection *gdb_con = connection->priv;
+	char reply[64];
+
+	if (gdb_con->stop_queue_len) {
+		gdb_con->stop_queue_len--;
+		memmove(gdb_con->stop_queue, gdb_con->stop_queue + 1,
+			gdb_con->stop_queue_len * sizeof(*gdb_con->stop_queue));
+	}
+
+	if (!gdb_con->stop_queue_len) {
+		gdb_put_packet(connection, "OK", 2);
+		return;
+	}
+
+	int len = gdb_nonstop_stop_reply(connection, gdb_con->stop_queue[0], reply, sizeof(reply));
+	gdb_put_packet(connection, reply, len);
+}
+
+/* '?' in non-stop mode: report every stopped thread, through vStopped */
+static void gdb_nonstop_report_all(struct connection *connection)
+{
+	struct gdb_connection *gdb_con = connection->priv;
+	char reply[64];
+
+	gdb_con->stop_queue_len = 0;
+	for (unsigned int i = 0; i < gdb_con->nonstop_thread_count; i++)
+		if (gdb_con->nonstop_threads[i].target->state == TARGET_HALTED)
+			gdb_con->stop_queue[gdb_con->stop_queue_len++] = i;
+
+	if (!gdb_con->stop_queue_len) {
+		gdb_put_packet(connection, "OK", 2);
+		return;
+	}
+
+	rtos_update_threads(get_target_from_connection(connection));
+	int len = gdb_nonstop_stop_reply(connection, gdb_con->stop_queue[0], reply, sizeof(reply));
+	gdb_put_packet(connection, reply, len);
+}
+
+static void gdb_nonstop_disable(struct connection *connection)
+{
+	struct gdb_connection *gdb_con = connection->priv;
+
+	for (unsigned int i = 0; i < gdb_con->nonstop_thread_count; i++) {
+		struct gdb_nonstop_thread *thread = &gdb_con->nonstop_threads[i];
+		thread->target->smp = thread->smp;
+		thread->target->smp_nonstop = false;
+	}
+
+	free(gdb_con->nonstop_threads);
+	gdb_con->nonstop_threads = NULL;
+	gdb_con->nonstop_thread_count = 0;
+	free(gdb_con->stop_queue);
+	gdb_con->stop_queue = NULL;
+	gdb_con->stop_queue_len = 0;
+	gdb_con->non_stop = false;
+}
+
+static int gdb_nonstop_enable(struct connection *connection)
+{
+	struct gdb_connection *gdb_con = connection->priv;
+	struct target *target = get_target_from_connection(connection);
+	struct target_list *head;
+	unsigned int count = 1;
+
+	if (gdb_con->non_stop)
+		return ERROR_OK;
+
+	/* threads of a software RTOS cannot be run individually */
+	if (target->rtos && strcmp(target->rtos->type->name, "hwthread")) {
+		LOG_TARGET_ERROR(target, "non-stop mode is not supported with RTOS %s",
+			target->rtos->type->name);
+		return ERROR_FAIL;
+	}
+
+	if (target->smp) {
+		count = 0;
+		foreach_smp_target(head, target->smp_targets)
+			count++;
+	}
+
+	gdb_con->nonstop_threads = calloc(count, sizeof(*gdb_con->nonstop_threads));
+	gdb_con->stop_queue = calloc(count, sizeof(*gdb_con->stop_queue));
+	if (!gdb_con->nonstop_threads || !gdb_con->stop_queue) {
+		LOG_ERROR("Out of memory");
+		free(gdb_con->nonstop_threads);
+		gdb_con->nonstop_threads = NULL;
+		free(gdb_con->stop_queue);
+		gdb_con->stop_queue = NULL;
+		return ERROR_FAIL;
+	}
+
+	if (target->smp) {
+		foreach_smp_target(head, target->smp_targets)
+			gdb_con->nonstop_threads[gdb_con->nonstop_thread_count++].target = head->target;
+	} else {
+		gdb_con->nonstop_threads[gdb_con->nonstop_thread_count++].target = target;
+	}
+
+	for (unsigned int i = 0; i < gdb_con->nonstop_thread_count; i++) {
+		struct gdb_nonstop_thread *thread = &gdb_con->nonstop_threads[i];
+		thread->smp = thread->target->smp;
+		thread->target->smp_nonstop = thread->smp != 0;
+		thread->target->smp = 0;
+	}
+
+	gdb_con->non_stop = true;
+	gdb_con->output_flag = GDB_OUTPUT_NO;
+
+	return ERROR_OK;
+}
+
+/* vCont in non-stop mode: apply one action per thread and reply at once */
+static int gdb_nonstop_vcont(struct connection *connection, const char *parse)
+{
+	struct gdb_connection *gdb_con = connection->priv;
+	char *actions = calloc(gdb_con->nonstop_thread_count, 1);
+
+	if (!actions)
+		return ERROR_FAIL;
+
+	/* the leftmost action that matches a thread applies to it */
+	while (parse[0] == ';') {
+		char action = parse[1];
+		char *endp;
+		int64_t thread_id = -1;
+
+		parse += 2;
+		if (action == 'C' || action == 'S') {
+			/* signals cannot be delivered to bare metal targets */
+			strtoul(parse, &endp, 16);
+			parse = endp;
+			action = tolower(action);
+		}
+
+		if (action != 'c' && action != 's' && action != 't') {
+			free(actions);
+			gdb_send_error(connection, EINVAL);
+			return ERROR_OK;
+		}
+
+		if (parse[0] == ':') {
+			thread_id = strtoll(parse + 1, &endp, 16);
+			parse = endp;
+		}
+
+		for (unsigned int i = 0; i < gdb_con->nonstop_thread_count; i++)
+			if (!actions[i] && (thread_id <= 0 || thread_id == (int64_t)i + 1))
+				actions[i] = action;
+	}
+
+	gdb_put_packet(connection, "OK", 2);
+
+	for (unsigned int i = 0; i < gdb_con->nonstop_thread_count; i++) {
+		struct gdb_nonstop_thread *thread = &gdb_con->nonstop_threads[i];
+		struct target *ct = thread->target;
+		int retval;
+
+		switch (actions[i]) {
+		case 'c':
+			if (ct->state != TARGET_HALTED)
+				break;
+			thread->stop_requested = false;
+			target_call_event_callbacks(ct, TARGET_EVENT_GDB_START);
+			retval = target_resume(ct, true, 0, false, false);
+			if (retval != ERROR_OK)
+				LOG_TARGET_ERROR(ct, "resume of thread %u failed", i + 1);
+			break;
+		case 's':
+			if (ct->state != TARGET_HALTED)
+				break;
+			thread->stop_requested = false;
+			target_call_event_callbacks(ct, TARGET_EVENT_GDB_START);
+			retval = target_step(ct, true, 0, false);
+			if (retval == ERROR_OK)
+				retval = target_poll(ct);
+			if (retval != ERROR_OK)
+				LOG_TARGET_ERROR(ct, "step of thread %u failed", i + 1);
+			/* not every target signals the halt at the end of a step */
+			if (ct->state == TARGET_HALTED)
+				gdb_nonstop_stopped(connection, ct);
+			break;
+		case 't':
+			thread->stop_requested = true;
+			if (ct->state == TARGET_HALTED) {
+				gdb_nonstop_stopped(connection, ct);
+				break;
+			}
+			retval = target_halt(ct);
+			if (retval == ERROR_OK)
+				retval = target_poll(ct);
+			if (retval != ERROR_OK)
+				LOG_TARGET_ERROR(ct, "halt of thread %u failed", i + 1);
+			break;
+		default:
+			break;
+		}
+	}
+
+	free(actions);
+	return ERROR_OK;
+}
+
 static int gdb_target_callback_event_handler(struct target *target,
 		enum target_event event, void *priv)
 {
 	struct connection *connection = priv;
+	struct gdb_connection *gdb_connection = connection->priv;
 	struct target *gdb_target = get_available_target_from_connection(connection);
 
+	if (gdb_connection->non_stop) {
+		if (event == TARGET_EVENT_HALTED &&
+				gdb_nonstop_thread_index(gdb_connection, target) >= 0) {
+			gdb_nonstop_stopped(connection, target);
+			target_call_event_callbacks(target, TARGET_EVENT_GDB_END);
+		}
+		return ERROR_OK;
+	}
+
 	if (gdb_target != target)
 		return ERROR_OK;
 
@@ -1024,6 +1352,9 @@ static int gdb_new_connection(struct connection *connection)
 	gdb_connection->ctrl_c = false;
 	gdb_connection->frontend_state = TARGET_HALTED;
 	gdb_connection->vflash_image = NULL;
+	gdb_connection->vflash_erase = NULL;
+	gdb_connection->vflash_erase_count = 0;
+	gdb_connection->vflash_erase_size = 0;
 	gdb_connection->closed = false;
 	gdb_connection->busy = false;
 	gdb_connection->noack_mode = 0;
@@ -1036,6 +1367,11 @@ static int gdb_new_connection(struct connection *connection)
 	gdb_connection->thread_list = NULL;
 	gdb_connection->output_flag = GDB_OUTPUT_NO;
 	gdb_connection->unique_index = next_unique_id++;
+	gdb_connection->non_stop = false;
+	gdb_connection->nonstop_threads = NULL;
+	gdb_connection->nonstop_thread_count = 0;
+	gdb_connection->stop_queue = NULL;
+	gdb_connection->stop_queue_len = 0;
 
 	/* output goes through gdb connection */
 	command_set_output_handler(connection->cmd_ctx, gdb_output, connection);
@@ -1145,6 +1481,12 @@ static int gdb_connection_closed(struct connection *connection)
 		free(gdb_connection->vflash_image);
 		gdb_connection->vflash_image = NULL;
 	}
+	free(gdb_connection->vflash_erase);
+	gdb_connection->vflash_erase = NULL;
+
+	/* give the cores back their SMP coupling */
+	if (gdb_connection->non_stop)
+		gdb_nonstop_disable(connection);
 
 	/* if this connection registered a debug-message receiver delete it */
 	delete_debug_msg_receiver(connection->cmd_ctx, target);
@@ -1939,35 +2281,33 @@ static int compare_bank(const void *a, const void *b)
 		return -1;
 }
 
-static int gdb_memory_map(struct connection *connection,
-		char const *packet, int packet_size)
+/* Memory map of one target, regenerated only when its flash layout changes */
+struct gdb_memory_map_cache {
+	struct target *target;
+	uint64_t signature;
+	char *xml;
+	int len;
+	struct gdb_memory_map_cache *next;
+};
+
+static struct gdb_memory_map_cache *gdb_memory_maps;
+
+static int gdb_memory_map_build(struct target *target, char **xml_out, int *len_out)
 {
 	/* We get away with only specifying flash here. Regions that are not
 	 * specified are treated as if we provided no memory map(if not we
 	 * could detect the holes and mark them as RAM).
-	 * Normally we only execute this code once, but no big deal if we
-	 * have to regenerate it a couple of times.
 	 */
 
-	struct target *target = get_available_target_from_connection(connection);
 	struct flash_bank *p;
 	char *xml = NULL;
 	int size = 0;
 	int pos = 0;
 	int retval = ERROR_OK;
 	struct flash_bank **banks;
-	int offset;
-	int length;
-	char *separator;
 	target_addr_t ram_start = 0;
 	unsigned int target_flash_banks = 0;
 
-	/* skip command character */
-	packet += 23;
-
-	offset = strtoul(packet, &separator, 16);
-	length = strtoul(separator + 1, &separator, 16);
-
 	xml_printf(&retval, &xml, &pos, &size, "<memory-map>\n");
 
 	/* Sort banks in ascending order.  We need to report non-flash
@@ -1975,18 +2315,15 @@ static int gdb_memory_map(struct connection *connection,
 	 * it has no concept of non-cacheable read/write memory (i/o etc).
 	 */
 	banks = malloc(sizeof(struct flash_bank *)*flash_get_bank_count());
+	if (!banks) {
+		free(xml);
+		return ERROR_FAIL;
+	}
 
-	for (unsigned int i = 0; i < flash_get_bank_count(); i++) {
-		p = get_flash_bank_by_num_noprobe(i);
-		if (p->target != target)
-			continue;
-		retval = get_flash_bank_by_num(i, &p);
-		if (retval != ERROR_OK) {
-			free(banks);
-			gdb_error(connection, retval);
-			return retval;
-		}
-		banks[target_flash_banks++] = p;
+	/* the caller has probed the banks already */
+	for (p = flash_bank_list(); p; p = p->next) {
+		if (p->target == target)
+			banks[target_flash_banks++] = p;
 	}
 
 	qsort(banks, target_flash_banks, sizeof(struct flash_bank *),
@@ -2084,20 +2421,113 @@ static int gdb_memory_map(struct connection *connection,
 
 	if (retval != ERROR_OK) {
 		free(xml);
+		return retval;
+	}
+
+	*xml_out = xml;
+	*len_out = pos;
+	return ERROR_OK;
+}
+
+static int gdb_memory_map_get(struct target *target,
+		struct gdb_memory_map_cache **map_out)
+{
+	struct gdb_memory_map_cache *map;
+	char *xml;
+	int len;
+	int retval;
+
+	/* Cheap for banks that are probed already, which is the common
+	 * case once the background probe started by "flash init" is done */
+	for (unsigned int i = 0; i < flash_get_bank_count(); i++) {
+		struct flash_bank *p = get_flash_bank_by_num_noprobe(i);
+		if (p->target != target)
+			continue;
+		retval = get_flash_bank_by_num(i, &p);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	uint64_t signature = flash_layout_signature(target);
+
+	for (map = gdb_memory_maps; map; map = map->next) {
+		if (map->target == target)
+			break;
+	}
+
+	if (map && map->signature == signature) {
+		*map_out = map;
+		return ERROR_OK;
+	}
+
+	retval = gdb_memory_map_build(target, &xml, &len);
+	if (retval != ERROR_OK)
+		return retval;
+
+	if (!map) {
+		map = calloc(1, sizeof(*map));
+		if (!map) {
+			free(xml);
+			return ERROR_FAIL;
+		}
+		map->target = target;
+		map->next = gdb_memory_maps;
+		gdb_memory_maps = map;
+	} else {
+		LOG_TARGET_DEBUG(target, "flash layout changed, regenerating memory map");
+		free(map->xml);
+	}
+
+	map->signature = signature;
+	map->xml = xml;
+	map->len = len;
+
+	*map_out = map;
+	return ERROR_OK;
+}
+
+static void gdb_memory_map_free_all(void)
+{
+	while (gdb_memory_maps) {
+		struct gdb_memory_map_cache *next = gdb_memory_maps->next;
+		free(gdb_memory_maps->xml);
+		free(gdb_memory_maps);
+		gdb_memory_maps = next;
+	}
+}
+
+static int gdb_memory_map(struct connection *connection,
+		char const *packet, int packet_size)
+{
+	struct target *target = get_available_target_from_connection(connection);
+	struct gdb_memory_map_cache *map;
+	int offset;
+	int length;
+	char *separator;
+
+	/* skip command character */
+	packet += 23;
+
+	offset = strtoul(packet, &separator, 16);
+	length = strtoul(separator + 1, &separator, 16);
+
+	int retval = gdb_memory_map_get(target, &map);
+	if (retval != ERROR_OK) {
 		gdb_error(connection, retval);
 		return retval;
 	}
 
-	if (offset + length > pos)
-		length = pos - offset;
+	if (offset > map->len)
+		offset = map->len;
+	if (offset + length > map->len)
+		length = map->len - offset;
 
 	char *t = malloc(length + 1);
 	t[0] = 'l';
-	memcpy(t + 1, xml + offset, length);
+	memcpy(t + 1, map->xml + offset, length);
 	gdb_put_packet(connection, t, length + 1);
 
 	free(t);
-	free(xml);
 	return ERROR_OK;
 }
 
@@ -2352,7 +2782,7 @@ static int smp_reg_list_noread(struct target *target,
 		struct reg **combined_list[], int *combined_list_size,
 		enum target_register_class reg_class)
 {
-	if (!target->smp)
+	if (!target_smp_threads(target))
 		return target_get_gdb_reg_list_noread(target, combined_list,
 				combined_list_size, REG_CLASS_ALL);
 
@@ -2942,7 +3372,7 @@ static int gdb_query_packet(struct connection *connection,
 			&buffer,
 			&pos,
 			&size,
-			"PacketSize=%x;qXfer:memory-map:read%c;qXfer:features:read%c;qXfer:threads:read+;QStartNoAckMode+;vContSupported+",
+			"PacketSize=%x;qXfer:memory-map:read%c;qXfer:features:read%c;qXfer:threads:read+;QStartNoAckMode+;vContSupported+;QNonStop+",
 			GDB_BUFFER_SIZE,
 			(gdb_use_memory_map && (flash_get_bank_count() > 0)) ? '+' : '-',
 			gdb_target_desc_supported ? '+' : '-');
@@ -3025,6 +3455,17 @@ static int gdb_query_packet(struct connection *connection,
 		gdb_connection->noack_mode = 1;
 		gdb_put_packet(connection, "OK", 2);
 		return ERROR_OK;
+	} else if (strncmp(packet, "QNonStop:", 9) == 0) {
+		if (packet[9] == '1') {
+			if (gdb_nonstop_enable(connection) != ERROR_OK) {
+				gdb_send_error(connection, EINVAL);
+				return ERROR_OK;
+			}
+		} else if (gdb_connection->non_stop) {
+			gdb_nonstop_disable(connection);
+		}
+		gdb_put_packet(connection, "OK", 2);
+		return ERROR_OK;
 	} else if (target->type->gdb_query_custom) {
 		char *buffer = NULL;
 		int ret = target->type->gdb_query_custom(target, packet, &buffer);
@@ -3048,12 +3489,18 @@ static bool gdb_handle_vcont_packet(struct connection *connection, const char *p
 	if (parse[0] == '?') {
 		if (target->type->step) {
 			/* gdb doesn't accept c without C and s without S */
-			gdb_put_packet(connection, "vCont;c;C;s;S", 13);
+			if (gdb_connection->non_stop)
+				gdb_put_packet(connection, "vCont;c;C;s;S;t", 15);
+			else
+				gdb_put_packet(connection, "vCont;c;C;s;S", 13);
 			return true;
 		}
 		return false;
 	}
 
+	if (gdb_connection->non_stop)
+		return gdb_nonstop_vcont(connection, parse) == ERROR_OK;
+
 	if (parse[0] == ';') {
 		++parse;
 	}
@@ -3315,6 +3762,70 @@ static bool gdb_handle_vrun_packet(struct connection *connection, const char *pa
 	return true;
 }
 
+static int gdb_vflash_queue_erase(struct gdb_connection *gdb_connection,
+	target_addr_t addr, uint32_t length)
+{
+	if (gdb_connection->vflash_erase_count) {
+		struct gdb_vflash_erase *last =
+			&gdb_connection->vflash_erase[gdb_connection->vflash_erase_count - 1];
+		if (last->address + last->length == addr) {
+			last->length += length;
+			return ERROR_OK;
+		}
+	}
+
+	if (gdb_connection->vflash_erase_count == gdb_connection->vflash_erase_size) {
+		unsigned int size = gdb_connection->vflash_erase_size ? 2 * gdb_connection->vflash_erase_size : 4;
+		struct gdb_vflash_erase *erase = realloc(gdb_connection->vflash_erase,
+			size * sizeof(*erase));
+		if (!erase) {
+			LOG_ERROR("Out of memory");
+			return ERROR_FAIL;
+		}
+		gdb_connection->vflash_erase = erase;
+		gdb_connection->vflash_erase_size = size;
+	}
+
+	gdb_connection->vflash_erase[gdb_connection->vflash_erase_count].address = addr;
+	gdb_connection->vflash_erase[gdb_connection->vflash_erase_count].length = length;
+	gdb_connection->vflash_erase_count++;
+
+	return ERROR_OK;
+}
+
+/* perform the erase operations queued by vFlashErase */
+static int gdb_vflash_do_erase(struct connection *connection)
+{
+	struct gdb_connection *gdb_connection = connection->priv;
+	struct target *target = get_target_from_connection(connection);
+	int retval = ERROR_OK;
+
+	if (!gdb_connection->vflash_erase_count)
+		return ERROR_OK;
+
+	/* perform any target specific operations before the erase */
+	target_call_event_callbacks(target, TARGET_EVENT_GDB_FLASH_ERASE_START);
+
+	/* vFlashErase:addr,length messages require region start and
+	 * end to be "block" aligned ... if padding is ever needed,
+	 * GDB will have become dangerously confused.
+	 */
+	for (unsigned int i = 0; i < gdb_connection->vflash_erase_count; i++) {
+		retval = flash_erase_address_range(target, false,
+			gdb_connection->vflash_erase[i].address,
+			gdb_connection->vflash_erase[i].length);
+		if (retval != ERROR_OK)
+			break;
+	}
+
+	/* perform any target specific operations after the erase */
+	target_call_event_callbacks(target, TARGET_EVENT_GDB_FLASH_ERASE_END);
+
+	gdb_connection->vflash_erase_count = 0;
+
+	return retval;
+}
+
 static int gdb_v_packet(struct connection *connection,
 		char const *packet, int packet_size)
 {
@@ -3323,6 +3834,11 @@ static int gdb_v_packet(struct connection *connection,
 
 	struct target *target = get_available_target_from_connection(connection);
 
+	if (strcmp(packet, "vStopped") == 0 && gdb_connection->non_stop) {
+		gdb_nonstop_vstopped(connection);
+		return ERROR_OK;
+	}
+
 	if (strncmp(packet, "vCont", 5) == 0) {
 		bool handled;
 
@@ -3381,30 +3897,15 @@ static int gdb_v_packet(struct connection *connection,
 		 * when flash_write is called multiple times */
 		flash_set_dirty();
 
-		/* perform any target specific operations before the erase */
-		target_call_event_callbacks(target,
-			TARGET_EVENT_GDB_FLASH_ERASE_START);
-
-		/* vFlashErase:addr,length messages require region start and
-		 * end to be "block" aligned ... if padding is ever needed,
-		 * GDB will have become dangerously confused.
-		 */
-		result = flash_erase_address_range(target, false, addr,
-			length);
-
-		/* perform any target specific operations after the erase */
-		target_call_event_callbacks(target,
-			TARGET_EVENT_GDB_FLASH_ERASE_END);
-
-		/* perform erase */
+		/* queue the erase; it is performed synchronously when vFlashDone
+		 * arrives, with adjacent regions merged into a single pass */
+		result = gdb_vflash_queue_erase(gdb_connection, addr, length);
 		if (result != ERROR_OK) {
-			/* GDB doesn't evaluate the actual error number returned,
-			 * treat a failed erase as an I/O error
-			 */
 			gdb_send_error(connection, EIO);
-			LOG_ERROR("flash_erase returned %i", result);
-		} else
-			gdb_put_packet(connection, "OK", 2);
+			return ERROR_OK;
+		}
+
+		gdb_put_packet(connection, "OK", 2);
 
 		return ERROR_OK;
 	}
@@ -3447,6 +3948,21 @@ static int gdb_v_packet(struct connection *connection,
 	if (strncmp(packet, "vFlashDone", 10) == 0) {
 		uint32_t written;
 
+		result = gdb_vflash_do_erase(connection);
+		if (result != ERROR_OK) {
+			/* GDB doesn't evaluate the actual error number returned,
+			 * treat a failed erase as an I/O error
+			 */
+			gdb_send_error(connection, EIO);
+			LOG_ERROR("flash_erase returned %i", result);
+			if (gdb_connection->vflash_image) {
+				image_close(gdb_connection->vflash_image);
+				free(gdb_connection->vflash_image);
+				gdb_connection->vflash_image = NULL;
+			}
+			return ERROR_OK;
+		}
+
 		/* GDB command 'flash-erase' does not send a vFlashWrite,
 		 * so nothing to write here. */
 		if (!gdb_connection->vflash_image) {
@@ -3647,7 +4163,10 @@ static int gdb_input_inner(struct connection *connection)
 					retval = gdb_breakpoint_watchpoint_packet(connection, packet, packet_size);
 					break;
 				case '?':
-					gdb_last_signal_packet(connection, packet, packet_size);
+					if (gdb_con->non_stop)
+						gdb_nonstop_report_all(connection);
+					else
+						gdb_last_signal_packet(connection, packet, packet_size);
 					/* '?' is sent after the eventual '!' */
 					if (!warn_use_ext && !gdb_con->extended_protocol) {
 						warn_use_ext = true;
@@ -4248,6 +4767,7 @@ int gdb_register_commands(struct command_context *cmd_ctx)
 
 void gdb_service_free(void)
 {
+	gdb_memory_map_free_all();
 	free(gdb_port);
 	free(gdb_port_next);
 }
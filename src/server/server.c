@@ -490,6 +490,8 @@ int server_loop(struct command_context *command_context)
 			else if (timeout_ms > polling_period)
 				timeout_ms = polling_period;
 			tv.tv_usec = timeout_ms * 1000;
+			/* the log file is complete whenever we're idle */
+			log_flush();
 			/* Only while we're sleeping we'll let others run */
 			retval = socket_select(fd_max + 1, &read_fds, NULL, NULL, &tv);
 		}
@@ -617,6 +619,10 @@ static void sig_handler(int sig)
 		LOG_DEBUG("Terminating on Signal %d", sig);
 	} else
 		LOG_DEBUG("Ignored extra Signal %d", sig);
+
+	/* abort() terminates once we return, without flushing stdio */
+	if (sig == SIGABRT)
+		log_flush();
 }
 
 
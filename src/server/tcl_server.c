@@ -17,6 +17,20 @@
 #define TCL_LINE_INITIAL		(4*1024)
 #define TCL_LINE_MAX			(4*1024*1024)
 
+/*
+ * Binary memory transfer frames. A message whose first byte is NUL (which
+ * cannot start a Tcl command) is a length prefixed request, all fields
+ * little endian:
+ *   u8 0, u8 op ('r' or 'w'), u32 tag, u64 address, u32 length, data (for 'w')
+ * It is answered with
+ *   u8 0, u8 op, u32 tag, i32 status, u32 length, data (for 'r')
+ * Requests may be pipelined; the responses come back in order.
+ */
+#define TCL_BIN_MAGIC			0x00
+#define TCL_BIN_REQUEST_SIZE	18
+#define TCL_BIN_RESPONSE_SIZE	14
+#define TCL_BIN_DATA_MAX		(TCL_LINE_MAX - TCL_BIN_REQUEST_SIZE)
+
 struct tcl_connection {
 	int tc_linedrop;
 	int tc_lineoffset;
@@ -26,6 +40,7 @@ struct tcl_connection {
 	enum target_state tc_laststate;
 	bool tc_notify;
 	bool tc_trace;
+	bool tc_binary;	/* the pending message is a binary frame */
 };
 
 static char *tcl_port;
@@ -160,6 +175,108 @@ static int tcl_new_connection(struct connection *connection)
 	return ERROR_OK;
 }
 
+/* size of the binary frame being received, as far as it is known yet */
+static uint32_t tcl_binary_frame_size(struct tcl_connection *tclc)
+{
+	const uint8_t *frame = (const uint8_t *)tclc->tc_line;
+
+	if (tclc->tc_lineoffset < TCL_BIN_REQUEST_SIZE || frame[1] != 'w')
+		return TCL_BIN_REQUEST_SIZE;
+
+	return TCL_BIN_REQUEST_SIZE + le_to_h_u32(frame + 14);
+}
+
+static int tcl_binary_execute(struct connection *connection)
+{
+	struct tcl_connection *tclc = connection->priv;
+	const uint8_t *frame = (const uint8_t *)tclc->tc_line;
+	uint8_t op = frame[1];
+	uint32_t tag = le_to_h_u32(frame + 2);
+	target_addr_t address = le_to_h_u64(frame + 6);
+	uint32_t length = le_to_h_u32(frame + 14);
+	struct target *target = get_current_target_or_null(connection->cmd_ctx);
+	uint8_t header[TCL_BIN_RESPONSE_SIZE];
+	uint8_t *response = header;
+	int retval;
+
+	if (!target) {
+		retval = ERROR_TARGET_NOT_EXAMINED;
+		length = 0;
+	} else if (op == 'r' && length <= TCL_BIN_DATA_MAX) {
+		response = malloc(TCL_BIN_RESPONSE_SIZE + length);
+		if (!response) {
+			response = header;
+			retval = ERROR_FAIL;
+			length = 0;
+		} else {
+			retval = target_read_buffer(target, address, length,
+				response + TCL_BIN_RESPONSE_SIZE);
+			if (retval != ERROR_OK)
+				length = 0;
+		}
+	} else if (op == 'w') {
+		retval = target_write_buffer(target, address, length,
+			frame + TCL_BIN_REQUEST_SIZE);
+		length = 0;
+	} else {
+		retval = ERROR_COMMAND_ARGUMENT_INVALID;
+		length = 0;
+	}
+
+	response[0] = TCL_BIN_MAGIC;
+	response[1] = op;
+	h_u32_to_le(response + 2, tag);
+	h_u32_to_le(response + 6, (uint32_t)retval);
+	h_u32_to_le(response + 10, length);
+	retval = tcl_output(connection, response, TCL_BIN_RESPONSE_SIZE + length);
+
+	if (response != header)
+		free(response);
+
+	return retval;
+}
+
+/*
+ * Consume up to @a len bytes of a binary frame, executing the frame once it
+ * is complete. @a used returns how many bytes belonged to the frame.
+ */
+static int tcl_binary_input(struct connection *connection,
+		const uint8_t *data, ssize_t len, ssize_t *used)
+{
+	struct tcl_connection *tclc = connection->priv;
+
+	*used = 0;
+	while (*used < len) {
+		uint32_t size = tcl_binary_frame_size(tclc);
+		if (size > TCL_LINE_MAX) {
+			LOG_ERROR("binary frame too long, dropping connection");
+			return ERROR_SERVER_REMOTE_CLOSED;
+		}
+
+		if ((uint32_t)tclc->tc_line_size < size) {
+			char *tc_line_new = realloc(tclc->tc_line, size);
+			if (!tc_line_new)
+				return ERROR_SERVER_REMOTE_CLOSED;
+			tclc->tc_line = tc_line_new;
+			tclc->tc_line_size = size;
+		}
+
+		ssize_t chunk = MIN(len - *used, (ssize_t)(size - tclc->tc_lineoffset));
+		memcpy(tclc->tc_line + tclc->tc_lineoffset, data + *used, chunk);
+		tclc->tc_lineoffset += chunk;
+		*used += chunk;
+
+		/* the header may have just revealed a payload to wait for */
+		if ((uint32_t)tclc->tc_lineoffset == tcl_binary_frame_size(tclc)) {
+			tclc->tc_lineoffset = 0;
+			tclc->tc_binary = false;
+			return tcl_binary_execute(connection);
+		}
+	}
+
+	return ERROR_OK;
+}
+
 static int tcl_input(struct connection *connection)
 {
 	Jim_Interp *interp = (Jim_Interp *)connection->cmd_ctx->interp;
@@ -169,7 +286,7 @@ static int tcl_input(struct connection *connection)
 	const char *result;
 	int reslen;
 	struct tcl_connection *tclc;
-	unsigned char in[256];
+	unsigned char in[4096];
 	char *tc_line_new;
 	int tc_line_size_new;
 
@@ -186,6 +303,18 @@ static int tcl_input(struct connection *connection)
 
 	/* push as much data into the line as possible */
 	for (i = 0; i < rlen; i++) {
+		if (tclc->tc_lineoffset == 0 && !tclc->tc_linedrop && in[i] == TCL_BIN_MAGIC)
+			tclc->tc_binary = true;
+
+		if (tclc->tc_binary) {
+			ssize_t used;
+			retval = tcl_binary_input(connection, in + i, rlen - i, &used);
+			if (retval != ERROR_OK)
+				return retval;
+			i += used - 1;
+			continue;
+		}
+
 		/* buffer the data */
 		tclc->tc_line[tclc->tc_lineoffset] = in[i];
 		if (tclc->tc_lineoffset + 1 < tclc->tc_line_size) {
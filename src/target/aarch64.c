@@ -21,6 +21,9 @@
 #include "arm_semihosting.h"
 #include "jtag/interface.h"
 #include "smp.h"
+#include "algorithm.h"
+#include "image.h"
+#include <helper/align.h>
 #include <helper/nvp.h>
 #include <helper/time_support.h>
 
@@ -208,6 +211,34 @@ static int aarch64_read_prsr(struct target *target, uint32_t *prsr)
 	return ERROR_OK;
 }
 
+static int aarch64_poll_prefetch(struct target *target)
+{
+	struct armv8_common *armv8 = target_to_armv8(target);
+
+	return mem_ap_read_u32(armv8->debug_ap,
+			armv8->debug_base + CPUV8_DBG_PRSR, &armv8->prsr_prefetch);
+}
+
+static int aarch64_poll_prefetch_run(struct target *target)
+{
+	struct armv8_common *armv8 = target_to_armv8(target);
+
+	return dap_run(armv8->debug_ap->dap);
+}
+
+/* PRSR for a poll, possibly read together with the other cores on this DAP */
+static int aarch64_read_prsr_polled(struct target *target, uint32_t *prsr)
+{
+	struct armv8_common *armv8 = target_to_armv8(target);
+
+	if (!target_poll_take_prefetch(target))
+		return aarch64_read_prsr(target, prsr);
+
+	*prsr = armv8->prsr_prefetch;
+	armv8->sticky_reset |= *prsr & PRSR_SR;
+	return ERROR_OK;
+}
+
 /*
  * Basic debug access, very low level assumes state is saved
  */
@@ -534,7 +565,7 @@ static int aarch64_poll_smp(struct target *target, bool smp,
 	int retval = ERROR_OK;
 	uint32_t prsr;
 
-	retval = aarch64_read_prsr(target, &prsr);
+	retval = aarch64_read_prsr_polled(target, &prsr);
 	if (retval != ERROR_OK)
 		return retval;
 
@@ -2614,6 +2645,250 @@ static int aarch64_write_memory(struct target *target, target_addr_t address,
 	return aarch64_write_cpu_memory(target, address, size, count, buffer);
 }
 
+/*
+ * Runs a piece of AArch64 code on this PE only, the other PEs of a SMP group
+ * stay halted.  The code must end with a HLT instruction, at exit_point if
+ * that is given.  Interrupts are masked while it runs.
+ */
+static int aarch64_run_algorithm(struct target *target,
+	int num_mem_params, struct mem_param *mem_params,
+	int num_reg_params, struct reg_param *reg_params,
+	target_addr_t entry_point, target_addr_t exit_point,
+	unsigned int timeout_ms, void *arch_info)
+{
+	struct armv8_common *armv8 = target_to_armv8(target);
+	struct arm *arm = &armv8->arm;
+	enum target_debug_reason debug_reason = target->debug_reason;
+	uint64_t context[ARMV8_PC + 1];
+	uint32_t cpsr;
+	int retval;
+
+	if (target->state != TARGET_HALTED) {
+		LOG_TARGET_ERROR(target, "not halted (run target algo)");
+		return ERROR_TARGET_NOT_HALTED;
+	}
+
+	if (arm->core_state != ARM_STATE_AARCH64) {
+		LOG_TARGET_ERROR(target, "algorithms can only run in AArch64 state");
+		return ERROR_TARGET_INVALID;
+	}
+
+	/* save x0..x30, sp and pc, and cpsr; they'll be restored later */
+	for (unsigned int i = 0; i < ARRAY_SIZE(context); i++) {
+		struct reg *r = &arm->core_cache->reg_list[i];
+		if (!r->valid) {
+			retval = r->type->get(r);
+			if (retval != ERROR_OK)
+				return retval;
+		}
+		context[i] = buf_get_u64(r->value, 0, 64);
+	}
+	cpsr = buf_get_u32(arm->cpsr->value, 0, 32);
+
+	for (int i = 0; i < num_mem_params; i++) {
+		if (mem_params[i].direction == PARAM_IN)
+			continue;
+		retval = target_write_buffer(target, mem_params[i].address, mem_params[i].size,
+				mem_params[i].value);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	for (int i = 0; i < num_reg_params; i++) {
+		if (reg_params[i].direction == PARAM_IN)
+			continue;
+
+		struct reg *reg = register_get_by_name(arm->core_cache, reg_params[i].reg_name, false);
+		if (!reg) {
+			LOG_TARGET_ERROR(target, "BUG: register '%s' not found", reg_params[i].reg_name);
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		}
+
+		if (reg->size != reg_params[i].size) {
+			LOG_TARGET_ERROR(target, "BUG: register '%s' size doesn't match reg_params[i].size",
+				reg_params[i].reg_name);
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		}
+
+		retval = reg->type->set(reg, reg_params[i].value);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	/* mask D, A, I and F */
+	armv8_set_cpsr(arm, cpsr | 0x3c0);
+	arm->cpsr->dirty = true;
+
+	/* restart this PE alone: like aarch64_step(), close its CTI gate for
+	 * channel 1 so the restart event doesn't reach the halted SMP siblings */
+	uint64_t address = entry_point;
+	retval = aarch64_restore_one(target, false, &address, false, true);
+	if (retval == ERROR_OK)
+		retval = aarch64_prepare_restart_one(target);
+	if (retval == ERROR_OK && target->smp)
+		retval = arm_cti_gate_channel(armv8->cti, 1);
+	if (retval == ERROR_OK)
+		retval = aarch64_do_restart_one(target, RESTART_SYNC);
+	if (retval != ERROR_OK)
+		return retval;
+	target->state = TARGET_DEBUG_RUNNING;
+	target_call_event_callbacks(target, TARGET_EVENT_DEBUG_RESUMED);
+
+	retval = target_wait_state(target, TARGET_HALTED, timeout_ms);
+	if (retval != ERROR_OK || target->state != TARGET_HALTED) {
+		LOG_TARGET_ERROR(target, "algorithm timed out, halting");
+		retval = aarch64_halt_one(target, HALT_SYNC);
+		if (retval == ERROR_OK)
+			retval = aarch64_poll(target);
+		if (retval != ERROR_OK)
+			return retval;
+		retval = ERROR_TARGET_TIMEOUT;
+	} else if (exit_point && buf_get_u64(arm->pc->value, 0, 64) != exit_point) {
+		LOG_TARGET_ERROR(target, "algorithm halted at 0x%" PRIx64 ", expected " TARGET_ADDR_FMT,
+			buf_get_u64(arm->pc->value, 0, 64), exit_point);
+		retval = ERROR_TARGET_TIMEOUT;
+	}
+
+	for (int i = 0; retval == ERROR_OK && i < num_mem_params; i++) {
+		if (mem_params[i].direction != PARAM_OUT)
+			retval = target_read_buffer(target, mem_params[i].address,
+					mem_params[i].size, mem_params[i].value);
+	}
+
+	for (int i = 0; retval == ERROR_OK && i < num_reg_params; i++) {
+		if (reg_params[i].direction == PARAM_OUT)
+			continue;
+
+		struct reg *reg = register_get_by_name(arm->core_cache, reg_params[i].reg_name, false);
+		if (!reg || reg->size != reg_params[i].size) {
+			LOG_TARGET_ERROR(target, "BUG: register '%s' not found or size mismatch",
+				reg_params[i].reg_name);
+			retval = ERROR_COMMAND_SYNTAX_ERROR;
+			break;
+		}
+		if (!reg->valid)
+			retval = reg->type->get(reg);
+		buf_cpy(reg->value, reg_params[i].value, reg_params[i].size);
+	}
+
+	/* restore everything we saved before */
+	for (unsigned int i = 0; i < ARRAY_SIZE(context); i++) {
+		struct reg *r = &arm->core_cache->reg_list[i];
+		if (r->valid && buf_get_u64(r->value, 0, 64) == context[i])
+			continue;
+		buf_set_u64(r->value, 0, 64, context[i]);
+		r->valid = true;
+		r->dirty = true;
+	}
+	armv8_set_cpsr(arm, cpsr);
+	arm->cpsr->dirty = true;
+
+	target->debug_reason = debug_reason;
+
+	return retval;
+}
+
+/** Generates a CRC32 checksum of a memory region. */
+static int aarch64_checksum_memory(struct target *target,
+	target_addr_t address, uint32_t count, uint32_t *checksum)
+{
+	struct armv8_common *armv8 = target_to_armv8(target);
+	struct working_area *crc_algorithm;
+	struct reg_param reg_params[4];
+	uint32_t crc = 0xffffffff;
+	bool use_table = true;
+	int retval;
+
+	static const uint8_t aarch64_crc_code[] = {
+#include "../../contrib/loaders/checksum/armv8_crc.inc"
+	};
+	static const uint8_t aarch64_crc_table_code[] = {
+#include "../../contrib/loaders/checksum/armv8_crc_table.inc"
+	};
+	const uint32_t table_offset = ALIGN_UP(sizeof(aarch64_crc_table_code), 8);
+
+	/* Small blocks are faster to read back, target_checksum_memory()
+	 * does that if we fail. */
+	if (armv8->arm.core_state != ARM_STATE_AARCH64 || count < sizeof(aarch64_crc_code) * 4)
+		return ERROR_FAIL;
+
+	/* Prefer the table driven loader, it needs another 1 KiB of working area */
+	retval = target_alloc_working_area_try(target, table_offset + 256 * 4, &crc_algorithm);
+	if (retval != ERROR_OK) {
+		use_table = false;
+		retval = target_alloc_working_area(target, sizeof(aarch64_crc_code), &crc_algorithm);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	if (crc_algorithm->address + crc_algorithm->size > address &&
+			crc_algorithm->address < address + count) {
+		target_free_working_area(target, crc_algorithm);
+		return ERROR_FAIL;
+	}
+
+	const uint8_t *code = use_table ? aarch64_crc_table_code : aarch64_crc_code;
+	uint32_t code_size = use_table ? sizeof(aarch64_crc_table_code) : sizeof(aarch64_crc_code);
+
+	retval = target_write_buffer(target, crc_algorithm->address, code_size, code);
+	if (retval == ERROR_OK && use_table) {
+		uint8_t table[256 * 4];
+		target_buffer_set_u32_array(target, table, 256, image_crc32_table());
+		retval = target_write_buffer(target, crc_algorithm->address + table_offset,
+			sizeof(table), table);
+	}
+	/* the code went in through the data side */
+	if (retval == ERROR_OK)
+		retval = armv8_cache_d_inner_flush_virt(armv8, crc_algorithm->address, code_size);
+	if (retval == ERROR_OK)
+		retval = armv8_cache_i_inner_inval_virt(armv8, crc_algorithm->address, code_size);
+	if (retval != ERROR_OK) {
+		target_free_working_area(target, crc_algorithm);
+		return retval;
+	}
+
+	init_reg_param(&reg_params[0], "x0", 64, PARAM_IN_OUT);
+	init_reg_param(&reg_params[1], "x1", 64, PARAM_OUT);
+	init_reg_param(&reg_params[2], "x2", 64, PARAM_OUT);
+	init_reg_param(&reg_params[3], "x3", 64, PARAM_OUT);
+	buf_set_u64(reg_params[3].value, 0, 64, crc_algorithm->address + table_offset);
+
+	while (count > 0) {
+		uint32_t n = MIN(count, TARGET_CHECKSUM_ALGO_CHUNK);
+
+		buf_set_u64(reg_params[0].value, 0, 64, crc);
+		buf_set_u64(reg_params[1].value, 0, 64, address);
+		buf_set_u64(reg_params[2].value, 0, 64, n);
+
+		/* 20 second timeout/megabyte */
+		unsigned int timeout = 20000 * (1 + (n / (1024 * 1024)));
+
+		retval = target_run_algorithm(target, 0, NULL, use_table ? 4 : 3, reg_params,
+			crc_algorithm->address, crc_algorithm->address + code_size - 4,
+			timeout, NULL);
+		if (retval != ERROR_OK) {
+			LOG_TARGET_ERROR(target, "error executing aarch64 crc algorithm");
+			break;
+		}
+
+		crc = buf_get_u32(reg_params[0].value, 0, 32);
+		address += n;
+		count -= n;
+	}
+
+	if (retval == ERROR_OK)
+		*checksum = crc;
+
+	destroy_reg_param(&reg_params[0]);
+	destroy_reg_param(&reg_params[1]);
+	destroy_reg_param(&reg_params[2]);
+	destroy_reg_param(&reg_params[3]);
+
+	target_free_working_area(target, crc_algorithm);
+
+	return retval;
+}
+
 static int aarch64_handle_target_request(void *priv)
 {
 	struct target *target = priv;
@@ -3280,6 +3555,8 @@ struct target_type aarch64_target = {
 	.name = "aarch64",
 
 	.poll = aarch64_poll,
+	.poll_prefetch = aarch64_poll_prefetch,
+	.poll_prefetch_run = aarch64_poll_prefetch_run,
 	.arch_state = armv8_arch_state,
 
 	.halt = aarch64_halt,
@@ -3295,6 +3572,9 @@ struct target_type aarch64_target = {
 
 	.read_memory = aarch64_read_memory,
 	.write_memory = aarch64_write_memory,
+	.checksum_memory = aarch64_checksum_memory,
+
+	.run_algorithm = aarch64_run_algorithm,
 
 	.add_breakpoint = aarch64_add_breakpoint,
 	.add_context_breakpoint = aarch64_add_context_breakpoint,
@@ -3321,6 +3601,8 @@ struct target_type armv8r_target = {
 	.name = "armv8r",
 
 	.poll = aarch64_poll,
+	.poll_prefetch = aarch64_poll_prefetch,
+	.poll_prefetch_run = aarch64_poll_prefetch_run,
 	.arch_state = armv8_arch_state,
 
 	.halt = aarch64_halt,
@@ -274,7 +274,7 @@ static int arm720t_read_memory(struct target *target,
 		if (retval != ERROR_OK)
 			return retval;
 	}
-	retval = arm7_9_read_memory(target, address, size, count, buffer);
+	retval = arm7_9_read_memory_opt(target, address, size, count, buffer);
 
 	if (arm720t->armv4_5_mmu.armv4_5_cache.d_u_cache_enabled) {
 		retval = arm720t_enable_mmu_caches(target, 0, 1, 0);
@@ -601,19 +601,13 @@ int arm7_9_remove_watchpoint(struct target *target, struct watchpoint *watchpoin
 
 /**
  * Restarts the target by sending a RESTART instruction and moving the JTAG
- * state to IDLE.  This includes a timeout waiting for DBGACK and SYSCOMP to be
- * asserted by the processor.
- *
- * @param target Pointer to target to issue commands to
- * @return Error status if there is a timeout or a problem while executing the
- * JTAG queue
+ * state to IDLE, without waiting for the system speed access to complete.
  */
-int arm7_9_execute_sys_speed(struct target *target)
+static int arm7_9_restart_sys_speed(struct target *target)
 {
 	int retval;
 	struct arm7_9_common *arm7_9 = target_to_arm7_9(target);
 	struct arm_jtag *jtag_info = &arm7_9->jtag_info;
-	struct reg *dbg_stat = &arm7_9->eice_cache->reg_list[EICE_DBG_STAT];
 
 	/* set RESTART instruction */
 	if (arm7_9->need_bypass_before_restart) {
@@ -622,9 +616,17 @@ int arm7_9_execute_sys_speed(struct target *target)
 		if (retval != ERROR_OK)
 			return retval;
 	}
-	retval = arm_jtag_set_instr(jtag_info->tap, 0x4, NULL, TAP_IDLE);
-	if (retval != ERROR_OK)
-		return retval;
+	return arm_jtag_set_instr(jtag_info->tap, 0x4, NULL, TAP_IDLE);
+}
+
+/**
+ * Waits for DBGACK and SYSCOMP to be asserted after a system speed access.
+ */
+static int arm7_9_wait_sys_speed(struct target *target)
+{
+	int retval;
+	struct arm7_9_common *arm7_9 = target_to_arm7_9(target);
+	struct reg *dbg_stat = &arm7_9->eice_cache->reg_list[EICE_DBG_STAT];
 
 	int64_t then = timeval_ms();
 	bool timeout;
@@ -651,6 +653,26 @@ int arm7_9_execute_sys_speed(struct target *target)
 	return ERROR_OK;
 }
 
+/**
+ * Restarts the target by sending a RESTART instruction and moving the JTAG
+ * state to IDLE.  This includes a timeout waiting for DBGACK and SYSCOMP to be
+ * asserted by the processor.
+ *
+ * @param target Pointer to target to issue commands to
+ * @return Error status if there is a timeout or a problem while executing the
+ * JTAG queue
+ */
+int arm7_9_execute_sys_speed(struct target *target)
+{
+	int retval;
+
+	retval = arm7_9_restart_sys_speed(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	return arm7_9_wait_sys_speed(target);
+}
+
 /**
  * Restarts the target by sending a RESTART instruction and moving the JTAG
  * state to IDLE.  This validates that DBGACK and SYSCOMP are set without
@@ -665,18 +687,10 @@ static int arm7_9_execute_fast_sys_speed(struct target *target)
 	static uint8_t check_value[4], check_mask[4];
 
 	struct arm7_9_common *arm7_9 = target_to_arm7_9(target);
-	struct arm_jtag *jtag_info = &arm7_9->jtag_info;
 	struct reg *dbg_stat = &arm7_9->eice_cache->reg_list[EICE_DBG_STAT];
 	int retval;
 
-	/* set RESTART instruction */
-	if (arm7_9->need_bypass_before_restart) {
-		arm7_9->need_bypass_before_restart = 0;
-		retval = arm_jtag_set_instr(jtag_info->tap, 0xf, NULL, TAP_IDLE);
-		if (retval != ERROR_OK)
-			return retval;
-	}
-	retval = arm_jtag_set_instr(jtag_info->tap, 0x4, NULL, TAP_IDLE);
+	retval = arm7_9_restart_sys_speed(target);
 	if (retval != ERROR_OK)
 		return retval;
 
@@ -865,6 +879,12 @@ int arm7_9_assert_reset(struct target *target)
 	enum reset_types jtag_reset_config = jtag_get_reset_config();
 	bool use_event = false;
 
+	/* clocks are likely to change after reset, probe again */
+	if (arm7_9->fast_memory_access_auto) {
+		arm7_9->fast_memory_access = false;
+		arm7_9->fast_memory_access_probed = false;
+	}
+
 	/* TODO: apply hw reset signal in not examined state */
 	if (!(target_was_examined(target))) {
 		LOG_WARNING("Reset is not asserted because the target is not examined.");
@@ -2100,6 +2120,68 @@ static int arm7_9_write_core_reg(struct target *target, struct reg *r,
 	return jtag_execute_queue();
 }
 
+/* number of loads that must pass for 'fast_memory_access auto' to enable it */
+#define ARM7_9_FAST_MEMORY_PROBES 8
+
+/**
+ * Checks whether system speed loads from the working area complete before
+ * the debug status can be scanned out again, i.e. whether fast memory access
+ * is safe with the current JTAG and core clocks. The working area is used
+ * so that the probe never reads from a peripheral. Fast memory access is
+ * only enabled if all samples pass. Clobbers r0 and r1.
+ */
+static int arm7_9_probe_fast_memory_access(struct target *target)
+{
+	struct arm7_9_common *arm7_9 = target_to_arm7_9(target);
+	struct reg *dbg_stat = &arm7_9->eice_cache->reg_list[EICE_DBG_STAT];
+	struct working_area *area;
+	uint32_t reg[16];
+	bool fast = true;
+	int retval = ERROR_OK;
+
+	/* probe once per reset, whatever the outcome; this also keeps the
+	 * memory reads done to allocate the working area from probing again */
+	arm7_9->fast_memory_access_probed = true;
+
+	if (target_alloc_working_area(target, 4, &area) != ERROR_OK) {
+		LOG_TARGET_DEBUG(target, "no working area, fast memory access stays disabled");
+		return ERROR_OK;
+	}
+
+	for (unsigned int i = 0; i < ARM7_9_FAST_MEMORY_PROBES && fast; i++) {
+		/* the load writes back the incremented base address */
+		reg[0] = area->address;
+		arm7_9->write_core_regs(target, 0x1, reg);
+
+		arm7_9->load_word_regs(target, 0x2);
+		retval = arm7_9_restart_sys_speed(target);
+		if (retval != ERROR_OK)
+			break;
+		embeddedice_read_reg(dbg_stat);
+		retval = jtag_execute_queue();
+		if (retval != ERROR_OK)
+			break;
+
+		fast = buf_get_u32(dbg_stat->value, EICE_DBG_STATUS_DBGACK, 1) &&
+			buf_get_u32(dbg_stat->value, EICE_DBG_STATUS_SYSCOMP, 1);
+
+		/* the probe access may still be in progress */
+		if (!fast)
+			retval = arm7_9_wait_sys_speed(target);
+	}
+
+	target_free_working_area(target, area);
+
+	if (retval != ERROR_OK)
+		return retval;
+
+	arm7_9->fast_memory_access = fast;
+	LOG_TARGET_DEBUG(target, "fast memory access %s",
+		arm7_9->fast_memory_access ? "enabled" : "disabled");
+
+	return ERROR_OK;
+}
+
 int arm7_9_read_memory(struct target *target,
 	target_addr_t address,
 	uint32_t size,
@@ -2131,6 +2213,12 @@ int arm7_9_read_memory(struct target *target,
 	if (((size == 4) && (address & 0x3u)) || ((size == 2) && (address & 0x1u)))
 		return ERROR_TARGET_UNALIGNED_ACCESS;
 
+	if (arm7_9->fast_memory_access_auto && !arm7_9->fast_memory_access_probed) {
+		retval = arm7_9_probe_fast_memory_access(target);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
 	/* load the base register with the address of the first word */
 	reg[0] = address;
 	arm7_9->write_core_regs(target, 0x1, reg);
@@ -2479,6 +2567,28 @@ int arm7_9_write_memory(struct target *target,
 	return ERROR_OK;
 }
 
+/**
+ * Splits a naturally aligned access into a head and a tail that are done
+ * with the requested access size, and a word aligned middle part of more
+ * than 32 words that is worth transferring through the DCC.
+ *
+ * @return true if the access should use the bulk transfer
+ */
+static bool arm7_9_split_bulk_access(target_addr_t address, uint32_t size,
+	uint32_t count, uint32_t *head, uint32_t *words, uint32_t *tail)
+{
+	uint32_t len = size * count;
+
+	if (address % size != 0 || len <= 32 * 4)
+		return false;
+
+	*head = (4 - (address & 0x3u)) & 0x3u;
+	*words = (len - *head) / 4;
+	*tail = len - *head - *words * 4;
+
+	return *words > 32;
+}
+
 int arm7_9_write_memory_opt(struct target *target,
 	target_addr_t address,
 	uint32_t size,
@@ -2486,17 +2596,69 @@ int arm7_9_write_memory_opt(struct target *target,
 	const uint8_t *buffer)
 {
 	struct arm7_9_common *arm7_9 = target_to_arm7_9(target);
+	uint32_t head, words, tail;
 	int retval;
 
-	if (size == 4 && count > 32 && arm7_9->bulk_write_memory) {
-		/* Attempt to do a bulk write */
-		retval = arm7_9->bulk_write_memory(target, address, count, buffer);
+	if (!arm7_9->bulk_write_memory ||
+			!arm7_9_split_bulk_access(address, size, count, &head, &words, &tail))
+		return arm7_9->write_memory(target, address, size, count, buffer);
 
-		if (retval == ERROR_OK)
-			return ERROR_OK;
+	if (head) {
+		retval = arm7_9->write_memory(target, address, size, head / size, buffer);
+		if (retval != ERROR_OK)
+			return retval;
 	}
 
-	return arm7_9->write_memory(target, address, size, count, buffer);
+	/* Attempt to do a bulk write */
+	retval = arm7_9->bulk_write_memory(target, address + head, words, buffer + head);
+	if (retval != ERROR_OK) {
+		retval = arm7_9->write_memory(target, address + head, size,
+				words * 4 / size, buffer + head);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	if (tail)
+		return arm7_9->write_memory(target, address + head + words * 4,
+				size, tail / size, buffer + head + words * 4);
+
+	return ERROR_OK;
+}
+
+int arm7_9_read_memory_opt(struct target *target,
+	target_addr_t address,
+	uint32_t size,
+	uint32_t count,
+	uint8_t *buffer)
+{
+	struct arm7_9_common *arm7_9 = target_to_arm7_9(target);
+	uint32_t head, words, tail;
+	int retval;
+
+	if (!arm7_9->bulk_read_memory ||
+			!arm7_9_split_bulk_access(address, size, count, &head, &words, &tail))
+		return arm7_9_read_memory(target, address, size, count, buffer);
+
+	if (head) {
+		retval = arm7_9_read_memory(target, address, size, head / size, buffer);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	/* Attempt to do a bulk read */
+	retval = arm7_9->bulk_read_memory(target, address + head, words, buffer + head);
+	if (retval != ERROR_OK) {
+		retval = arm7_9_read_memory(target, address + head, size,
+				words * 4 / size, buffer + head);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	if (tail)
+		return arm7_9_read_memory(target, address + head + words * 4,
+				size, tail / size, buffer + head + words * 4);
+
+	return ERROR_OK;
 }
 
 int arm7_9_write_memory_no_opt(struct target *target,
@@ -2648,6 +2810,143 @@ int arm7_9_bulk_write_memory(struct target *target,
 	return retval;
 }
 
+static uint8_t *dcc_read_buffer;
+
+static int arm7_9_dcc_read_completion(struct target *target,
+	uint32_t exit_point,
+	unsigned int timeout_ms,
+	void *arch_info)
+{
+	int retval = ERROR_OK;
+	struct arm7_9_common *arm7_9 = target_to_arm7_9(target);
+	uint32_t data[256];
+
+	retval = target_wait_state(target, TARGET_DEBUG_RUNNING, 500);
+	if (retval != ERROR_OK)
+		return retval;
+
+	/* receive the data in blocks, each read with a single JTAG queue */
+	int count = dcc_count;
+	uint8_t *buffer = dcc_read_buffer;
+	while (count > 0) {
+		int thisrun = MIN(count, (int)ARRAY_SIZE(data));
+
+		retval = embeddedice_receive(&arm7_9->jtag_info, data, thisrun);
+		if (retval != ERROR_OK)
+			break;
+		target_buffer_set_u32_array(target, buffer, thisrun, data);
+
+		buffer += thisrun * 4;
+		count -= thisrun;
+
+		keep_alive();
+	}
+
+	if (retval == ERROR_OK)
+		retval = target_wait_state(target, TARGET_HALTED, 500);
+	if (retval != ERROR_OK && target->state != TARGET_HALTED) {
+		/* stub didn't reach its exit point, don't leave it running */
+		if (target_halt(target) == ERROR_OK)
+			target_wait_state(target, TARGET_HALTED, 500);
+	}
+
+	return retval;
+}
+
+static const uint32_t dcc_read_code[] = {
+	/* r0 == input, points to memory buffer
+	 * r1 == scratch
+	 * r2 == input, number of words to send
+	 */
+
+	/* spin until DCC control (c0) reports the last word was taken */
+	0xee101e10,	/* w: mrc p14, #0, r1, c0, c0 */
+	0xe3110002,	/*    tst r1, #2              */
+	0x1afffffc,	/*    bne w                   */
+
+	/* read word from memory, write to DCC (c1) */
+	0xe4901004,	/*    ldr r1, [r0], #4        */
+	0xee011e10,	/*    mcr p14, #0, r1, c1, c0 */
+
+	/* repeat until done */
+	0xe2522001,	/*    subs r2, r2, #1         */
+	0x1afffff8,	/*    bne w                   */
+	0xeafffffe	/* e: b   e                   */
+};
+
+int arm7_9_bulk_read_memory(struct target *target,
+	target_addr_t address,
+	uint32_t count,
+	uint8_t *buffer)
+{
+	int retval;
+	struct arm7_9_common *arm7_9 = target_to_arm7_9(target);
+
+	if (address % 4 != 0)
+		return ERROR_TARGET_UNALIGNED_ACCESS;
+
+	if (!arm7_9->dcc_downloads)
+		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+
+	/* regrab previously allocated working_area, or allocate a new one */
+	if (!arm7_9->dcc_read_working_area) {
+		uint8_t dcc_code_buf[ARRAY_SIZE(dcc_read_code) * 4];
+
+		/* make sure we have a working area */
+		if (target_alloc_working_area(target, sizeof(dcc_code_buf),
+				&arm7_9->dcc_read_working_area) != ERROR_OK) {
+			LOG_INFO("no working area available, falling back to memory reads");
+			return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+		}
+
+		/* copy target instructions to target endianness */
+		target_buffer_set_u32_array(target, dcc_code_buf,
+				ARRAY_SIZE(dcc_read_code), dcc_read_code);
+
+		retval = arm7_9_write_memory_no_opt(target,
+				arm7_9->dcc_read_working_area->address, 4,
+				ARRAY_SIZE(dcc_read_code), dcc_code_buf);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	struct arm_algorithm arm_algo;
+	struct reg_param reg_params[2];
+
+	arm_algo.common_magic = ARM_COMMON_MAGIC;
+	arm_algo.core_mode = ARM_MODE_SVC;
+	arm_algo.core_state = ARM_STATE_ARM;
+
+	init_reg_param(&reg_params[0], "r0", 32, PARAM_IN_OUT);
+	init_reg_param(&reg_params[1], "r2", 32, PARAM_IN_OUT);
+
+	buf_set_u32(reg_params[0].value, 0, 32, address);
+	buf_set_u32(reg_params[1].value, 0, 32, count);
+
+	dcc_count = count;
+	dcc_read_buffer = buffer;
+	retval = armv4_5_run_algorithm_inner(target, 0, NULL, 2, reg_params,
+			arm7_9->dcc_read_working_area->address,
+			arm7_9->dcc_read_working_area->address + 7 * 4,
+			20 * 1000, &arm_algo, arm7_9_dcc_read_completion);
+
+	if (retval == ERROR_OK) {
+		uint32_t endaddress = buf_get_u32(reg_params[0].value, 0, 32);
+		if (endaddress != (address + count * 4)) {
+			LOG_ERROR(
+				"DCC read failed, expected end address 0x%08" TARGET_PRIxADDR " got 0x%0" PRIx32,
+				(address + count * 4),
+				endaddress);
+			retval = ERROR_FAIL;
+		}
+	}
+
+	destroy_reg_param(&reg_params[1]);
+	destroy_reg_param(&reg_params[0]);
+
+	return retval;
+}
+
 /**
  * Perform per-target setup that requires JTAG access.
  */
@@ -2703,7 +3002,8 @@ int arm7_9_check_reset(struct target *target)
 	if (get_target_reset_nag() && (target->working_area_size == 0))
 		LOG_WARNING("NOTE! Severe performance degradation without working memory enabled.");
 
-	if (get_target_reset_nag() && !arm7_9->fast_memory_access)
+	if (get_target_reset_nag() && !arm7_9->fast_memory_access &&
+			!arm7_9->fast_memory_access_auto)
 		LOG_WARNING(
 			"NOTE! Severe performance degradation without fast memory access enabled. Type 'help fast'.");
 
@@ -2780,12 +3080,27 @@ COMMAND_HANDLER(handle_arm7_9_fast_memory_access_command)
 		return ERROR_TARGET_INVALID;
 	}
 
-	if (CMD_ARGC > 0)
-		COMMAND_PARSE_ENABLE(CMD_ARGV[0], arm7_9->fast_memory_access);
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
 
-	command_print(CMD,
-		"fast memory access is %s",
-		(arm7_9->fast_memory_access) ? "enabled" : "disabled");
+	if (CMD_ARGC == 1) {
+		arm7_9->fast_memory_access_probed = false;
+		if (strcmp(CMD_ARGV[0], "auto") == 0) {
+			arm7_9->fast_memory_access_auto = true;
+			arm7_9->fast_memory_access = false;
+		} else {
+			arm7_9->fast_memory_access_auto = false;
+			COMMAND_PARSE_ENABLE(CMD_ARGV[0], arm7_9->fast_memory_access);
+		}
+	}
+
+	if (arm7_9->fast_memory_access_auto && !arm7_9->fast_memory_access_probed)
+		command_print(CMD, "fast memory access is auto (not yet probed)");
+	else
+		command_print(CMD,
+			"fast memory access is %s%s",
+			(arm7_9->fast_memory_access_auto) ? "auto, " : "",
+			(arm7_9->fast_memory_access) ? "enabled" : "disabled");
 
 	return ERROR_OK;
 }
@@ -2854,6 +3169,7 @@ int arm7_9_init_arch_info(struct target *target, struct arm7_9_common *arm7_9)
 	arm7_9->wp_available_max = 2;
 
 	arm7_9->fast_memory_access = false;
+	arm7_9->fast_memory_access_auto = false;
 	arm7_9->dcc_downloads = false;
 
 	arm->arch_info = arm7_9;
@@ -2884,16 +3200,17 @@ static const struct command_registration arm7_9_any_command_handlers[] = {
 		.name = "fast_memory_access",
 		.handler = handle_arm7_9_fast_memory_access_command,
 		.mode = COMMAND_ANY,
-		.usage = "['enable'|'disable']",
+		.usage = "['enable'|'disable'|'auto']",
 		.help = "use fast memory accesses instead of slower "
-			"but potentially safer accesses",
+			"but potentially safer accesses, or probe whether "
+			"they are safe",
 	},
 	{
 		.name = "dcc_downloads",
 		.handler = handle_arm7_9_dcc_downloads_command,
 		.mode = COMMAND_ANY,
 		.usage = "['enable'|'disable']",
-		.help = "use DCC downloads for larger memory writes",
+		.help = "use DCC transfers for larger memory writes and reads",
 	},
 	COMMAND_REGISTRATION_DONE
 };
@@ -55,9 +55,12 @@ struct arm7_9_common {
 	bool debug_entry_from_reset; /**< Specifies if debug entry was from a reset */
 
 	bool fast_memory_access;
+	bool fast_memory_access_auto; /**< probe whether fast memory access is safe */
+	bool fast_memory_access_probed;
 	bool dcc_downloads;
 
 	struct working_area *dcc_working_area;
+	struct working_area *dcc_read_working_area;
 
 	int (*examine_debug_reason)(struct target *target);
 	/**< Function for determining why debug state was entered */
@@ -120,6 +123,12 @@ struct arm7_9_common {
 	 */
 	int (*bulk_write_memory)(struct target *target, target_addr_t address,
 			uint32_t count, const uint8_t *buffer);
+	/**
+	 * Read target memory in multiples of 4 bytes, optimized for
+	 * reading large quantities of data.
+	 */
+	int (*bulk_read_memory)(struct target *target, target_addr_t address,
+			uint32_t count, uint8_t *buffer);
 };
 
 static inline struct arm7_9_common *target_to_arm7_9(struct target *target)
@@ -151,6 +160,8 @@ int arm7_9_step(struct target *target, bool current, target_addr_t address,
 		bool handle_breakpoints);
 int arm7_9_read_memory(struct target *target, target_addr_t address,
 		uint32_t size, uint32_t count, uint8_t *buffer);
+int arm7_9_read_memory_opt(struct target *target, target_addr_t address,
+		uint32_t size, uint32_t count, uint8_t *buffer);
 int arm7_9_write_memory(struct target *target, target_addr_t address,
 		uint32_t size, uint32_t count, const uint8_t *buffer);
 int arm7_9_write_memory_opt(struct target *target, target_addr_t address,
@@ -159,6 +170,8 @@ int arm7_9_write_memory_no_opt(struct target *target, uint32_t address,
 		uint32_t size, uint32_t count, const uint8_t *buffer);
 int arm7_9_bulk_write_memory(struct target *target, target_addr_t address,
 		uint32_t count, const uint8_t *buffer);
+int arm7_9_bulk_read_memory(struct target *target, target_addr_t address,
+		uint32_t count, uint8_t *buffer);
 
 int arm7_9_run_algorithm(struct target *target, int num_mem_params,
 		struct mem_param *mem_params, int num_reg_prams,
@@ -558,7 +558,7 @@ int arm920t_read_memory(struct target *target, target_addr_t address,
 {
 	int retval;
 
-	retval = arm7_9_read_memory(target, address, size, count, buffer);
+	retval = arm7_9_read_memory_opt(target, address, size, count, buffer);
 
 	return retval;
 }
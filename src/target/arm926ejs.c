@@ -805,7 +805,7 @@ struct target_type arm926ejs_target = {
 	.get_gdb_arch = arm_get_gdb_arch,
 	.get_gdb_reg_list = arm_get_gdb_reg_list,
 
-	.read_memory = arm7_9_read_memory,
+	.read_memory = arm7_9_read_memory_opt,
 	.write_memory = arm7_9_write_memory_opt,
 
 	.checksum_memory = arm_checksum_memory,
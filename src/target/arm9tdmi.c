@@ -743,6 +743,7 @@ int arm9tdmi_init_arch_info(struct target *target,
 
 	arm7_9->write_memory = arm7_9_write_memory;
 	arm7_9->bulk_write_memory = arm7_9_bulk_write_memory;
+	arm7_9->bulk_read_memory = arm7_9_bulk_read_memory;
 
 	arm7_9->post_debug_entry = NULL;
 
@@ -904,7 +905,7 @@ struct target_type arm9tdmi_target = {
 	.get_gdb_arch = arm_get_gdb_arch,
 	.get_gdb_reg_list = arm_get_gdb_reg_list,
 
-	.read_memory = arm7_9_read_memory,
+	.read_memory = arm7_9_read_memory_opt,
 	.write_memory = arm7_9_write_memory_opt,
 
 	.checksum_memory = arm_checksum_memory,
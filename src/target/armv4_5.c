@@ -1680,84 +1680,156 @@ int arm_checksum_memory(struct target *target,
 }
 
 /**
- * Runs ARM code in the target to check whether a memory block holds
- * all ones.  NOR flash which has been erased, and thus may be written,
- * holds all ones.
- *
+ * Runs ARM code in the target to check whether memory blocks hold
+ * nothing but the erased value.  NOR flash which has been erased, and
+ * thus may be written, holds all ones.  As many blocks as fit into the
+ * working area are checked in a single run, a word at a time.
  */
 int arm_blank_check_memory(struct target *target,
 	struct target_memory_check_block *blocks, unsigned int num_blocks,
 	uint8_t erased_value, unsigned int *checked)
 {
 	struct working_area *check_algorithm;
-	struct reg_param reg_params[3];
+	struct working_area *check_params;
+	struct reg_param reg_params[2];
 	struct arm_algorithm arm_algo;
 	struct arm *arm = target_to_arm(target);
 	int retval;
-	uint32_t i;
+	unsigned int i;
 	uint32_t exit_var = 0;
 
+	static bool timed_out;
+
 	static const uint8_t check_code_le[] = {
 #include "../../contrib/loaders/erase_check/armv4_5_erase_check.inc"
 	};
 
 	assert(sizeof(check_code_le) % 4 == 0);
 
-	if (erased_value != 0xff) {
-		LOG_TARGET_ERROR(target, "Erase value 0x%02" PRIx8 " not yet supported for ARMv4/v5 targets",
-			erased_value);
-		return ERROR_FAIL;
+	/* the loop compares whole words */
+	for (i = 0; i < num_blocks; i++) {
+		if (blocks[i].address % 4 || blocks[i].size % 4)
+			return ERROR_NOT_IMPLEMENTED;
 	}
 
+	/* convert code into a buffer in target endianness */
+	uint8_t check_code[sizeof(check_code_le)];
+	for (i = 0; i < ARRAY_SIZE(check_code_le) / 4; i++)
+		target_buffer_set_u32(target, check_code + i * 4,
+				le_to_h_u32(&check_code_le[i * 4]));
+
 	/* make sure we have a working area */
-	retval = target_alloc_working_area(target,
-			sizeof(check_code_le), &check_algorithm);
+	retval = target_alloc_working_area_resident(target, check_code,
+			sizeof(check_code), &check_algorithm);
 	if (retval != ERROR_OK)
 		return retval;
 
-	/* convert code into a buffer in target endianness */
-	for (i = 0; i < ARRAY_SIZE(check_code_le) / 4; i++) {
-		retval = target_write_u32(target,
-				check_algorithm->address
-				+ i * sizeof(uint32_t),
-				le_to_h_u32(&check_code_le[i * 4]));
-		if (retval != ERROR_OK) {
-			target_free_working_area(target, check_algorithm);
-			return retval;
-		}
+	/* prepare blocks array for algo, same layout as the ARMv7-M one */
+	struct algo_block {
+		union {
+			uint32_t size;
+			uint32_t result;
+		};
+		uint32_t address;
+	};
+
+	unsigned int avail_blocks = target_get_working_area_avail(target) / sizeof(struct algo_block);
+	if (avail_blocks < 2) {
+		retval = ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+		goto cleanup1;
 	}
 
+	unsigned int blocks_to_check = MIN(avail_blocks - 1, num_blocks);
+	uint32_t param_size = (blocks_to_check + 1) * sizeof(struct algo_block);
+
+	struct algo_block *params = malloc(param_size);
+	if (!params) {
+		retval = ERROR_FAIL;
+		goto cleanup1;
+	}
+
+	uint32_t total_size = 0;
+	for (i = 0; i < blocks_to_check; i++) {
+		total_size += blocks[i].size;
+		target_buffer_set_u32(target, (uint8_t *)&params[i].size,
+				blocks[i].size / sizeof(uint32_t));
+		target_buffer_set_u32(target, (uint8_t *)&params[i].address,
+				blocks[i].address);
+	}
+	target_buffer_set_u32(target, (uint8_t *)&params[blocks_to_check].size, 0);
+
+	retval = target_alloc_working_area(target, param_size, &check_params);
+	if (retval != ERROR_OK) {
+		retval = ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+		goto cleanup2;
+	}
+
+	retval = target_write_buffer(target, check_params->address,
+			param_size, (uint8_t *)params);
+	if (retval != ERROR_OK)
+		goto cleanup3;
+
+	uint32_t erased_word = erased_value | (erased_value << 8)
+			       | (erased_value << 16) | (erased_value << 24);
+
+	LOG_TARGET_DEBUG(target, "Starting erase check of %u blocks, parameters@"
+		TARGET_ADDR_FMT, blocks_to_check, check_params->address);
+
 	arm_algo.common_magic = ARM_COMMON_MAGIC;
 	arm_algo.core_mode = ARM_MODE_SVC;
 	arm_algo.core_state = ARM_STATE_ARM;
 
 	init_reg_param(&reg_params[0], "r0", 32, PARAM_OUT);
-	buf_set_u32(reg_params[0].value, 0, 32, blocks[0].address);
+	buf_set_u32(reg_params[0].value, 0, 32, check_params->address);
 
 	init_reg_param(&reg_params[1], "r1", 32, PARAM_OUT);
-	buf_set_u32(reg_params[1].value, 0, 32, blocks[0].size);
-
-	init_reg_param(&reg_params[2], "r2", 32, PARAM_IN_OUT);
-	buf_set_u32(reg_params[2].value, 0, 32, erased_value);
+	buf_set_u32(reg_params[1].value, 0, 32, erased_word);
 
 	/* armv4 must exit using a hardware breakpoint */
 	if (arm->arch == ARM_ARCH_V4)
 		exit_var = check_algorithm->address + sizeof(check_code_le) - 4;
 
-	retval = target_run_algorithm(target, 0, NULL, 3, reg_params,
+	/* assume CPU clk at least 1 MHz */
+	unsigned int timeout = (timed_out ? 30000 : 2000) + total_size * 3 / 1000;
+
+	retval = target_run_algorithm(target, 0, NULL,
+			ARRAY_SIZE(reg_params), reg_params,
 			check_algorithm->address,
 			exit_var,
-			10000, &arm_algo);
+			timeout, &arm_algo);
 
-	if (retval == ERROR_OK) {
-		blocks[0].result = buf_get_u32(reg_params[2].value, 0, 32);
-		*checked = 1;	/* only one block has been checked */
+	timed_out = retval == ERROR_TARGET_TIMEOUT;
+	if (retval != ERROR_OK && !timed_out)
+		goto cleanup4;
+
+	retval = target_read_buffer(target, check_params->address,
+			param_size, (uint8_t *)params);
+	if (retval != ERROR_OK)
+		goto cleanup4;
+
+	for (i = 0; i < blocks_to_check; i++) {
+		uint32_t result = target_buffer_get_u32(target,
+				(uint8_t *)&params[i].result);
+		if (result != 0 && result != 1)
+			break;
+
+		blocks[i].result = result;
 	}
+	if (i && timed_out)
+		LOG_TARGET_INFO(target, "Slow CPU clock: %u blocks checked, %u remain. Continuing...",
+			i, num_blocks - i);
+
+	*checked = i;		/* return number of blocks really checked */
 
+cleanup4:
 	destroy_reg_param(&reg_params[0]);
 	destroy_reg_param(&reg_params[1]);
-	destroy_reg_param(&reg_params[2]);
 
+cleanup3:
+	target_free_working_area(target, check_params);
+cleanup2:
+	free(params);
+cleanup1:
 	target_free_working_area(target, check_algorithm);
 
 	return retval;
@@ -991,15 +991,10 @@ int armv7m_blank_check_memory(struct target *target,
 	const uint32_t code_size = sizeof(erase_check_code);
 
 	/* make sure we have a working area */
-	if (target_alloc_working_area(target, code_size,
+	if (target_alloc_working_area_resident(target, erase_check_code, code_size,
 		&erase_check_algorithm) != ERROR_OK)
 		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
 
-	retval = target_write_buffer(target, erase_check_algorithm->address,
-			code_size, erase_check_code);
-	if (retval != ERROR_OK)
-		goto cleanup1;
-
 	/* prepare blocks array for algo */
 	struct algo_block {
 		union {
@@ -210,6 +210,8 @@ struct armv8_common {
 	bool enable_pauth;
 
 	bool sticky_reset;
+	/* PRSR as queued by the poll_prefetch handler */
+	uint32_t prsr_prefetch;
 
 	/* last run-control command issued to this target (resume, halt, step) */
 	enum run_control_op last_run_control_op;
@@ -37,37 +37,192 @@ static const char * const watchpoint_rw_strings[] = {
 /* monotonic counter/id-number for breakpoints and watch points */
 static int bpwp_unique_id;
 
+/*
+ * Breakpoints of a target sorted by address, kept alongside the list in
+ * target->breakpoints so that lookups on resume/step and the overlap check
+ * on insertion do not have to walk the whole list. Breakpoints at the same
+ * address stay in insertion order, matching the list.
+ */
+struct breakpoint_index {
+	struct breakpoint **entries;
+	unsigned int count;
+	unsigned int size;
+	unsigned int max_length;
+};
+
+/* position of the first breakpoint at or above @a address */
+static unsigned int breakpoint_index_lower_bound(const struct breakpoint_index *index,
+	target_addr_t address)
+{
+	unsigned int lo = 0, hi = index->count;
+
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+		if (index->entries[mid]->address < address)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static void breakpoint_index_trim(struct target *target)
+{
+	struct breakpoint_index *index = target->breakpoint_index;
+
+	if (index && !index->count) {
+		free(index->entries);
+		free(index);
+		target->breakpoint_index = NULL;
+	}
+}
+
+/* make room for one more breakpoint, so that adding it cannot fail later */
+static int breakpoint_index_reserve(struct target *target)
+{
+	struct breakpoint_index *index = target->breakpoint_index;
+
+	if (!index) {
+		index = calloc(1, sizeof(*index));
+		if (!index) {
+			LOG_ERROR("Out of memory");
+			return ERROR_FAIL;
+		}
+		target->breakpoint_index = index;
+	}
+
+	if (index->count == index->size) {
+		unsigned int size = index->size ? 2 * index->size : 16;
+		struct breakpoint **entries = realloc(index->entries, size * sizeof(*entries));
+		if (!entries) {
+			LOG_ERROR("Out of memory");
+			breakpoint_index_trim(target);
+			return ERROR_FAIL;
+		}
+		index->entries = entries;
+		index->size = size;
+	}
+
+	return ERROR_OK;
+}
+
+static void breakpoint_index_add(struct target *target, struct breakpoint *breakpoint)
+{
+	struct breakpoint_index *index = target->breakpoint_index;
+
+	assert(index && index->count < index->size);
+
+	/* insert behind breakpoints at the same address */
+	unsigned int i = breakpoint_index_lower_bound(index, breakpoint->address);
+	while (i < index->count && index->entries[i]->address == breakpoint->address)
+		i++;
+
+	memmove(&index->entries[i + 1], &index->entries[i],
+		(index->count - i) * sizeof(*index->entries));
+	index->entries[i] = breakpoint;
+	index->count++;
+	index->max_length = MAX(index->max_length, breakpoint->length);
+}
+
+static void breakpoint_index_remove(struct target *target, struct breakpoint *breakpoint)
+{
+	struct breakpoint_index *index = target->breakpoint_index;
+
+	if (!index)
+		return;
+
+	for (unsigned int i = breakpoint_index_lower_bound(index, breakpoint->address);
+			i < index->count && index->entries[i]->address == breakpoint->address; i++) {
+		if (index->entries[i] != breakpoint)
+			continue;
+
+		index->count--;
+		memmove(&index->entries[i], &index->entries[i + 1],
+			(index->count - i) * sizeof(*index->entries));
+		break;
+	}
+
+	breakpoint_index_trim(target);
+}
+
+/* find a breakpoint that a new software breakpoint at @a address would overlap */
+void breakpoint_length_changed(struct target *target, struct breakpoint *breakpoint)
+{
+	struct breakpoint_index *index = target->breakpoint_index;
+
+	if (index)
+		index->max_length = MAX(index->max_length, breakpoint->length);
+}
+
+static struct breakpoint *breakpoint_index_find_overlap(struct target *target,
+	target_addr_t address, unsigned int length)
+{
+	struct breakpoint_index *index = target->breakpoint_index;
+
+	if (!index)
+		return NULL;
+
+	unsigned int first = breakpoint_index_lower_bound(index, address);
+
+	/* breakpoints starting below address reach at most max_length up */
+	for (unsigned int i = first; i > 0; i--) {
+		struct breakpoint *breakpoint = index->entries[i - 1];
+		if (breakpoint->address + index->max_length <= address)
+			break;
+		if (is_memory_regions_overlap(address, length, breakpoint->address, breakpoint->length))
+			return breakpoint;
+	}
+
+	for (unsigned int i = first; i < index->count; i++) {
+		struct breakpoint *breakpoint = index->entries[i];
+		if (breakpoint->address >= address + length)
+			break;
+		if (is_memory_regions_overlap(address, length, breakpoint->address, breakpoint->length))
+			return breakpoint;
+	}
+
+	return NULL;
+}
+
 static int breakpoint_add_internal(struct target *target,
 	target_addr_t address,
 	unsigned int length,
 	enum breakpoint_type type)
 {
-	struct breakpoint *breakpoint = target->breakpoints;
+	struct breakpoint *breakpoint;
 	struct breakpoint **breakpoint_p = &target->breakpoints;
 	const char *reason;
 	int retval;
 
-	while (breakpoint) {
-		if (breakpoint->address == address) {
-			/* FIXME don't assume "same address" means "same
-			 * breakpoint" ... check all the parameters before
-			 * succeeding.
-			 */
-			LOG_TARGET_ERROR(target, "Duplicate Breakpoint address: " TARGET_ADDR_FMT " (BP %" PRIu32 ")",
-				address, breakpoint->unique_id);
-			return ERROR_BREAKPOINT_DUPLICATED;
-		}
-		if (type == BKPT_SOFT &&
-				is_memory_regions_overlap(address, length, breakpoint->address, breakpoint->length)) {
+	breakpoint = breakpoint_find(target, address);
+	if (breakpoint) {
+		/* FIXME don't assume "same address" means "same
+		 * breakpoint" ... check all the parameters before
+		 * succeeding.
+		 */
+		LOG_TARGET_ERROR(target, "Duplicate Breakpoint address: " TARGET_ADDR_FMT " (BP %" PRIu32 ")",
+			address, breakpoint->unique_id);
+		return ERROR_BREAKPOINT_DUPLICATED;
+	}
+
+	if (type == BKPT_SOFT) {
+		breakpoint = breakpoint_index_find_overlap(target, address, length);
+		if (breakpoint) {
 			LOG_TARGET_ERROR(target, "Breakpoint overlaps another one at " TARGET_ADDR_FMT
 				" of length %u (BP %" PRIu32 ")", breakpoint->address,
 				breakpoint->length, breakpoint->unique_id);
 			return ERROR_BREAKPOINT_OVERLAPPED;
 		}
-		breakpoint_p = &breakpoint->next;
-		breakpoint = breakpoint->next;
 	}
 
+	while (*breakpoint_p)
+		breakpoint_p = &(*breakpoint_p)->next;
+
+	retval = breakpoint_index_reserve(target);
+	if (retval != ERROR_OK)
+		return retval;
+
 	(*breakpoint_p) = malloc(sizeof(struct breakpoint));
 	(*breakpoint_p)->address = address;
 	(*breakpoint_p)->asid = 0;
@@ -95,9 +250,12 @@ fail:
 		free((*breakpoint_p)->orig_instr);
 		free(*breakpoint_p);
 		*breakpoint_p = NULL;
+		breakpoint_index_trim(target);
 		return retval;
 	}
 
+	breakpoint_index_add(target, *breakpoint_p);
+
 	LOG_TARGET_DEBUG(target, "added %s breakpoint at " TARGET_ADDR_FMT
 			" of length 0x%8.8x, (BPID: %" PRIu32 ")",
 		breakpoint_type_strings[(*breakpoint_p)->type],
@@ -130,6 +288,10 @@ static int context_breakpoint_add_internal(struct target *target,
 		breakpoint = breakpoint->next;
 	}
 
+	retval = breakpoint_index_reserve(target);
+	if (retval != ERROR_OK)
+		return retval;
+
 	(*breakpoint_p) = malloc(sizeof(struct breakpoint));
 	(*breakpoint_p)->address = 0;
 	(*breakpoint_p)->asid = asid;
@@ -145,9 +307,12 @@ static int context_breakpoint_add_internal(struct target *target,
 		free((*breakpoint_p)->orig_instr);
 		free(*breakpoint_p);
 		*breakpoint_p = NULL;
+		breakpoint_index_trim(target);
 		return retval;
 	}
 
+	breakpoint_index_add(target, *breakpoint_p);
+
 	LOG_TARGET_DEBUG(target, "added %s Context breakpoint at 0x%8.8" PRIx32 " of length 0x%8.8x, (BPID: %" PRIu32 ")",
 		breakpoint_type_strings[(*breakpoint_p)->type],
 		(*breakpoint_p)->asid, (*breakpoint_p)->length,
@@ -184,6 +349,10 @@ static int hybrid_breakpoint_add_internal(struct target *target,
 		breakpoint_p = &breakpoint->next;
 		breakpoint = breakpoint->next;
 	}
+	retval = breakpoint_index_reserve(target);
+	if (retval != ERROR_OK)
+		return retval;
+
 	(*breakpoint_p) = malloc(sizeof(struct breakpoint));
 	(*breakpoint_p)->address = address;
 	(*breakpoint_p)->asid = asid;
@@ -201,8 +370,11 @@ static int hybrid_breakpoint_add_internal(struct target *target,
 		free((*breakpoint_p)->orig_instr);
 		free(*breakpoint_p);
 		*breakpoint_p = NULL;
+		breakpoint_index_trim(target);
 		return retval;
 	}
+	breakpoint_index_add(target, *breakpoint_p);
+
 	LOG_TARGET_DEBUG(target,
 		"added %s Hybrid breakpoint at address " TARGET_ADDR_FMT " of length 0x%8.8x, (BPID: %" PRIu32 ")",
 		breakpoint_type_strings[(*breakpoint_p)->type],
@@ -218,7 +390,7 @@ int breakpoint_add(struct target *target,
 	unsigned int length,
 	enum breakpoint_type type)
 {
-	if (target->smp && type == BKPT_HARD) {
+	if (target_smp_threads(target) && type == BKPT_HARD) {
 		struct target_list *list_node;
 		foreach_smp_target(list_node, target->smp_targets) {
 			struct target *curr = list_node->target;
@@ -238,7 +410,7 @@ int context_breakpoint_add(struct target *target,
 	unsigned int length,
 	enum breakpoint_type type)
 {
-	if (target->smp) {
+	if (target_smp_threads(target)) {
 		struct target_list *head;
 
 		foreach_smp_target(head, target->smp_targets) {
@@ -260,7 +432,7 @@ int hybrid_breakpoint_add(struct target *target,
 	unsigned int length,
 	enum breakpoint_type type)
 {
-	if (target->smp) {
+	if (target_smp_threads(target)) {
 		struct target_list *head;
 
 		foreach_smp_target(head, target->smp_targets) {
@@ -300,6 +472,7 @@ static int breakpoint_free(struct target *target, struct breakpoint *breakpoint_
 	}
 
 	LOG_TARGET_DEBUG(target, "free BPID: %" PRIu32 " --> %d", breakpoint->unique_id, retval);
+	breakpoint_index_remove(target, breakpoint);
 	(*breakpoint_p) = breakpoint->next;
 	free(breakpoint->orig_instr);
 	free(breakpoint);
@@ -332,6 +505,10 @@ static int breakpoint_remove_all_internal(struct target *target)
 	struct breakpoint *breakpoint = target->breakpoints;
 	int retval = ERROR_OK;
 
+	/* take out all software breakpoints in one batch, if supported */
+	if (breakpoint && target->state == TARGET_HALTED)
+		retval = target_update_sw_breakpoints(target, false);
+
 	while (breakpoint) {
 		struct breakpoint *tmp = breakpoint;
 		breakpoint = breakpoint->next;
@@ -347,7 +524,7 @@ int breakpoint_remove(struct target *target, target_addr_t address)
 {
 	int retval = ERROR_OK;
 	unsigned int num_found_breakpoints = 0;
-	if (target->smp) {
+	if (target_smp_threads(target)) {
 		struct target_list *head;
 
 		foreach_smp_target(head, target->smp_targets) {
@@ -434,7 +611,7 @@ static int breakpoint_watchpoint_remove_all(struct target *target, enum breakpoi
 {
 	assert(bp_wp == BREAKPOINT || bp_wp == WATCHPOINT);
 	int retval = ERROR_OK;
-	if (target->smp) {
+	if (target_smp_threads(target)) {
 		struct target_list *head;
 
 		foreach_smp_target(head, target->smp_targets) {
@@ -470,16 +647,38 @@ int watchpoint_remove_all(struct target *target)
 }
 
 struct breakpoint *breakpoint_find(struct target *target, target_addr_t address)
+{
+	struct breakpoint_index *index = target->breakpoint_index;
+
+	if (!index)
+		return NULL;
+
+	unsigned int i = breakpoint_index_lower_bound(index, address);
+	if (i < index->count && index->entries[i]->address == address)
+		return index->entries[i];
+
+	return NULL;
+}
+
+/**
+ * Free all breakpoints of @a target without removing them from the target,
+ * for targets that lost their breakpoints e.g. through a reset.
+ */
+void breakpoint_forget_all(struct target *target)
 {
 	struct breakpoint *breakpoint = target->breakpoints;
 
 	while (breakpoint) {
-		if (breakpoint->address == address)
-			return breakpoint;
-		breakpoint = breakpoint->next;
+		struct breakpoint *next = breakpoint->next;
+		free(breakpoint->orig_instr);
+		free(breakpoint);
+		breakpoint = next;
 	}
+	target->breakpoints = NULL;
 
-	return NULL;
+	if (target->breakpoint_index)
+		target->breakpoint_index->count = 0;
+	breakpoint_index_trim(target);
 }
 
 static int watchpoint_add_internal(struct target *target, target_addr_t address,
@@ -551,7 +750,7 @@ bye:
 int watchpoint_add(struct target *target, target_addr_t address,
 		unsigned int length, enum watchpoint_rw rw, uint64_t value, uint64_t mask)
 {
-	if (target->smp) {
+	if (target_smp_threads(target)) {
 		struct target_list *head;
 
 		foreach_smp_target(head, target->smp_targets) {
@@ -589,7 +788,7 @@ int watchpoint_remove(struct target *target, target_addr_t address)
 {
 	int retval = ERROR_OK;
 	unsigned int num_found_watchpoints = 0;
-	if (target->smp) {
+	if (target_smp_threads(target)) {
 		struct target_list *head;
 
 		foreach_smp_target(head, target->smp_targets) {
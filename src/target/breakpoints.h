@@ -61,6 +61,9 @@ int breakpoint_remove(struct target *target, target_addr_t address);
 int breakpoint_remove_all(struct target *target);
 
 struct breakpoint *breakpoint_find(struct target *target, target_addr_t address);
+void breakpoint_forget_all(struct target *target);
+/* to be called by targets growing the length of a breakpoint on insertion */
+void breakpoint_length_changed(struct target *target, struct breakpoint *breakpoint);
 
 static inline void breakpoint_hw_set(struct breakpoint *breakpoint, unsigned int hw_number)
 {
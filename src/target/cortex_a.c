@@ -76,6 +76,9 @@ static int cortex_a_virt2phys(struct target *target,
 	target_addr_t virt, target_addr_t *phys);
 static int cortex_a_read_cpu_memory(struct target *target,
 	uint32_t address, uint32_t size, uint32_t count, uint8_t *buffer);
+static int cortex_a_write_cpu_memory(struct target *target,
+	uint32_t address, uint32_t size, uint32_t count, const uint8_t *buffer);
+static int cortex_a_update_sw_breakpoints(struct target *target, bool set);
 
 static unsigned int ilog2(unsigned int x)
 {
@@ -977,9 +980,15 @@ static int cortex_a_restore_smp(struct target *target, bool handle_breakpoints)
 		struct target *curr = head->target;
 		if ((curr != target) && (curr->state != TARGET_RUNNING)
 			&& target_was_examined(curr)) {
+			int retval2 = ERROR_OK;
+
+			if (curr->state == TARGET_HALTED)
+				retval2 = cortex_a_update_sw_breakpoints(curr, true);
+
 			/*  resume current address , not in step mode */
-			int retval2 = cortex_a_internal_restore(curr, true, &address,
-					handle_breakpoints, false);
+			if (retval2 == ERROR_OK)
+				retval2 = cortex_a_internal_restore(curr, true, &address,
+						handle_breakpoints, false);
 
 			if (retval2 == ERROR_OK)
 				retval2 = cortex_a_internal_restart(curr);
@@ -997,6 +1006,7 @@ static int cortex_a_restore_smp(struct target *target, bool handle_breakpoints)
 static int cortex_a_resume(struct target *target, bool current,
 	target_addr_t address, bool handle_breakpoints, bool debug_execution)
 {
+	struct cortex_a_common *cortex_a = target_to_cortex_a(target);
 	int retval = 0;
 	/* dummy resume for smp toggle in order to reduce gdb impact  */
 	if ((target->smp) && (target->gdb_service->core[1] != -1)) {
@@ -1007,6 +1017,15 @@ static int cortex_a_resume(struct target *target, bool current,
 		target_call_event_callbacks(target, TARGET_EVENT_RESUMED);
 		return 0;
 	}
+
+	/* every restart inserts the pending software breakpoints, except
+	 * single step, which keeps the one at the PC out on purpose */
+	if (!cortex_a->stepping) {
+		retval = cortex_a_update_sw_breakpoints(target, true);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
 	cortex_a_internal_restore(target, current, &address, handle_breakpoints,
 		debug_execution);
 	if (target->smp) {
@@ -1267,7 +1286,9 @@ static int cortex_a_step(struct target *target, bool current, target_addr_t addr
 
 	target->debug_reason = DBG_REASON_SINGLESTEP;
 
+	cortex_a->stepping = true;
 	retval = cortex_a_resume(target, true, address, false, false);
+	cortex_a->stepping = false;
 	if (retval != ERROR_OK)
 		return retval;
 
@@ -1337,6 +1358,173 @@ static int cortex_a_restore_context(struct target *target, bool bpwp)
  * Cortex-A Breakpoint and watchpoint functions
  */
 
+/*
+ * Software breakpoints are only recorded when added, and inserted by the
+ * next restart of the core, see cortex_a_update_sw_breakpoints(). Read the
+ * original instruction right away, so that an address which can't be
+ * accessed is reported to the debugger, which may then fall back to a
+ * hardware breakpoint.
+ */
+static int cortex_a_prepare_sw_breakpoint(struct target *target,
+	struct breakpoint *breakpoint)
+{
+	unsigned int length = breakpoint->length;
+
+	if (length == 3) {
+		/* Thumb-2 breakpoint, replaces a 32bit Thumb-2 instruction */
+		uint8_t *orig_instr = realloc(breakpoint->orig_instr, 4);
+		if (!orig_instr) {
+			LOG_ERROR("Out of memory");
+			return ERROR_FAIL;
+		}
+		breakpoint->orig_instr = orig_instr;
+		length = 4;
+	}
+
+	return target_read_memory(target,
+			breakpoint->address & 0xFFFFFFFE,
+			length, 1,
+			breakpoint->orig_instr);
+}
+
+/*
+ * Write the BKPT instruction (set true) or the original instruction of a
+ * software breakpoint. Must be called between cortex_a_prep_memaccess() and
+ * cortex_a_post_memaccess(), cache maintenance is left to the caller.
+ */
+static int cortex_a_write_sw_breakpoint(struct target *target,
+	struct breakpoint *breakpoint, bool set)
+{
+	struct cortex_a_common *cortex_a = target_to_cortex_a(target);
+	const uint8_t *buffer = breakpoint->orig_instr;
+	uint8_t code[4];
+	int retval;
+
+	if (set) {
+		if (breakpoint->length == 2) {
+			/* length == 2: Thumb breakpoint */
+			buf_set_u32(code, 0, 32, ARMV5_T_BKPT(0x11));
+		} else if (breakpoint->length == 3) {
+			/* length == 3: Thumb-2 breakpoint, actual encoding is
+			 * a regular Thumb BKPT instruction but we replace a
+			 * 32bit Thumb-2 instruction, so fix-up the breakpoint
+			 * length
+			 */
+			buf_set_u32(code, 0, 32, ARMV5_T_BKPT(0x11));
+			breakpoint->length = 4;
+			breakpoint_length_changed(target, breakpoint);
+		} else {
+			/* length == 4, normal ARM breakpoint */
+			buf_set_u32(code, 0, 32, ARMV5_BKPT(0x11));
+		}
+
+		/*
+		 * ARMv7-A/R fetches instructions in little-endian on both LE and BE CPUs.
+		 * But Cortex-R4 and Cortex-R5 big-endian require BE instructions.
+		 * https://developer.arm.com/documentation/den0042/a/Coding-for-Cortex-R-Processors/Endianness
+		 * https://developer.arm.com/documentation/den0013/d/Porting/Endianness
+		 */
+		if ((((cortex_a->cpuid & CPUDBG_CPUID_MASK) == CPUDBG_CPUID_CORTEX_R4) ||
+		    ((cortex_a->cpuid & CPUDBG_CPUID_MASK) == CPUDBG_CPUID_CORTEX_R5)) &&
+		    target->endianness == TARGET_BIG_ENDIAN) {
+			// In place swapping is allowed
+			buf_bswap32(code, code, 4);
+		}
+
+		buffer = code;
+	}
+
+	/* original instruction is kept in target endianness */
+	retval = cortex_a_write_cpu_memory(target,
+			breakpoint->address & 0xFFFFFFFE,
+			breakpoint->length == 4 ? 4 : 2, 1, buffer);
+	if (retval != ERROR_OK)
+		return retval;
+
+	breakpoint->is_set = set;
+
+	return ERROR_OK;
+}
+
+/* Insert (set true) or take out a single software breakpoint */
+static int cortex_a_update_sw_breakpoint(struct target *target,
+	struct breakpoint *breakpoint, bool set)
+{
+	/* make sure data cache is cleaned & invalidated down to PoC */
+	armv7a_cache_flush_virt(target, breakpoint->address, breakpoint->length);
+
+	cortex_a_prep_memaccess(target, false);
+	int retval = cortex_a_write_sw_breakpoint(target, breakpoint, set);
+	cortex_a_post_memaccess(target, false);
+	if (retval != ERROR_OK)
+		return retval;
+
+	armv7a_l1_d_cache_inval_virt(target, breakpoint->address, breakpoint->length);
+
+	/* update i-cache at breakpoint location */
+	armv7a_l1_i_cache_inval_virt(target, breakpoint->address, breakpoint->length);
+
+	return ERROR_OK;
+}
+
+/*
+ * Insert or take out all software breakpoints not yet in the requested
+ * state as one batch: the memory access setup is done once, and the
+ * i-cache is invalidated once instead of per breakpoint.
+ */
+static int cortex_a_update_sw_breakpoints(struct target *target, bool set)
+{
+	struct breakpoint *breakpoint;
+	unsigned int count = 0;
+
+	for (breakpoint = target->breakpoints; breakpoint; breakpoint = breakpoint->next) {
+		if (breakpoint->type == BKPT_SOFT && breakpoint->is_set != set)
+			count++;
+	}
+	if (!count)
+		return ERROR_OK;
+
+	struct breakpoint **batch = malloc(count * sizeof(*batch));
+	if (!batch) {
+		LOG_ERROR("Out of memory");
+		return ERROR_FAIL;
+	}
+
+	count = 0;
+	for (breakpoint = target->breakpoints; breakpoint; breakpoint = breakpoint->next) {
+		if (breakpoint->type == BKPT_SOFT && breakpoint->is_set != set)
+			batch[count++] = breakpoint;
+	}
+
+	/* make sure data cache is cleaned & invalidated down to PoC */
+	for (unsigned int i = 0; i < count; i++)
+		armv7a_cache_flush_virt(target, batch[i]->address, batch[i]->length);
+
+	int retval = ERROR_OK;
+	unsigned int written;
+
+	cortex_a_prep_memaccess(target, false);
+	for (written = 0; written < count; written++) {
+		retval = cortex_a_write_sw_breakpoint(target, batch[written], set);
+		if (retval != ERROR_OK)
+			break;
+	}
+	cortex_a_post_memaccess(target, false);
+
+	/* also covers the breakpoints written before a failure */
+	for (unsigned int i = 0; i < written; i++)
+		armv7a_l1_d_cache_inval_virt(target, batch[i]->address, batch[i]->length);
+	if (written) {
+		LOG_TARGET_DEBUG(target, "%s %u software breakpoints",
+			set ? "inserted" : "removed", written);
+		armv7a_l1_i_cache_inval_all(target);
+	}
+
+	free(batch);
+
+	return retval;
+}
+
 /* Setup hardware Breakpoint Register Pair */
 static int cortex_a_set_breakpoint(struct target *target,
 	struct breakpoint *breakpoint, uint8_t matchmode)
@@ -1392,57 +1580,9 @@ static int cortex_a_set_breakpoint(struct target *target,
 			brp_list[brp_i].control,
 			brp_list[brp_i].value);
 	} else if (breakpoint->type == BKPT_SOFT) {
-		uint8_t code[4];
-		if (breakpoint->length == 2) {
-			/* length == 2: Thumb breakpoint */
-			buf_set_u32(code, 0, 32, ARMV5_T_BKPT(0x11));
-		} else if (breakpoint->length == 3) {
-			/* length == 3: Thumb-2 breakpoint, actual encoding is
-			 * a regular Thumb BKPT instruction but we replace a
-			 * 32bit Thumb-2 instruction, so fix-up the breakpoint
-			 * length
-			 */
-			buf_set_u32(code, 0, 32, ARMV5_T_BKPT(0x11));
-			breakpoint->length = 4;
-		} else {
-			/* length == 4, normal ARM breakpoint */
-			buf_set_u32(code, 0, 32, ARMV5_BKPT(0x11));
-		}
-
-		/*
-		 * ARMv7-A/R fetches instructions in little-endian on both LE and BE CPUs.
-		 * But Cortex-R4 and Cortex-R5 big-endian require BE instructions.
-		 * https://developer.arm.com/documentation/den0042/a/Coding-for-Cortex-R-Processors/Endianness
-		 * https://developer.arm.com/documentation/den0013/d/Porting/Endianness
-		 */
-		if ((((cortex_a->cpuid & CPUDBG_CPUID_MASK) == CPUDBG_CPUID_CORTEX_R4) ||
-		    ((cortex_a->cpuid & CPUDBG_CPUID_MASK) == CPUDBG_CPUID_CORTEX_R5)) &&
-		    target->endianness == TARGET_BIG_ENDIAN) {
-			// In place swapping is allowed
-			buf_bswap32(code, code, 4);
-		}
-
-		retval = target_read_memory(target,
-				breakpoint->address & 0xFFFFFFFE,
-				breakpoint->length, 1,
-				breakpoint->orig_instr);
-		if (retval != ERROR_OK)
-			return retval;
-
-		/* make sure data cache is cleaned & invalidated down to PoC */
-		armv7a_cache_flush_virt(target, breakpoint->address, breakpoint->length);
-
-		retval = target_write_memory(target,
-				breakpoint->address & 0xFFFFFFFE,
-				breakpoint->length, 1, code);
+		retval = cortex_a_update_sw_breakpoint(target, breakpoint, true);
 		if (retval != ERROR_OK)
 			return retval;
-
-		/* update i-cache at breakpoint location */
-		armv7a_l1_d_cache_inval_virt(target, breakpoint->address, breakpoint->length);
-		armv7a_l1_i_cache_inval_virt(target, breakpoint->address, breakpoint->length);
-
-		breakpoint->is_set = true;
 	}
 
 	return ERROR_OK;
@@ -1660,36 +1800,9 @@ static int cortex_a_unset_breakpoint(struct target *target, struct breakpoint *b
 			breakpoint->is_set = false;
 			return ERROR_OK;
 		}
-	} else {
-
-		/* make sure data cache is cleaned & invalidated down to PoC */
-		armv7a_cache_flush_virt(target, breakpoint->address,
-						breakpoint->length);
-
-		/* restore original instruction (kept in target endianness) */
-		if (breakpoint->length == 4) {
-			retval = target_write_memory(target,
-					breakpoint->address & 0xFFFFFFFE,
-					4, 1, breakpoint->orig_instr);
-			if (retval != ERROR_OK)
-				return retval;
-		} else {
-			retval = target_write_memory(target,
-					breakpoint->address & 0xFFFFFFFE,
-					2, 1, breakpoint->orig_instr);
-			if (retval != ERROR_OK)
-				return retval;
-		}
-
-		/* update i-cache at breakpoint location */
-		armv7a_l1_d_cache_inval_virt(target, breakpoint->address,
-						 breakpoint->length);
-		armv7a_l1_i_cache_inval_virt(target, breakpoint->address,
-						 breakpoint->length);
 	}
-	breakpoint->is_set = false;
 
-	return ERROR_OK;
+	return cortex_a_update_sw_breakpoint(target, breakpoint, false);
 }
 
 static int cortex_a_add_breakpoint(struct target *target,
@@ -1702,6 +1815,9 @@ static int cortex_a_add_breakpoint(struct target *target,
 		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
 	}
 
+	if (breakpoint->type == BKPT_SOFT)
+		return cortex_a_prepare_sw_breakpoint(target, breakpoint);
+
 	if (breakpoint->type == BKPT_HARD)
 		cortex_a->brp_num_available--;
 
@@ -3501,6 +3617,7 @@ struct target_type cortexa_target = {
 	.add_context_breakpoint = cortex_a_add_context_breakpoint,
 	.add_hybrid_breakpoint = cortex_a_add_hybrid_breakpoint,
 	.remove_breakpoint = cortex_a_remove_breakpoint,
+	.update_sw_breakpoints = cortex_a_update_sw_breakpoints,
 	.add_watchpoint = cortex_a_add_watchpoint,
 	.remove_watchpoint = cortex_a_remove_watchpoint,
 
@@ -3578,6 +3695,7 @@ struct target_type cortexr4_target = {
 	.add_context_breakpoint = cortex_a_add_context_breakpoint,
 	.add_hybrid_breakpoint = cortex_a_add_hybrid_breakpoint,
 	.remove_breakpoint = cortex_a_remove_breakpoint,
+	.update_sw_breakpoints = cortex_a_update_sw_breakpoints,
 	.add_watchpoint = cortex_a_add_watchpoint,
 	.remove_watchpoint = cortex_a_remove_watchpoint,
 
@@ -101,6 +101,9 @@ struct cortex_a_common {
 
 	enum cortex_a_isrmasking_mode isrmasking_mode;
 	enum cortex_a_dacrfixup_mode dacrfixup_mode;
+
+	/* restarting for a single step, software breakpoints stay as they are */
+	bool stepping;
 };
 
 static inline struct cortex_a_common *
@@ -965,6 +965,21 @@ static int cortex_m_debug_entry(struct target *target)
 	return ERROR_OK;
 }
 
+static int cortex_m_poll_prefetch(struct target *target)
+{
+	struct cortex_m_common *cortex_m = target_to_cm(target);
+	struct armv7m_common *armv7m = &cortex_m->armv7m;
+
+	return mem_ap_read_u32(armv7m->debug_ap, DCB_DHCSR, &cortex_m->dcb_dhcsr_prefetch);
+}
+
+static int cortex_m_poll_prefetch_run(struct target *target)
+{
+	struct armv7m_common *armv7m = target_to_armv7m(target);
+
+	return dap_run(armv7m->debug_ap->dap);
+}
+
 static int cortex_m_poll_one(struct target *target)
 {
 	int detected_failure = ERROR_OK;
@@ -973,8 +988,14 @@ static int cortex_m_poll_one(struct target *target)
 	struct cortex_m_common *cortex_m = target_to_cm(target);
 	struct armv7m_common *armv7m = &cortex_m->armv7m;
 
-	/* Read from Debug Halting Control and Status Register */
-	retval = cortex_m_read_dhcsr_atomic_sticky(target);
+	/* Read from Debug Halting Control and Status Register, unless it was
+	 * read together with the other cores on this DAP */
+	if (target_poll_take_prefetch(target)) {
+		cortex_m->dcb_dhcsr = cortex_m->dcb_dhcsr_prefetch;
+		cortex_m_cumulate_dhcsr_sticky(cortex_m, cortex_m->dcb_dhcsr);
+	} else {
+		retval = cortex_m_read_dhcsr_atomic_sticky(target);
+	}
 	if (retval != ERROR_OK) {
 		target->state = TARGET_UNKNOWN;
 		return retval;
@@ -3464,6 +3485,8 @@ struct target_type cortexm_target = {
 	.name = "cortex_m",
 
 	.poll = cortex_m_poll,
+	.poll_prefetch = cortex_m_poll_prefetch,
+	.poll_prefetch_run = cortex_m_poll_prefetch_run,
 	.arch_state = armv7m_arch_state,
 
 	.target_request_data = cortex_m_target_request_data,
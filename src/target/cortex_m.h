@@ -278,6 +278,8 @@ struct cortex_m_common {
 	uint32_t dcb_dhcsr_cumulated_sticky;
 	/* DCB DHCSR has been at least once read, so the sticky bits have been reset */
 	bool dcb_dhcsr_sticky_is_recent;
+	/* DHCSR as queued by cortex_m_poll_prefetch() */
+	uint32_t dcb_dhcsr_prefetch;
 	uint32_t nvic_dfsr;  /* Debug Fault Status Register - shows reason for debug halt */
 	uint32_t nvic_icsr;  /* Interrupt Control State Register - shows active and pending IRQ */
 
@@ -194,9 +194,7 @@ static int etb_read_ram(struct etb *etb, uint32_t *data, int num_frames)
 		jtag_add_callback(etb_getbuf, (jtag_callback_data_t)(data + i));
 	}
 
-	jtag_execute_queue();
-
-	return ERROR_OK;
+	return jtag_execute_queue();
 }
 
 static int etb_read_reg_w_check(struct reg *reg,
@@ -513,10 +511,13 @@ static int etb_read_trace(struct etm_context *etm_ctx)
 	int num_frames = etb->ram_depth;
 	uint32_t *trace_data = NULL;
 	int i, j;
+	int retval;
 
 	etb_read_reg(&etb->reg_cache->reg_list[ETB_STATUS]);
 	etb_read_reg(&etb->reg_cache->reg_list[ETB_RAM_WRITE_POINTER]);
-	jtag_execute_queue();
+	retval = jtag_execute_queue();
+	if (retval != ERROR_OK)
+		return retval;
 
 	/* check if we overflowed, and adjust first frame of the trace accordingly
 	 * if we didn't overflow, read only up to the frame that would be written next,
@@ -535,7 +536,12 @@ static int etb_read_trace(struct etm_context *etm_ctx)
 
 	/* read data into temporary array for unpacking */
 	trace_data = malloc(sizeof(uint32_t) * num_frames);
-	etb_read_ram(etb, trace_data, num_frames);
+	retval = etb_read_ram(etb, trace_data, num_frames);
+	if (retval != ERROR_OK) {
+		LOG_ERROR("failed to read ETB trace RAM");
+		free(trace_data);
+		return retval;
+	}
 
 	if (etm_ctx->trace_depth > 0)
 		free(etm_ctx->trace_data);
@@ -628,6 +628,34 @@ static struct etm_capture_driver *etm_capture_drivers[] = {
 	NULL
 };
 
+/* Direct mapped cache of instructions decoded from the trace image, indexed
+ * by address. Traces mostly run loops, which then only get decoded once. */
+#define ETM_INSN_CACHE_SIZE	1024
+
+struct etm_insn_cache_entry {
+	bool valid;
+	int core_state;
+	uint32_t address;
+	struct arm_instruction instruction;
+};
+
+static void etm_insn_cache_free(struct etm_context *ctx)
+{
+	free(ctx->insn_cache);
+	ctx->insn_cache = NULL;
+}
+
+static struct etm_insn_cache_entry *etm_insn_cache_lookup(struct etm_context *ctx)
+{
+	if (!ctx->insn_cache) {
+		ctx->insn_cache = calloc(ETM_INSN_CACHE_SIZE, sizeof(*ctx->insn_cache));
+		if (!ctx->insn_cache)
+			return NULL;
+	}
+
+	return &ctx->insn_cache[(ctx->current_pc >> 1) & (ETM_INSN_CACHE_SIZE - 1)];
+}
+
 static int etm_read_instruction(struct etm_context *ctx, struct arm_instruction *instruction)
 {
 	int section = -1;
@@ -638,6 +666,13 @@ static int etm_read_instruction(struct etm_context *ctx, struct arm_instruction
 	if (!ctx->image)
 		return ERROR_TRACE_IMAGE_UNAVAILABLE;
 
+	struct etm_insn_cache_entry *cached = etm_insn_cache_lookup(ctx);
+	if (cached && cached->valid && cached->address == ctx->current_pc &&
+			cached->core_state == ctx->core_state) {
+		*instruction = cached->instruction;
+		return ERROR_OK;
+	}
+
 	/* search for the section the current instruction belongs to */
 	for (unsigned int i = 0; i < ctx->image->num_sections; i++) {
 		if ((ctx->image->sections[i].base_address <= ctx->current_pc) &&
@@ -685,6 +720,13 @@ static int etm_read_instruction(struct etm_context *ctx, struct arm_instruction
 		return ERROR_FAIL;
 	}
 
+	if (cached) {
+		cached->valid = true;
+		cached->core_state = ctx->core_state;
+		cached->address = ctx->current_pc;
+		cached->instruction = *instruction;
+	}
+
 	return ERROR_OK;
 }
 
@@ -844,7 +886,132 @@ static int etmv1_data(struct etm_context *ctx, int size, uint32_t *data)
 	return 0;
 }
 
-static int etmv1_analyze_trace(struct etm_context *ctx, struct command_invocation *cmd)
+/* Record types of the binary 'etm analyze' output */
+enum etm_record_type {
+	ETM_RECORD_INSTRUCTION = 0,
+	ETM_RECORD_ADDRESS,
+	ETM_RECORD_DATA,
+	ETM_RECORD_TRIGGER,
+	ETM_RECORD_TRACE_ENABLED,
+	ETM_RECORD_FIFO_OVERFLOW,
+	ETM_RECORD_DEBUG_EXIT,
+	ETM_RECORD_SYNC,
+	ETM_RECORD_EXCEPTION,
+	ETM_RECORD_DATA_ABORT,
+};
+
+#define ETM_RECORD_NOT_EXECUTED		0x1
+#define ETM_RECORD_THUMB		0x2
+#define ETM_RECORD_CYCLES		0x4
+
+#define ETM_RECORD_SIZE			12
+
+/* Each record is 12 bytes, little endian: type, flags, 16 bit cycle count,
+ * 32 bit address or value, 32 bit opcode. */
+static int etm_write_record(struct fileio *out, enum etm_record_type type,
+		uint8_t flags, uint32_t cycles, uint32_t value, uint32_t opcode)
+{
+	uint8_t record[ETM_RECORD_SIZE];
+	size_t written;
+
+	record[0] = type;
+	record[1] = flags;
+	h_u16_to_le(&record[2], MIN(cycles, 0xffff));
+	h_u32_to_le(&record[4], value);
+	h_u32_to_le(&record[8], opcode);
+
+	int retval = fileio_write(out, ETM_RECORD_SIZE, record, &written);
+	if (retval == ERROR_OK && written != ETM_RECORD_SIZE)
+		retval = ERROR_FAIL;
+	return retval;
+}
+
+static int etm_output_event(struct command_invocation *cmd, struct fileio *out,
+		enum etm_record_type type, uint32_t value)
+{
+	if (out)
+		return etm_write_record(out, type, 0, 0, value, 0);
+
+	switch (type) {
+	case ETM_RECORD_ADDRESS:
+		command_print(cmd, "address: 0x%8.8" PRIx32, value);
+		break;
+	case ETM_RECORD_DATA:
+		command_print(cmd, "data: 0x%8.8" PRIx32, value);
+		break;
+	case ETM_RECORD_TRIGGER:
+		command_print(cmd, "--- trigger ---");
+		break;
+	case ETM_RECORD_TRACE_ENABLED:
+		command_print(cmd, "--- tracing enabled at 0x%8.8" PRIx32 " ---", value);
+		break;
+	case ETM_RECORD_FIFO_OVERFLOW:
+		command_print(cmd,
+			"--- trace restarted after FIFO overflow at 0x%8.8" PRIx32 " ---",
+			value);
+		break;
+	case ETM_RECORD_DEBUG_EXIT:
+		command_print(cmd, "--- exit from debug state at 0x%8.8" PRIx32 " ---", value);
+		break;
+	case ETM_RECORD_SYNC:
+		command_print(cmd,
+			"--- periodic synchronization point at 0x%8.8" PRIx32 " ---",
+			value);
+		break;
+	case ETM_RECORD_EXCEPTION:
+		command_print(cmd, "exception vector 0x%2.2" PRIx32, value);
+		break;
+	case ETM_RECORD_DATA_ABORT:
+		command_print(cmd, "data abort");
+		break;
+	default:
+		break;
+	}
+
+	return ERROR_OK;
+}
+
+static int etm_output_instruction(struct etm_context *ctx,
+		struct command_invocation *cmd, struct fileio *out,
+		const struct arm_instruction *instruction, bool executed, uint32_t cycles)
+{
+	bool cycle_accurate = ctx->control & ETM_CTRL_CYCLE_ACCURATE;
+
+	if (out) {
+		uint8_t flags = 0;
+
+		if (!executed)
+			flags |= ETM_RECORD_NOT_EXECUTED;
+		if (ctx->core_state == ARM_STATE_THUMB)
+			flags |= ETM_RECORD_THUMB;
+		if (cycle_accurate)
+			flags |= ETM_RECORD_CYCLES;
+		return etm_write_record(out, ETM_RECORD_INSTRUCTION, flags, cycles,
+				ctx->current_pc, instruction->opcode);
+	}
+
+	char cycles_text[32] = "";
+
+	/* if the trace was captured with cycle accurate tracing enabled,
+	 * output the number of cycles since the last executed instruction
+	 */
+	if (cycle_accurate) {
+		snprintf(cycles_text, 32, " (%i %s)",
+			(int)cycles,
+			(cycles == 1) ? "cycle" : "cycles");
+	}
+
+	command_print(cmd, "%s%s%s",
+		instruction->text,
+		executed ? "" : " (not executed)",
+		cycles_text);
+
+	return ERROR_OK;
+}
+
+/* Analyze the trace, printing it, or writing binary records to out if set */
+static int etmv1_analyze_trace(struct etm_context *ctx, struct command_invocation *cmd,
+		struct fileio *out)
 {
 	int retval;
 	struct arm_instruction instruction;
@@ -877,8 +1044,11 @@ static int etmv1_analyze_trace(struct etm_context *ctx, struct command_invocatio
 		uint32_t cycles = 0;
 		int current_pc_ok = ctx->pc_ok;
 
-		if (ctx->trace_data[ctx->pipe_index].flags & ETMV1_TRIGGER_CYCLE)
-			command_print(cmd, "--- trigger ---");
+		if (ctx->trace_data[ctx->pipe_index].flags & ETMV1_TRIGGER_CYCLE) {
+			retval = etm_output_event(cmd, out, ETM_RECORD_TRIGGER, 0);
+			if (retval != ERROR_OK)
+				return retval;
+		}
 
 		/* instructions execute in IE/D or BE/D cycles */
 		if ((pipestat == STAT_IE) || (pipestat == STAT_ID))
@@ -927,23 +1097,26 @@ static int etmv1_analyze_trace(struct etm_context *ctx, struct command_invocatio
 				next_pc = ctx->last_branch;
 				break;
 			case 0x1:	/* tracing enabled */
-				command_print(cmd,
-					"--- tracing enabled at 0x%8.8" PRIx32 " ---",
+				retval = etm_output_event(cmd, out, ETM_RECORD_TRACE_ENABLED,
 					ctx->last_branch);
+				if (retval != ERROR_OK)
+					return retval;
 				ctx->current_pc = ctx->last_branch;
 				ctx->pipe_index++;
 				continue;
 			case 0x2:	/* trace restarted after FIFO overflow */
-				command_print(cmd,
-					"--- trace restarted after FIFO overflow at 0x%8.8" PRIx32 " ---",
+				retval = etm_output_event(cmd, out, ETM_RECORD_FIFO_OVERFLOW,
 					ctx->last_branch);
+				if (retval != ERROR_OK)
+					return retval;
 				ctx->current_pc = ctx->last_branch;
 				ctx->pipe_index++;
 				continue;
 			case 0x3:	/* exit from debug state */
-				command_print(cmd,
-					"--- exit from debug state at 0x%8.8" PRIx32 " ---",
+				retval = etm_output_event(cmd, out, ETM_RECORD_DEBUG_EXIT,
 					ctx->last_branch);
+				if (retval != ERROR_OK)
+					return retval;
 				ctx->current_pc = ctx->last_branch;
 				ctx->pipe_index++;
 				continue;
@@ -953,9 +1126,9 @@ static int etmv1_analyze_trace(struct etm_context *ctx, struct command_invocatio
 				 * we have to move on with the next trace cycle
 				 */
 				if (!current_pc_ok) {
-					command_print(cmd,
-						"--- periodic synchronization point at 0x%8.8" PRIx32 " ---",
-						next_pc);
+					retval = etm_output_event(cmd, out, ETM_RECORD_SYNC, next_pc);
+					if (retval != ERROR_OK)
+						return retval;
 					ctx->current_pc = next_pc;
 					ctx->pipe_index++;
 					continue;
@@ -978,12 +1151,16 @@ static int etmv1_analyze_trace(struct etm_context *ctx, struct command_invocatio
 			if ((ctx->last_branch <= 0x20)
 				|| ((ctx->last_branch >= 0xffff0000) &&
 				(ctx->last_branch <= 0xffff0020))) {
-				if ((ctx->last_branch & 0xff) == 0x10)
-					command_print(cmd, "data abort");
-				else {
-					command_print(cmd,
-						"exception vector 0x%2.2" PRIx32,
+				if ((ctx->last_branch & 0xff) == 0x10) {
+					retval = etm_output_event(cmd, out, ETM_RECORD_DATA_ABORT,
+						ctx->last_branch);
+					if (retval != ERROR_OK)
+						return retval;
+				} else {
+					retval = etm_output_event(cmd, out, ETM_RECORD_EXCEPTION,
 						ctx->last_branch);
+					if (retval != ERROR_OK)
+						return retval;
 					ctx->current_pc = ctx->last_branch;
 					ctx->pipe_index++;
 					continue;
@@ -1038,10 +1215,12 @@ static int etmv1_analyze_trace(struct etm_context *ctx, struct command_invocatio
 				if (shift >= 32)
 					ctx->ptr_ok = 1;
 
-				if (ctx->ptr_ok)
-					command_print(cmd,
-						"address: 0x%8.8" PRIx32,
+				if (ctx->ptr_ok) {
+					retval = etm_output_event(cmd, out, ETM_RECORD_ADDRESS,
 						ctx->last_ptr);
+					if (retval != ERROR_OK)
+						return retval;
+				}
 			}
 
 			if (ctx->control & ETM_CTRL_TRACE_DATA) {
@@ -1054,9 +1233,10 @@ static int etmv1_analyze_trace(struct etm_context *ctx, struct command_invocatio
 							uint32_t data;
 							if (etmv1_data(ctx, 4, &data) != 0)
 								return ERROR_ETM_ANALYSIS_FAILED;
-							command_print(cmd,
-								"data: 0x%8.8" PRIx32,
-								data);
+							retval = etm_output_event(cmd, out,
+								ETM_RECORD_DATA, data);
+							if (retval != ERROR_OK)
+								return retval;
 						}
 					}
 				} else if ((instruction.type >= ARM_LDR) &&
@@ -1065,7 +1245,9 @@ static int etmv1_analyze_trace(struct etm_context *ctx, struct command_invocatio
 					if (etmv1_data(ctx, arm_access_size(&instruction),
 						&data) != 0)
 						return ERROR_ETM_ANALYSIS_FAILED;
-					command_print(cmd, "data: 0x%8.8" PRIx32, data);
+					retval = etm_output_event(cmd, out, ETM_RECORD_DATA, data);
+					if (retval != ERROR_OK)
+						return retval;
 				}
 			}
 
@@ -1089,21 +1271,10 @@ static int etmv1_analyze_trace(struct etm_context *ctx, struct command_invocatio
 			next_pc += (ctx->core_state == ARM_STATE_ARM) ? 4 : 2;
 
 		if ((pipestat != STAT_TD) && (pipestat != STAT_WT)) {
-			char cycles_text[32] = "";
-
-			/* if the trace was captured with cycle accurate tracing enabled,
-			 * output the number of cycles since the last executed instruction
-			 */
-			if (ctx->control & ETM_CTRL_CYCLE_ACCURATE) {
-				snprintf(cycles_text, 32, " (%i %s)",
-					(int)cycles,
-					(cycles == 1) ? "cycle" : "cycles");
-			}
-
-			command_print(cmd, "%s%s%s",
-				instruction.text,
-				(pipestat == STAT_IN) ? " (not executed)" : "",
-				cycles_text);
+			retval = etm_output_instruction(ctx, cmd, out, &instruction,
+				pipestat != STAT_IN, cycles);
+			if (retval != ERROR_OK)
+				return retval;
 
 			ctx->current_pc = next_pc;
 
@@ -1655,6 +1826,7 @@ COMMAND_HANDLER(handle_etm_image_command)
 		free(etm_ctx->image);
 		command_print(CMD, "previously loaded image found and closed");
 	}
+	etm_insn_cache_free(etm_ctx);
 
 	etm_ctx->image = malloc(sizeof(struct image));
 	etm_ctx->image->base_address_set = false;
@@ -1947,8 +2119,12 @@ COMMAND_HANDLER(handle_etm_analyze_command)
 	struct target *target;
 	struct arm *arm;
 	struct etm_context *etm_ctx;
+	struct fileio *out = NULL;
 	int retval;
 
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
 	target = get_current_target(CMD_CTX);
 	arm = target_to_arm(target);
 	if (!is_arm(arm)) {
@@ -1962,7 +2138,13 @@ COMMAND_HANDLER(handle_etm_analyze_command)
 		return ERROR_FAIL;
 	}
 
-	retval = etmv1_analyze_trace(etm_ctx, CMD);
+	if (CMD_ARGC == 1 &&
+			fileio_open(&out, CMD_ARGV[0], FILEIO_WRITE, FILEIO_BINARY) != ERROR_OK)
+		return ERROR_FAIL;
+
+	retval = etmv1_analyze_trace(etm_ctx, CMD, out);
+	if (out)
+		fileio_close(out);
 	if (retval != ERROR_OK) {
 		/* FIX! error should be reported inside etmv1_analyze_trace() */
 		switch (retval) {
@@ -2061,8 +2243,9 @@ static const struct command_registration etm_exec_command_handlers[] = {
 		.name = "analyze",
 		.handler = handle_etm_analyze_command,
 		.mode = COMMAND_EXEC,
-		.usage = "",
-		.help = "analyze collected ETM trace",
+		.usage = "[filename]",
+		.help = "analyze collected ETM trace, optionally writing "
+			"binary records to a file",
 	},
 	{
 		.name = "image",
@@ -273,6 +273,7 @@ static int fa526_init_arch_info_2(struct target *target,
 
 	arm7_9->write_memory = arm920t_write_memory;
 	arm7_9->bulk_write_memory = arm7_9_bulk_write_memory;
+	arm7_9->bulk_read_memory = arm7_9_bulk_read_memory;
 
 	arm7_9->post_debug_entry = NULL;
 
@@ -608,6 +608,8 @@ static void feroceon_common_setup(struct target *target)
 	arm7_9->disable_single_step = feroceon_disable_single_step;
 
 	arm7_9->bulk_write_memory = feroceon_bulk_write_memory;
+	/* the generic DCC read stub relies on a breakpoint to terminate */
+	arm7_9->bulk_read_memory = NULL;
 
 	/* MOE is not implemented */
 	arm7_9->examine_debug_reason = feroceon_examine_debug_reason;
@@ -707,7 +709,7 @@ struct target_type feroceon_target = {
 	.get_gdb_arch = arm_get_gdb_arch,
 	.get_gdb_reg_list = arm_get_gdb_reg_list,
 
-	.read_memory = arm7_9_read_memory,
+	.read_memory = arm7_9_read_memory_opt,
 	.write_memory = arm7_9_write_memory_opt,
 
 	.checksum_memory = arm_checksum_memory,
@@ -746,7 +748,7 @@ struct target_type dragonite_target = {
 	.get_gdb_arch = arm_get_gdb_arch,
 	.get_gdb_reg_list = arm_get_gdb_reg_list,
 
-	.read_memory = arm7_9_read_memory,
+	.read_memory = arm7_9_read_memory_opt,
 	.write_memory = arm7_9_write_memory_opt,
 
 	.checksum_memory = arm_checksum_memory,
@@ -1053,7 +1053,11 @@ int image_open(struct image *image, const char *url, const char *type_string)
 		image->num_sections = 0;
 		image->base_address_set = false;
 		image->sections = NULL;
-		image->type_private = NULL;
+		image->type_private = calloc(1, sizeof(struct image_builder));
+		if (!image->type_private) {
+			LOG_ERROR("Out of memory");
+			return ERROR_FAIL;
+		}
 	}
 
 	if (image->base_address_set) {
@@ -1178,6 +1182,8 @@ int image_add_section(struct image *image, target_addr_t base, uint32_t size, ui
 	if (image->type != IMAGE_BUILDER)
 		return ERROR_COMMAND_SYNTAX_ERROR;
 
+	struct image_builder *builder = image->type_private;
+
 	/* see if there's a previous section */
 	if (image->num_sections) {
 		section = &image->sections[image->num_sections - 1];
@@ -1186,7 +1192,17 @@ int image_add_section(struct image *image, target_addr_t base, uint32_t size, ui
 		 * adding data to previous sections or merging is not supported */
 		if (((section->base_address + section->size) == base) &&
 			(section->flags == flags)) {
-			section->private = realloc(section->private, section->size + size);
+			/* grow geometrically, gdb appends a few KiB per vFlashWrite */
+			if (section->size + size > builder->capacity) {
+				uint32_t capacity = MAX(2 * builder->capacity, section->size + size);
+				uint8_t *buf = realloc(section->private, capacity);
+				if (!buf) {
+					LOG_ERROR("Out of memory");
+					return ERROR_FAIL;
+				}
+				section->private = buf;
+				builder->capacity = capacity;
+			}
 			memcpy((uint8_t *)section->private + section->size, data, size);
 			section->size += size;
 			return ERROR_OK;
@@ -1203,6 +1219,7 @@ int image_add_section(struct image *image, target_addr_t base, uint32_t size, ui
 	section->flags = flags;
 	section->private = malloc(sizeof(uint8_t) * size);
 	memcpy((uint8_t *)section->private, data, size);
+	builder->capacity = size;
 
 	return ERROR_OK;
 }
@@ -1264,11 +1281,8 @@ void image_close(struct image *image)
 	image->sections = NULL;
 }
 
-int image_calculate_checksum(const uint8_t *buffer, uint32_t nbytes, uint32_t *checksum)
+const uint32_t *image_crc32_table(void)
 {
-	uint32_t crc = 0xffffffff;
-	LOG_DEBUG("Calculating checksum");
-
 	static uint32_t crc32_table[256];
 
 	static bool first_init;
@@ -1285,6 +1299,16 @@ int image_calculate_checksum(const uint8_t *buffer, uint32_t nbytes, uint32_t *c
 		first_init = true;
 	}
 
+	return crc32_table;
+}
+
+/* Continues the CRC in *checksum over another block, so large areas can be
+ * checksummed piecewise */
+int image_update_checksum(const uint8_t *buffer, uint32_t nbytes, uint32_t *checksum)
+{
+	const uint32_t *crc32_table = image_crc32_table();
+	uint32_t crc = *checksum;
+
 	while (nbytes > 0) {
 		int run = nbytes;
 		if (run > 32768)
@@ -1299,6 +1323,19 @@ int image_calculate_checksum(const uint8_t *buffer, uint32_t nbytes, uint32_t *c
 			return ERROR_SERVER_INTERRUPTED;
 	}
 
+	*checksum = crc;
+	return ERROR_OK;
+}
+
+int image_calculate_checksum(const uint8_t *buffer, uint32_t nbytes, uint32_t *checksum)
+{
+	uint32_t crc = 0xffffffff;
+	LOG_DEBUG("Calculating checksum");
+
+	int retval = image_update_checksum(buffer, nbytes, &crc);
+	if (retval != ERROR_OK)
+		return retval;
+
 	LOG_DEBUG("Calculating checksum done; checksum=0x%" PRIx32, crc);
 
 	*checksum = crc;
@@ -65,6 +65,10 @@ struct image_ihex {
 	uint8_t *buffer;
 };
 
+struct image_builder {
+	uint32_t capacity;		/* allocated size of the last section */
+};
+
 struct image_memory {
 	struct target *target;
 	uint8_t *cache;
@@ -101,6 +105,9 @@ int image_add_section(struct image *image, target_addr_t base, uint32_t size,
 
 int image_calculate_checksum(const uint8_t *buffer, uint32_t nbytes,
 		uint32_t *checksum);
+int image_update_checksum(const uint8_t *buffer, uint32_t nbytes,
+		uint32_t *checksum);
+const uint32_t *image_crc32_table(void);
 
 #define ERROR_IMAGE_FORMAT_ERROR	(-1400)
 #define ERROR_IMAGE_TYPE_UNKNOWN	(-1401)
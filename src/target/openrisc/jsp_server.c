@@ -117,19 +117,27 @@ static int jsp_input(struct connection *connection)
 
 	buf_p = buffer;
 	while (bytes_read) {
+		int consumed = 1;
+
 		switch (t_con->state) {
 		case TELNET_STATE_DATA:
 			if (*buf_p == 0xff) {
 				t_con->state = TELNET_STATE_IAC;
 			} else {
+				/* Send as many plain characters as a JSP transfer takes */
 				int out_len = 1;
-				int in_len;
+				while (out_len < 8 && out_len < bytes_read && buf_p[out_len] != 0xff)
+					out_len++;
+
+				int in_len = 0;
 				unsigned char in_buffer[10];
 				or1k_adv_jtag_jsp_xfer(jsp_service->jtag_info,
 						       &out_len, buf_p, &in_len,
 						       in_buffer);
 				if (in_len)
 					telnet_write(connection, in_buffer, in_len);
+				if (out_len > 0)
+					consumed = out_len;
 			}
 			break;
 		case TELNET_STATE_IAC:
@@ -163,8 +171,8 @@ static int jsp_input(struct connection *connection)
 			exit(-1);
 		}
 
-		bytes_read--;
-		buf_p++;
+		bytes_read -= consumed;
+		buf_p += consumed;
 	}
 
 	return ERROR_OK;
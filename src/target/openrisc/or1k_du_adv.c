@@ -119,6 +119,8 @@
 #define MAX_BUS_ERRORS			2
 
 #define MAX_BURST_SIZE			(4 * 1024)
+/* Bursts queued together before their status and CRC are checked */
+#define MAX_PIPELINED_BURSTS		8
 
 #define STATUS_BYTES			1
 #define CRC_LEN				4
@@ -389,8 +391,8 @@ static int adbg_ctrl_read(struct or1k_jtag *jtag_info, uint32_t regidx,
  * 32-bit address
  * 16-bit length (of the burst, in words)
  */
-static int adbg_burst_command(struct or1k_jtag *jtag_info, uint32_t opcode,
-			      uint32_t address, uint16_t length_words)
+static void adbg_queue_burst_command(struct or1k_jtag *jtag_info, uint32_t opcode,
+				     uint32_t address, uint16_t length_words)
 {
 	uint32_t data[2];
 
@@ -406,52 +408,49 @@ static int adbg_burst_command(struct or1k_jtag *jtag_info, uint32_t opcode,
 	field.in_value = NULL;
 
 	jtag_add_dr_scan(jtag_info->tap, 1, &field, TAP_IDLE);
-
-	return jtag_execute_queue();
 }
 
-static int adbg_wb_burst_read(struct or1k_jtag *jtag_info, int size,
-			      int count, uint32_t start_address, uint8_t *data)
+static int adbg_burst_command(struct or1k_jtag *jtag_info, uint32_t opcode,
+			      uint32_t address, uint16_t length_words)
 {
-	int retry_full_crc = 0;
-	int retry_full_busy = 0;
-	int retval;
-	uint8_t opcode;
+	adbg_queue_burst_command(jtag_info, opcode, address, length_words);
 
-	LOG_DEBUG("Doing burst read, word size %d, word count %d, start address 0x%08" PRIx32,
-		  size, count, start_address);
+	return jtag_execute_queue();
+}
 
-	/* Select the appropriate opcode */
+static int adbg_wb_read_opcode(struct or1k_jtag *jtag_info, int size,
+			       uint8_t *opcode)
+{
 	switch (jtag_info->or1k_jtag_module_selected) {
 	case DC_WISHBONE:
 		if (size == 1)
-			opcode = DBG_WB_CMD_BREAD8;
+			*opcode = DBG_WB_CMD_BREAD8;
 		else if (size == 2)
-			opcode = DBG_WB_CMD_BREAD16;
+			*opcode = DBG_WB_CMD_BREAD16;
 		else if (size == 4)
-			opcode = DBG_WB_CMD_BREAD32;
+			*opcode = DBG_WB_CMD_BREAD32;
 		else {
 			LOG_WARNING("Tried burst read with invalid word size (%d),"
 				  "defaulting to 4-byte words", size);
-			opcode = DBG_WB_CMD_BREAD32;
+			*opcode = DBG_WB_CMD_BREAD32;
 		}
 		break;
 	case DC_CPU0:
 		if (size == 4)
-			opcode = DBG_CPU0_CMD_BREAD32;
+			*opcode = DBG_CPU0_CMD_BREAD32;
 		else {
 			LOG_WARNING("Tried burst read with invalid word size (%d),"
 				  "defaulting to 4-byte words", size);
-			opcode = DBG_CPU0_CMD_BREAD32;
+			*opcode = DBG_CPU0_CMD_BREAD32;
 		}
 		break;
 	case DC_CPU1:
 		if (size == 4)
-			opcode = DBG_CPU1_CMD_BREAD32;
+			*opcode = DBG_CPU1_CMD_BREAD32;
 		else {
 			LOG_WARNING("Tried burst read with invalid word size (%d),"
 				  "defaulting to 4-byte words", size);
-			opcode = DBG_CPU0_CMD_BREAD32;
+			*opcode = DBG_CPU0_CMD_BREAD32;
 		}
 		break;
 	default:
@@ -460,6 +459,69 @@ static int adbg_wb_burst_read(struct or1k_jtag *jtag_info, int size,
 		return ERROR_FAIL;
 	}
 
+	return ERROR_OK;
+}
+
+static int adbg_wb_write_opcode(struct or1k_jtag *jtag_info, int size,
+				uint8_t *opcode)
+{
+	switch (jtag_info->or1k_jtag_module_selected) {
+	case DC_WISHBONE:
+		if (size == 1)
+			*opcode = DBG_WB_CMD_BWRITE8;
+		else if (size == 2)
+			*opcode = DBG_WB_CMD_BWRITE16;
+		else if (size == 4)
+			*opcode = DBG_WB_CMD_BWRITE32;
+		else {
+			LOG_DEBUG("Tried WB burst write with invalid word size (%d),"
+				  "defaulting to 4-byte words", size);
+			*opcode = DBG_WB_CMD_BWRITE32;
+		}
+		break;
+	case DC_CPU0:
+		if (size == 4)
+			*opcode = DBG_CPU0_CMD_BWRITE32;
+		else {
+			LOG_DEBUG("Tried CPU0 burst write with invalid word size (%d),"
+				  "defaulting to 4-byte words", size);
+			*opcode = DBG_CPU0_CMD_BWRITE32;
+		}
+		break;
+	case DC_CPU1:
+		if (size == 4)
+			*opcode = DBG_CPU1_CMD_BWRITE32;
+		else {
+			LOG_DEBUG("Tried CPU1 burst write with invalid word size (%d),"
+				  "defaulting to 4-byte words", size);
+			*opcode = DBG_CPU0_CMD_BWRITE32;
+		}
+		break;
+	default:
+		LOG_ERROR("Illegal debug chain selected (%i) while doing burst write",
+			  jtag_info->or1k_jtag_module_selected);
+		return ERROR_FAIL;
+	}
+
+	return ERROR_OK;
+}
+
+static int adbg_wb_burst_read(struct or1k_jtag *jtag_info, int size,
+			      int count, uint32_t start_address, uint8_t *data)
+{
+	int retry_full_crc = 0;
+	int retry_full_busy = 0;
+	int retval;
+	uint8_t opcode;
+
+	LOG_DEBUG("Doing burst read, word size %d, word count %d, start address 0x%08" PRIx32,
+		  size, count, start_address);
+
+	/* Select the appropriate opcode */
+	retval = adbg_wb_read_opcode(jtag_info, size, &opcode);
+	if (retval != ERROR_OK)
+		return retval;
+
 	int total_size_bytes = count * size;
 	struct scan_field field;
 	uint8_t *in_buffer = malloc(total_size_bytes + CRC_LEN + STATUS_BYTES);
@@ -576,43 +638,9 @@ static int adbg_wb_burst_write(struct or1k_jtag *jtag_info, const uint8_t *data,
 		  "start address 0x%08lx", size, count, start_address);
 
 	/* Select the appropriate opcode */
-	switch (jtag_info->or1k_jtag_module_selected) {
-	case DC_WISHBONE:
-		if (size == 1)
-			opcode = DBG_WB_CMD_BWRITE8;
-		else if (size == 2)
-			opcode = DBG_WB_CMD_BWRITE16;
-		else if (size == 4)
-			opcode = DBG_WB_CMD_BWRITE32;
-		else {
-			LOG_DEBUG("Tried WB burst write with invalid word size (%d),"
-				  "defaulting to 4-byte words", size);
-			opcode = DBG_WB_CMD_BWRITE32;
-		}
-		break;
-	case DC_CPU0:
-		if (size == 4)
-			opcode = DBG_CPU0_CMD_BWRITE32;
-		else {
-			LOG_DEBUG("Tried CPU0 burst write with invalid word size (%d),"
-				  "defaulting to 4-byte words", size);
-			opcode = DBG_CPU0_CMD_BWRITE32;
-		}
-		break;
-	case DC_CPU1:
-		if (size == 4)
-			opcode = DBG_CPU1_CMD_BWRITE32;
-		else {
-			LOG_DEBUG("Tried CPU1 burst write with invalid word size (%d),"
-				  "defaulting to 4-byte words", size);
-			opcode = DBG_CPU0_CMD_BWRITE32;
-		}
-		break;
-	default:
-		LOG_ERROR("Illegal debug chain selected (%i) while doing burst write",
-			  jtag_info->or1k_jtag_module_selected);
-		return ERROR_FAIL;
-	}
+	retval = adbg_wb_write_opcode(jtag_info, size, &opcode);
+	if (retval != ERROR_OK)
+		return retval;
 
 retry_full_write:
 
@@ -704,6 +732,186 @@ retry_full_write:
 	return ERROR_OK;
 }
 
+/* Check the WB error register after pipelined bursts, and clear it if set.
+ * Bursts are then redone one by one, which takes care of the error. */
+static int adbg_wb_pipelined_bus_error(struct or1k_jtag *jtag_info, bool *bus_error)
+{
+	uint32_t err_data[2] = {0, 0};
+
+	*bus_error = false;
+	if (jtag_info->or1k_jtag_module_selected != DC_WISHBONE ||
+	    (or1k_du_adv.options & ADBG_USE_HISPEED))
+		return ERROR_OK;
+
+	int retval = adbg_ctrl_read(jtag_info, DBG_WB_REG_ERROR, err_data, 1);
+	if (retval != ERROR_OK)
+		return retval;
+
+	if (!(err_data[0] & 0x1))
+		return ERROR_OK;
+
+	LOG_DEBUG("WB bus error during pipelined bursts, retrying burst by burst");
+	*bus_error = true;
+	err_data[0] = 1;
+	return adbg_ctrl_write(jtag_info, DBG_WB_REG_ERROR, err_data, 1);
+}
+
+/* Queue up to MAX_PIPELINED_BURSTS burst reads in a single JTAG queue, then
+ * check them. Bursts that were not ready or failed their CRC are read again
+ * through adbg_wb_burst_read(), which also handles the retries. */
+static int adbg_wb_burst_read_pipelined(struct or1k_jtag *jtag_info, int size,
+					int count, uint32_t start_address, uint8_t *data)
+{
+	int bursts = DIV_ROUND_UP(count, MAX_BURST_SIZE);
+	int burst_bytes = MAX_BURST_SIZE * size + CRC_LEN + STATUS_BYTES;
+	uint8_t opcode;
+
+	assert(bursts <= MAX_PIPELINED_BURSTS);
+	if (bursts == 1)
+		return adbg_wb_burst_read(jtag_info, size, count, start_address, data);
+
+	int retval = adbg_wb_read_opcode(jtag_info, size, &opcode);
+	if (retval != ERROR_OK)
+		return retval;
+
+	uint8_t *in_buffer = malloc(bursts * burst_bytes);
+	if (!in_buffer) {
+		LOG_ERROR("Out of memory");
+		return ERROR_FAIL;
+	}
+
+	for (int i = 0; i < bursts; i++) {
+		int words = MIN(count - i * MAX_BURST_SIZE, MAX_BURST_SIZE);
+		struct scan_field field;
+
+		adbg_queue_burst_command(jtag_info, opcode,
+			start_address + i * MAX_BURST_SIZE * size, words);
+
+		field.num_bits = (words * size + CRC_LEN + STATUS_BYTES) * 8;
+		field.out_value = NULL;
+		field.in_value = &in_buffer[i * burst_bytes];
+		jtag_add_dr_scan(jtag_info->tap, 1, &field, TAP_IDLE);
+	}
+
+	retval = jtag_execute_queue();
+	if (retval != ERROR_OK)
+		goto out;
+
+	bool bus_error;
+	retval = adbg_wb_pipelined_bus_error(jtag_info, &bus_error);
+	if (retval != ERROR_OK)
+		goto out;
+
+	for (int i = 0; i < bursts; i++) {
+		int words = MIN(count - i * MAX_BURST_SIZE, MAX_BURST_SIZE);
+		int total_size_bytes = words * size;
+		uint32_t address = start_address + i * MAX_BURST_SIZE * size;
+		uint8_t *burst_data = data + i * MAX_BURST_SIZE * size;
+		uint8_t *burst_in = &in_buffer[i * burst_bytes];
+
+		int shift = find_status_bit(burst_in, STATUS_BYTES);
+		if (!bus_error && shift >= 0) {
+			uint32_t crc_read;
+
+			buffer_shr(burst_in, total_size_bytes + CRC_LEN + STATUS_BYTES, shift);
+			memcpy(&crc_read, &burst_in[total_size_bytes], 4);
+			if (crc32_le(CRC32_POLY_LE, 0xffffffff, burst_in,
+					total_size_bytes) == crc_read) {
+				memcpy(burst_data, burst_in, total_size_bytes);
+				continue;
+			}
+		}
+
+		LOG_DEBUG("Pipelined burst at 0x%08" PRIx32 " failed, reading it again", address);
+		retval = adbg_wb_burst_read(jtag_info, size, words, address, burst_data);
+		if (retval != ERROR_OK)
+			goto out;
+	}
+
+out:
+	free(in_buffer);
+	return retval;
+}
+
+/* Queue up to MAX_PIPELINED_BURSTS burst writes in a single JTAG queue, then
+ * check their 'CRC match' bits. Failed bursts are written again through
+ * adbg_wb_burst_write(), which also handles the retries. */
+static int adbg_wb_burst_write_pipelined(struct or1k_jtag *jtag_info, const uint8_t *data,
+					 int size, int count, uint32_t start_address)
+{
+	int bursts = DIV_ROUND_UP(count, MAX_BURST_SIZE);
+	uint32_t crc_calc[MAX_PIPELINED_BURSTS];
+	uint8_t match[MAX_PIPELINED_BURSTS];
+	uint8_t opcode;
+
+	assert(bursts <= MAX_PIPELINED_BURSTS);
+	if (bursts == 1)
+		return adbg_wb_burst_write(jtag_info, data, size, count, start_address);
+
+	int retval = adbg_wb_write_opcode(jtag_info, size, &opcode);
+	if (retval != ERROR_OK)
+		return retval;
+
+	for (int i = 0; i < bursts; i++) {
+		int words = MIN(count - i * MAX_BURST_SIZE, MAX_BURST_SIZE);
+		const uint8_t *burst_data = data + i * MAX_BURST_SIZE * size;
+		struct scan_field field[3];
+		uint8_t start_bit = 1;
+
+		adbg_queue_burst_command(jtag_info, opcode,
+			start_address + i * MAX_BURST_SIZE * size, words);
+
+		crc_calc[i] = crc32_le(CRC32_POLY_LE, 0xffffffff, burst_data,
+				words * size);
+
+		field[0].num_bits = 1;
+		field[0].out_value = &start_bit;
+		field[0].in_value = NULL;
+
+		field[1].num_bits = words * size * 8;
+		field[1].out_value = burst_data;
+		field[1].in_value = NULL;
+
+		field[2].num_bits = 32;
+		field[2].out_value = (uint8_t *)&crc_calc[i];
+		field[2].in_value = NULL;
+
+		jtag_add_dr_scan(jtag_info->tap, 3, field, TAP_DRSHIFT);
+
+		/* Read the 'CRC match' bit, and go to idle */
+		match[i] = 0;
+		field[0].num_bits = 1;
+		field[0].out_value = NULL;
+		field[0].in_value = &match[i];
+		jtag_add_dr_scan(jtag_info->tap, 1, field, TAP_IDLE);
+	}
+
+	retval = jtag_execute_queue();
+	if (retval != ERROR_OK)
+		return retval;
+
+	bool bus_error;
+	retval = adbg_wb_pipelined_bus_error(jtag_info, &bus_error);
+	if (retval != ERROR_OK)
+		return retval;
+
+	for (int i = 0; i < bursts; i++) {
+		if (!bus_error && (match[i] & 0x1))
+			continue;
+
+		int words = MIN(count - i * MAX_BURST_SIZE, MAX_BURST_SIZE);
+		uint32_t address = start_address + i * MAX_BURST_SIZE * size;
+
+		LOG_DEBUG("Pipelined burst at 0x%08" PRIx32 " failed, writing it again", address);
+		retval = adbg_wb_burst_write(jtag_info, data + i * MAX_BURST_SIZE * size,
+					     size, words, address);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	return ERROR_OK;
+}
+
 /* Currently hard set in functions to 32-bits */
 static int or1k_adv_jtag_read_cpu(struct or1k_jtag *jtag_info,
 		uint32_t addr, int count, uint32_t *value)
@@ -855,17 +1063,17 @@ static int or1k_adv_jtag_read_memory(struct or1k_jtag *jtag_info,
 
 	while (block_count_left) {
 
-		int blocks_this_round = (block_count_left > MAX_BURST_SIZE) ?
-			MAX_BURST_SIZE : block_count_left;
+		int blocks_this_round = MIN(block_count_left,
+			MAX_BURST_SIZE * MAX_PIPELINED_BURSTS);
 
-		retval = adbg_wb_burst_read(jtag_info, size, blocks_this_round,
-					    block_count_address, block_count_buffer);
+		retval = adbg_wb_burst_read_pipelined(jtag_info, size, blocks_this_round,
+						      block_count_address, block_count_buffer);
 		if (retval != ERROR_OK)
 			return retval;
 
 		block_count_left -= blocks_this_round;
-		block_count_address += size * MAX_BURST_SIZE;
-		block_count_buffer += size * MAX_BURST_SIZE;
+		block_count_address += size * blocks_this_round;
+		block_count_buffer += size * blocks_this_round;
 	}
 
 	/* The adv_debug_if always return words and half words in
@@ -938,20 +1146,20 @@ static int or1k_adv_jtag_write_memory(struct or1k_jtag *jtag_info,
 
 	while (block_count_left) {
 
-		int blocks_this_round = (block_count_left > MAX_BURST_SIZE) ?
-			MAX_BURST_SIZE : block_count_left;
+		int blocks_this_round = MIN(block_count_left,
+			MAX_BURST_SIZE * MAX_PIPELINED_BURSTS);
 
-		retval = adbg_wb_burst_write(jtag_info, block_count_buffer,
-					     size, blocks_this_round,
-					     block_count_address);
+		retval = adbg_wb_burst_write_pipelined(jtag_info, block_count_buffer,
+						       size, blocks_this_round,
+						       block_count_address);
 		if (retval != ERROR_OK) {
 			free(t);
 			return retval;
 		}
 
 		block_count_left -= blocks_this_round;
-		block_count_address += size * MAX_BURST_SIZE;
-		block_count_buffer += size * MAX_BURST_SIZE;
+		block_count_address += size * blocks_this_round;
+		block_count_buffer += size * blocks_this_round;
 	}
 
 	free(t);
@@ -17,6 +17,7 @@
 #include "target/target.h"
 #include "target/algorithm.h"
 #include "target/target_type.h"
+#include <target/smp.h>
 #include <helper/align.h>
 #include <helper/log.h>
 #include "jtag/jtag.h"
@@ -2826,6 +2827,174 @@ static int riscv013_get_hart_state(struct target *target, enum riscv_hart_state
 	return ERROR_FAIL;
 }
 
+static int select_prepped_harts(struct target *target);
+
+static int riscv013_get_group_running(struct target *target,
+		struct list_head *targets, bool *all_running)
+{
+	*all_running = false;
+
+	dm013_info_t *dm = get_dm(target);
+	if (!dm || !dm->hasel_supported)
+		return ERROR_OK;
+
+	/* The hart array mask only helps when the whole group is on this DM */
+	struct target_list *entry;
+	unsigned int count = 0;
+	foreach_smp_target(entry, targets) {
+		struct target *t = entry->target;
+		if (!target_was_examined(t) || get_dm(t) != dm)
+			return ERROR_OK;
+		count++;
+	}
+	if (count < 2)
+		return ERROR_OK;
+
+	foreach_smp_target(entry, targets)
+		riscv_info(entry->target)->prepped = true;
+
+	int result = select_prepped_harts(target);
+	if (result != ERROR_OK) {
+		foreach_smp_target(entry, targets)
+			riscv_info(entry->target)->prepped = false;
+		return result;
+	}
+
+	uint32_t dmstatus;
+	result = dmstatus_read(target, &dmstatus, true);
+	if (result != ERROR_OK)
+		return result;
+
+	/* allrunning covers every selected hart, anyhavereset must be
+	 * acknowledged hart by hart in riscv013_get_hart_state() */
+	*all_running = get_field(dmstatus, DM_DMSTATUS_ALLRUNNING) &&
+		!get_field(dmstatus, DM_DMSTATUS_ANYHAVERESET);
+	return ERROR_OK;
+}
+
+/* Scans per register in prefetch_registers(): command, up to two data
+ * words and abstractcs. */
+#define PREFETCH_SCANS_PER_REG	4
+
+/**
+ * Read the registers in regs that aren't cached yet into the register cache,
+ * queueing one abstract command per register into a single batch.
+ * abstractcs is sampled after each register, so every value read before the
+ * first failing command is still used. Registers that aren't fetched here
+ * are simply read on demand later.
+ */
+static int prefetch_registers(struct target *target,
+		const enum gdb_regno *regs, unsigned int count)
+{
+	dm013_info_t *dm = get_dm(target);
+	if (!dm || !target->reg_cache)
+		return ERROR_FAIL;
+
+	enum gdb_regno *queued = calloc(count, sizeof(*queued));
+	uint32_t *commands = calloc(count, sizeof(*commands));
+	size_t *keys = calloc(count, sizeof(*keys));
+	struct riscv_batch *batch = riscv_batch_alloc(target,
+			count * PREFETCH_SCANS_PER_REG);
+	unsigned int n = 0, i;
+	int result = ERROR_FAIL;
+	if (!queued || !commands || !keys || !batch)
+		goto cleanup;
+
+	for (i = 0; i < count; i++) {
+		const struct reg *reg = &target->reg_cache->reg_list[regs[i]];
+		if (!reg->exist || reg->valid || reg->dirty)
+			continue;
+
+		const unsigned int size = register_size(target, regs[i]);
+		if (size != 32 && size != 64)
+			continue;
+		const uint32_t command = riscv013_access_register_command(target,
+				regs[i], size, AC_ACCESS_REGISTER_TRANSFER);
+		if (is_command_unsupported(target, command))
+			continue;
+
+		riscv_batch_add_dm_write(batch, DM_COMMAND, command,
+				/* read_back */ true, RISCV_DELAY_ABSTRACT_COMMAND);
+		keys[n] = riscv_batch_add_dm_read(batch, DM_DATA0, RISCV_DELAY_BASE);
+		if (size == 64)
+			riscv_batch_add_dm_read(batch, DM_DATA1, RISCV_DELAY_BASE);
+		riscv_batch_add_dm_read(batch, DM_ABSTRACTCS, RISCV_DELAY_BASE);
+		queued[n] = regs[i];
+		commands[n] = command;
+		n++;
+	}
+
+	result = ERROR_OK;
+	if (n == 0)
+		goto cleanup;
+
+	result = dm013_select_target(target);
+	if (result != ERROR_OK)
+		goto cleanup;
+
+	/* Abstract commands are executed while running the batch. */
+	dm->abstract_cmd_maybe_busy = true;
+	result = batch_run_timeout(target, batch);
+	if (result != ERROR_OK)
+		goto cleanup;
+
+	for (i = 0; i < n; i++) {
+		const unsigned int size = register_size(target, queued[i]);
+		const size_t abstractcs_key = keys[i] + (size == 64 ? 2 : 1);
+		const uint32_t abstractcs = riscv_batch_get_dmi_read_data(batch,
+				abstractcs_key);
+		/* A busy command leaves data[] stale and makes later ones fail */
+		if (get_field32(abstractcs, DM_ABSTRACTCS_BUSY) ||
+				get_field32(abstractcs, DM_ABSTRACTCS_CMDERR) != CMDERR_NONE) {
+			uint32_t cmderr;
+			if (abstract_cmd_batch_check_and_clear_cmderr(target, batch,
+						abstractcs_key, &cmderr) != ERROR_OK &&
+					cmderr == CMDERR_NOT_SUPPORTED)
+				mark_command_as_unsupported(target, commands[i]);
+			/* Commands queued after a failing one fail with cmderr busy */
+			result = dm_write(target, DM_ABSTRACTCS, DM_ABSTRACTCS_CMDERR);
+			break;
+		}
+
+		riscv_reg_t value = riscv_batch_get_dmi_read_data(batch, keys[i]);
+		if (size == 64)
+			value |= (riscv_reg_t)riscv_batch_get_dmi_read_data(batch,
+					keys[i] + 1) << 32;
+
+		struct reg *reg = &target->reg_cache->reg_list[queued[i]];
+		buf_set_u64(reg->value, 0, reg->size, value);
+		reg->valid = true;
+		reg->dirty = false;
+		LOG_TARGET_DEBUG(target, "%s = 0x%" PRIx64 " (prefetched)", reg->name, value);
+	}
+	if (i == n)
+		dm->abstract_cmd_maybe_busy = false;
+	LOG_TARGET_DEBUG(target, "Prefetched %u of %u registers", i, n);
+
+cleanup:
+	if (batch)
+		riscv_batch_free(batch);
+	free(keys);
+	free(commands);
+	free(queued);
+	return result;
+}
+
+static int handle_became_halted(struct target *target,
+		enum riscv_hart_state previous_riscv_state)
+{
+	/* gdb asks for the general registers and pc right after every halt */
+	enum gdb_regno regs[GDB_REGNO_XPR31 - GDB_REGNO_ZERO + 1];
+	unsigned int count = 0;
+	for (enum gdb_regno r = GDB_REGNO_ZERO + 1; r <= GDB_REGNO_XPR31; r++)
+		regs[count++] = r;
+	regs[count++] = GDB_REGNO_DPC;
+
+	if (prefetch_registers(target, regs, count) != ERROR_OK)
+		LOG_TARGET_DEBUG(target, "Register prefetch failed, reading on demand.");
+	return ERROR_OK;
+}
+
 static int handle_became_unavailable(struct target *target,
 		enum riscv_hart_state previous_riscv_state)
 {
@@ -2859,6 +3028,7 @@ static int init_target(struct command_context *cmd_ctx,
 
 	generic_info->select_target = &dm013_select_target;
 	generic_info->get_hart_state = &riscv013_get_hart_state;
+	generic_info->get_group_running = &riscv013_get_group_running;
 	generic_info->resume_go = &riscv013_resume_go;
 	generic_info->step_current_hart = &riscv013_step_current_hart;
 	generic_info->resume_prep = &riscv013_resume_prep;
@@ -2885,6 +3055,7 @@ static int init_target(struct command_context *cmd_ctx,
 	generic_info->get_impebreak = &riscv013_get_impebreak;
 	generic_info->get_progbufsize = &riscv013_get_progbufsize;
 
+	generic_info->handle_became_halted = &handle_became_halted;
 	generic_info->handle_became_unavailable = &handle_became_unavailable;
 	generic_info->tick = &tick;
 
@@ -4020,6 +4020,56 @@ exit:
 	return result;
 }
 
+/* Whether all harts of the group are still running, as we last saw them,
+ * judging from a single summary read */
+static bool riscv_group_still_running(struct target *target, struct list_head *targets)
+{
+	RISCV_INFO(r);
+
+	if (!r->get_group_running)
+		return false;
+
+	struct target_list *entry;
+	foreach_smp_target(entry, targets) {
+		struct target *t = entry->target;
+		if (t->state != TARGET_RUNNING && t->state != TARGET_DEBUG_RUNNING)
+			return false;
+	}
+
+	bool all_running;
+	if (r->get_group_running(target, targets, &all_running) != ERROR_OK)
+		return false;
+
+	return all_running;
+}
+
+static int riscv_poll_tick(struct target *target, struct list_head *targets)
+{
+	struct target_list *entry;
+
+	/* Call tick() for every hart. What happens in tick() is opaque to this
+	 * layer. The reason it's outside the previous loop is that at this point
+	 * the state of every hart has settled, so any side effects happening in
+	 * tick() won't affect the delicate poll() code. */
+	foreach_smp_target(entry, targets) {
+		struct target *t = entry->target;
+		struct riscv_info *info = riscv_info(t);
+		if (info->tick && info->tick(t) != ERROR_OK)
+			return ERROR_FAIL;
+	}
+
+	/* Sample memory if any target is running. */
+	foreach_smp_target(entry, targets) {
+		struct target *t = entry->target;
+		if (t->state == TARGET_RUNNING) {
+			sample_memory(target);
+			break;
+		}
+	}
+
+	return ERROR_OK;
+}
+
 /*** OpenOCD Interface ***/
 int riscv_openocd_poll(struct target *target)
 {
@@ -4044,6 +4094,13 @@ int riscv_openocd_poll(struct target *target)
 		targets = &single_target_list;
 	}
 
+	/* Only look at the harts one by one when the group summary changed */
+	if (target->smp && riscv_group_still_running(target, targets)) {
+		LOG_TARGET_DEBUG(target, "All harts still running.");
+		i->halt_group_repoll_count = 0;
+		return riscv_poll_tick(target, targets);
+	}
+
 	unsigned int should_remain_halted = 0;
 	unsigned int should_resume = 0;
 	unsigned int halted = 0;
@@ -4168,27 +4225,7 @@ int riscv_openocd_poll(struct target *target)
 
 	i->halt_group_repoll_count = 0;
 
-	/* Call tick() for every hart. What happens in tick() is opaque to this
-	 * layer. The reason it's outside the previous loop is that at this point
-	 * the state of every hart has settled, so any side effects happening in
-	 * tick() won't affect the delicate poll() code. */
-	foreach_smp_target(entry, targets) {
-		struct target *t = entry->target;
-		struct riscv_info *info = riscv_info(t);
-		if (info->tick && info->tick(t) != ERROR_OK)
-			return ERROR_FAIL;
-	}
-
-	/* Sample memory if any target is running. */
-	foreach_smp_target(entry, targets) {
-		struct target *t = entry->target;
-		if (t->state == TARGET_RUNNING) {
-			sample_memory(target);
-			break;
-		}
-	}
-
-	return ERROR_OK;
+	return riscv_poll_tick(target, targets);
 }
 
 static int riscv_openocd_step_impl(struct target *target, bool current,
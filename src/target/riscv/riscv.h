@@ -247,6 +247,11 @@ struct riscv_info {
 	 * implementations. */
 	int (*select_target)(struct target *target);
 	int (*get_hart_state)(struct target *target, enum riscv_hart_state *state);
+	/* Optional. Reads the summary state of all harts in targets at once.
+	 * Sets *all_running if each of them is running and none was reset,
+	 * so that they needn't be polled one by one. */
+	int (*get_group_running)(struct target *target, struct list_head *targets,
+		bool *all_running);
 	/* Resume this target, as well as every other prepped target that can be
 	 * resumed near-simultaneously. Clear the prepped flag on any target that
 	 * was resumed. */
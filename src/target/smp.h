@@ -11,6 +11,7 @@
 
 #include <helper/list.h>
 #include "server/server.h"
+#include "target.h"
 
 #define foreach_smp_target(pos, head) \
 	list_for_each_entry(pos, head, lh)
@@ -18,6 +19,16 @@
 #define foreach_smp_target_direction(forward, pos, head) \
 	list_for_each_entry_direction(forward, pos, head, lh)
 
+/**
+ * Whether the SMP group of @a target is presented to gdb as one inferior
+ * with a thread per core: SMP is on, or the group is decoupled for gdb
+ * non-stop mode.
+ */
+static inline bool target_smp_threads(const struct target *target)
+{
+	return target->smp || target->smp_nonstop;
+}
+
 extern const struct command_registration smp_command_handlers[];
 
 /* DEPRECATED */
@@ -31,6 +31,8 @@
 #endif
 
 #include <helper/align.h>
+#include <helper/bits.h>
+#include <helper/crc32.h>
 #include <helper/list.h>
 #include <helper/nvp.h>
 #include <helper/time_support.h>
@@ -53,6 +55,9 @@
 /* default halt wait timeout (ms) */
 #define DEFAULT_HALT_TIMEOUT 5000
 
+/* largest block target_checksum_memory() reads back at once */
+#define TARGET_CHECKSUM_READ_CHUNK (64 * 1024)
+
 struct target_event_action {
 	enum target_event event;
 	Jim_Interp *interp;
@@ -65,6 +70,18 @@ static int target_read_buffer_default(struct target *target, target_addr_t addre
 static int target_write_buffer_default(struct target *target, target_addr_t address,
 		uint32_t count, const uint8_t *buffer);
 static int target_register_user_commands(struct command_context *cmd_ctx);
+static bool target_release_resident_working_areas(struct target *target,
+		target_addr_t address, target_addr_t size);
+static void target_release_all_resident_working_areas(struct target *target);
+static int target_end_working_area_session(struct target *target);
+static int target_restore_working_area(struct target *target, target_addr_t address, uint32_t size);
+static void target_overlay_working_area_backup(struct target *target,
+		target_addr_t address, uint32_t size, uint8_t *buffer);
+static int target_restore_free_working_areas(struct target *target,
+		target_addr_t address, target_addr_t size);
+static void target_poll_soon(struct target *target);
+static void target_free_all_jobs(void);
+static void target_cancel_all_jobs(void);
 static int target_get_gdb_fileio_info_default(struct target *target,
 		struct gdb_fileio_info *fileio_info);
 static int target_gdb_fileio_end_default(struct target *target, int retcode,
@@ -114,7 +131,13 @@ static struct target_type *target_types[] = {
 
 struct target *all_targets;
 static struct target_event_callback *target_event_callbacks;
-static struct target_timer_callback *target_timer_callbacks;
+/* timer callbacks, as a binary min-heap ordered by due time */
+static struct target_timer_callback **target_timer_heap;
+static unsigned int target_timer_heap_len;
+static unsigned int target_timer_heap_size;
+static unsigned int target_timer_seq;
+/* set while every periodic callback is run regardless of its due time */
+static bool target_timer_forced;
 static int64_t target_timer_next_event_value;
 static OOCD_LIST_HEAD(target_reset_callback_list);
 static OOCD_LIST_HEAD(target_trace_callback_list);
@@ -202,6 +225,8 @@ static const struct nvp nvp_target_event[] = {
 
 	{ .value = TARGET_EVENT_TRACE_CONFIG, .name = "trace-config" },
 
+	{ .value = TARGET_EVENT_JOB_DONE, .name = "job-done" },
+
 	{ .value = TARGET_EVENT_SEMIHOSTING_USER_CMD_0X100, .name = "semihosting-user-cmd-0x100" },
 	{ .value = TARGET_EVENT_SEMIHOSTING_USER_CMD_0X101, .name = "semihosting-user-cmd-0x101" },
 	{ .value = TARGET_EVENT_SEMIHOSTING_USER_CMD_0X102, .name = "semihosting-user-cmd-0x102" },
@@ -526,6 +551,7 @@ int target_halt(struct target *target)
 	if (retval != ERROR_OK)
 		return retval;
 
+	target_poll_soon(target);
 	target->halt_issued = true;
 	target->halt_issued_time = timeval_ms();
 
@@ -574,6 +600,16 @@ int target_resume(struct target *target, bool current, target_addr_t address,
 
 	target_call_event_callbacks(target, TARGET_EVENT_RESUME_START);
 
+	if (!debug_execution) {
+		if (target->smp) {
+			struct target_list *head;
+			foreach_smp_target(head, target->smp_targets)
+				target_end_working_area_session(head->target);
+		} else {
+			target_end_working_area_session(target);
+		}
+	}
+
 	/* note that resume *must* be asynchronous. The CPU can halt before
 	 * we poll. The CPU can even halt at the current PC as a result of
 	 * a software breakpoint being inserted by (a bug?) the application.
@@ -594,6 +630,7 @@ int target_resume(struct target *target, bool current, target_addr_t address,
 	if (retval != ERROR_OK)
 		return retval;
 
+	target_poll_soon(target);
 	target_call_event_callbacks(target, TARGET_EVENT_RESUME_END);
 
 	return retval;
@@ -614,6 +651,9 @@ static int target_process_reset(struct command_invocation *cmd, enum target_rese
 	for (target = all_targets; target; target = target->next)
 		target_call_reset_callbacks(target, reset_mode);
 
+	/* memory the jobs work on won't survive the reset */
+	target_cancel_all_jobs();
+
 	/* disable polling during reset to make reset event scripts
 	 * more predictable, i.e. dr/irscan & pathmove in events will
 	 * not have JTAG operations injected into the middle of a sequence.
@@ -637,6 +677,7 @@ static int target_process_reset(struct command_invocation *cmd, enum target_rese
 	for (target = all_targets; target; target = target->next) {
 		target->type->check_reset(target);
 		target->running_alg = false;
+		target_poll_soon(target);
 	}
 
 	return retval;
@@ -1267,7 +1308,10 @@ int target_read_memory(struct target *target,
 		LOG_TARGET_ERROR(target, "doesn't support read_memory");
 		return ERROR_FAIL;
 	}
-	return target->type->read_memory(target, address, size, count, buffer);
+	int retval = target->type->read_memory(target, address, size, count, buffer);
+	if (retval == ERROR_OK)
+		target_overlay_working_area_backup(target, address, size * count, buffer);
+	return retval;
 }
 
 int target_read_phys_memory(struct target *target,
@@ -1295,6 +1339,11 @@ int target_write_memory(struct target *target,
 		LOG_TARGET_ERROR(target, "doesn't support write_memory");
 		return ERROR_FAIL;
 	}
+	/* resident content overwritten by others must not be reused, and the
+	 * saved content must not overwrite the new data later */
+	target_release_resident_working_areas(target, address, (target_addr_t)size * count);
+	target_restore_free_working_areas(target, address, (target_addr_t)size * count);
+	flash_target_memory_written(target, address, size * count);
 	return target->type->write_memory(target, address, size, count, buffer);
 }
 
@@ -1309,6 +1358,10 @@ int target_write_phys_memory(struct target *target,
 		LOG_TARGET_ERROR(target, "doesn't support write_phys_memory");
 		return ERROR_FAIL;
 	}
+	/* no address translation available here, assume the worst */
+	target_release_all_resident_working_areas(target);
+	target_restore_free_working_areas(target, 0, (target_addr_t)-1);
+	flash_target_memory_written(target, address, size * count);
 	return target->type->write_phys_memory(target, address, size, count, buffer);
 }
 
@@ -1348,6 +1401,17 @@ int target_remove_breakpoint(struct target *target,
 	return target->type->remove_breakpoint(target, breakpoint);
 }
 
+int target_update_sw_breakpoints(struct target *target, bool set)
+{
+	if (!target->type->update_sw_breakpoints)
+		return ERROR_OK;
+	if (target->state != TARGET_HALTED) {
+		LOG_TARGET_ERROR(target, "not halted (update software breakpoints)");
+		return ERROR_TARGET_NOT_HALTED;
+	}
+	return target->type->update_sw_breakpoints(target, set);
+}
+
 int target_add_watchpoint(struct target *target,
 		struct watchpoint *watchpoint)
 {
@@ -1442,10 +1506,18 @@ int target_step(struct target *target,
 
 	target_call_event_callbacks(target, TARGET_EVENT_STEP_START);
 
+	target_end_working_area_session(target);
+
+	retval = target_update_sw_breakpoints(target, true);
+	if (retval != ERROR_OK)
+		return retval;
+
 	retval = target->type->step(target, current, address, handle_breakpoints);
 	if (retval != ERROR_OK)
 		return retval;
 
+	target_poll_soon(target);
+
 	target_call_event_callbacks(target, TARGET_EVENT_STEP_END);
 
 	return retval;
@@ -1684,31 +1756,113 @@ int target_register_trace_callback(int (*callback)(struct target *target,
 	return ERROR_OK;
 }
 
+static bool target_timer_before(const struct target_timer_callback *a,
+		const struct target_timer_callback *b)
+{
+	if (a->when != b->when)
+		return a->when < b->when;
+	return a->seq < b->seq;
+}
+
+static void target_timer_heap_set(unsigned int i, struct target_timer_callback *cb)
+{
+	target_timer_heap[i] = cb;
+	cb->heap_index = i;
+}
+
+static void target_timer_heap_sift_up(unsigned int i)
+{
+	struct target_timer_callback *cb = target_timer_heap[i];
+
+	while (i > 0) {
+		unsigned int parent = (i - 1) / 2;
+		if (!target_timer_before(cb, target_timer_heap[parent]))
+			break;
+		target_timer_heap_set(i, target_timer_heap[parent]);
+		i = parent;
+	}
+	target_timer_heap_set(i, cb);
+}
+
+static void target_timer_heap_sift_down(unsigned int i)
+{
+	struct target_timer_callback *cb = target_timer_heap[i];
+
+	for (;;) {
+		unsigned int child = 2 * i + 1;
+		if (child >= target_timer_heap_len)
+			break;
+		if (child + 1 < target_timer_heap_len &&
+				target_timer_before(target_timer_heap[child + 1], target_timer_heap[child]))
+			child++;
+		if (!target_timer_before(target_timer_heap[child], cb))
+			break;
+		target_timer_heap_set(i, target_timer_heap[child]);
+		i = child;
+	}
+	target_timer_heap_set(i, cb);
+}
+
+static int target_timer_heap_push(struct target_timer_callback *cb)
+{
+	if (target_timer_heap_len == target_timer_heap_size) {
+		unsigned int size = target_timer_heap_size ? 2 * target_timer_heap_size : 16;
+		struct target_timer_callback **heap = realloc(target_timer_heap, size * sizeof(*heap));
+		if (!heap) {
+			LOG_ERROR("Out of memory");
+			return ERROR_FAIL;
+		}
+		target_timer_heap = heap;
+		target_timer_heap_size = size;
+	}
+
+	target_timer_heap_set(target_timer_heap_len++, cb);
+	target_timer_heap_sift_up(cb->heap_index);
+
+	return ERROR_OK;
+}
+
+static void target_timer_heap_remove(struct target_timer_callback *cb)
+{
+	unsigned int i = cb->heap_index;
+	struct target_timer_callback *last = target_timer_heap[--target_timer_heap_len];
+
+	cb->heap_index = UINT_MAX;
+	if (last == cb)
+		return;
+
+	target_timer_heap_set(i, last);
+	target_timer_heap_sift_up(i);
+	target_timer_heap_sift_down(last->heap_index);
+}
+
 int target_register_timer_callback(int (*callback)(void *priv),
 		unsigned int time_ms, enum target_timer_type type, void *priv)
 {
-	struct target_timer_callback **callbacks_p = &target_timer_callbacks;
-
 	if (!callback)
 		return ERROR_COMMAND_SYNTAX_ERROR;
 
-	if (*callbacks_p) {
-		while ((*callbacks_p)->next)
-			callbacks_p = &((*callbacks_p)->next);
-		callbacks_p = &((*callbacks_p)->next);
+	struct target_timer_callback *cb = calloc(1, sizeof(*cb));
+	if (!cb) {
+		LOG_ERROR("Out of memory");
+		return ERROR_FAIL;
 	}
 
-	(*callbacks_p) = malloc(sizeof(struct target_timer_callback));
-	(*callbacks_p)->callback = callback;
-	(*callbacks_p)->type = type;
-	(*callbacks_p)->time_ms = time_ms;
-	(*callbacks_p)->removed = false;
+	cb->callback = callback;
+	cb->type = type;
+	cb->time_ms = time_ms;
+	cb->removed = false;
+	cb->when = timeval_ms() + time_ms;
+	cb->priv = priv;
+	cb->seq = target_timer_seq++;
 
-	(*callbacks_p)->when = timeval_ms() + time_ms;
-	target_timer_next_event_value = MIN(target_timer_next_event_value, (*callbacks_p)->when);
+	int retval = target_timer_heap_push(cb);
+	if (retval != ERROR_OK) {
+		free(cb);
+		return retval;
+	}
 
-	(*callbacks_p)->priv = priv;
-	(*callbacks_p)->next = NULL;
+	target_timer_next_event_value = MIN(target_timer_next_event_value, cb->when);
 
 	return ERROR_OK;
 }
@@ -1774,19 +1928,33 @@ int target_unregister_trace_callback(int (*callback)(struct target *target,
 	return ERROR_OK;
 }
 
+/* Callbacks being run are out of the heap; they are only flagged here
+ * and freed once they return */
+static struct target_timer_callback **target_timer_running;
+static unsigned int target_timer_running_len;
+
 int target_unregister_timer_callback(int (*callback)(void *priv), void *priv)
 {
 	if (!callback)
 		return ERROR_COMMAND_SYNTAX_ERROR;
 
-	for (struct target_timer_callback *c = target_timer_callbacks;
-	     c; c = c->next) {
-		if ((c->callback == callback) && (c->priv == priv)) {
+	for (unsigned int i = 0; i < target_timer_running_len; i++) {
+		struct target_timer_callback *c = target_timer_running[i];
+		if (!c->removed && c->callback == callback && c->priv == priv) {
 			c->removed = true;
 			return ERROR_OK;
 		}
 	}
 
+	for (unsigned int i = 0; i < target_timer_heap_len; i++) {
+		struct target_timer_callback *c = target_timer_heap[i];
+		if (c->callback == callback && c->priv == priv) {
+			target_timer_heap_remove(c);
+			free(c);
+			return ERROR_OK;
+		}
+	}
+
 	return ERROR_FAIL;
 }
 
@@ -1838,22 +2006,28 @@ int target_call_trace_callbacks(struct target *target, size_t len, uint8_t *data
 	return ERROR_OK;
 }
 
-static int target_timer_callback_periodic_restart(
-		struct target_timer_callback *cb, int64_t *now)
+static void target_call_timer_callback(struct target_timer_callback *cb,
+		int64_t now)
 {
-	cb->when = *now + cb->time_ms;
-	return ERROR_OK;
-}
+	struct target_timer_stats *stats = &cb->stats;
+	struct duration run_time;
+	int64_t latency = now - cb->when;
 
-static int target_call_timer_callback(struct target_timer_callback *cb,
-		int64_t *now)
-{
-	cb->callback(cb->priv);
+	if (latency < 0)
+		latency = 0;	/* forced early */
 
-	if (cb->type == TARGET_TIMER_TYPE_PERIODIC)
-		return target_timer_callback_periodic_restart(cb, now);
+	duration_start(&run_time);
+	cb->callback(cb->priv);
+	duration_measure(&run_time);
 
-	return target_unregister_timer_callback(cb->callback, cb->priv);
+	int64_t us = duration_elapsed(&run_time) * 1000000;
+	if (!stats->calls || latency < stats->latency_min)
+		stats->latency_min = latency;
+	stats->latency_max = MAX(stats->latency_max, latency);
+	stats->latency_sum += latency;
+	stats->run_time_max = MAX(stats->run_time_max, us);
+	stats->run_time_sum += us;
+	stats->calls++;
 }
 
 static int target_call_timer_callbacks_check_time(int checktime)
@@ -1870,35 +2044,71 @@ static int target_call_timer_callbacks_check_time(int checktime)
 
 	int64_t now = timeval_ms();
 
-	/* Initialize to a default value that's a ways into the future.
-	 * The loop below will make it closer to now if there are
-	 * callbacks that want to be called sooner. */
-	target_timer_next_event_value = now + 1000;
+	/* Take every callback that is due out of the heap first, so each
+	 * one runs at most once per call even with a zero period, and
+	 * callbacks may (un)register timers while they run. */
+	struct target_timer_callback **due = NULL;
+	unsigned int num_due = 0;
+
+	if (target_timer_heap_len) {
+		due = malloc(target_timer_heap_len * sizeof(*due));
+		if (!due) {
+			LOG_ERROR("Out of memory");
+			callback_processing = false;
+			return ERROR_FAIL;
+		}
+	}
 
-	/* Store an address of the place containing a pointer to the
-	 * next item; initially, that's a standalone "root of the
-	 * list" variable. */
-	struct target_timer_callback **callback = &target_timer_callbacks;
-	while (callback && *callback) {
-		if ((*callback)->removed) {
-			struct target_timer_callback *p = *callback;
-			*callback = (*callback)->next;
-			free(p);
-			continue;
+	if (checktime) {
+		while (target_timer_heap_len && target_timer_heap[0]->when <= now) {
+			due[num_due] = target_timer_heap[0];
+			target_timer_heap_remove(due[num_due++]);
+		}
+	} else {
+		/* all periodic ones and the due ones, in registration order */
+		for (unsigned int i = 0; i < target_timer_heap_len; i++) {
+			if (target_timer_heap[i]->type == TARGET_TIMER_TYPE_PERIODIC ||
+					target_timer_heap[i]->when <= now)
+				due[num_due++] = target_timer_heap[i];
 		}
+		for (unsigned int i = 0; i < num_due; i++)
+			target_timer_heap_remove(due[i]);
+		for (unsigned int i = 1; i < num_due; i++) {
+			struct target_timer_callback *cb = due[i];
+			unsigned int j = i;
+			for (; j > 0 && due[j - 1]->seq > cb->seq; j--)
+				due[j] = due[j - 1];
+			due[j] = cb;
+		}
+	}
 
-		bool call_it = (*callback)->callback &&
-			((!checktime && (*callback)->type == TARGET_TIMER_TYPE_PERIODIC) ||
-			 now >= (*callback)->when);
+	target_timer_running = due;
+	target_timer_running_len = num_due;
+	target_timer_forced = !checktime;
 
-		if (call_it)
-			target_call_timer_callback(*callback, &now);
+	for (unsigned int i = 0; i < num_due; i++) {
+		if (!due[i]->removed)
+			target_call_timer_callback(due[i], now);
+	}
 
-		if (!(*callback)->removed && (*callback)->when < target_timer_next_event_value)
-			target_timer_next_event_value = (*callback)->when;
+	target_timer_forced = false;
+	target_timer_running = NULL;
+	target_timer_running_len = 0;
 
-		callback = &(*callback)->next;
+	for (unsigned int i = 0; i < num_due; i++) {
+		struct target_timer_callback *cb = due[i];
+		cb->when = now + cb->time_ms;
+		if (cb->removed || cb->type != TARGET_TIMER_TYPE_PERIODIC ||
+				target_timer_heap_push(cb) != ERROR_OK)
+			free(cb);
 	}
+	free(due);
+
+	/* Default to a value that's a ways into the future */
+	target_timer_next_event_value = now + 1000;
+	if (target_timer_heap_len)
+		target_timer_next_event_value = MIN(target_timer_next_event_value,
+				target_timer_heap[0]->when);
 
 	callback_processing = false;
 	return ERROR_OK;
@@ -1927,12 +2137,18 @@ static void print_wa_layout(struct target *target)
 
 	while (c) {
 		LOG_DEBUG("%c%c " TARGET_ADDR_FMT "-" TARGET_ADDR_FMT " (%" PRIu32 " bytes)",
-			c->backup ? 'b' : ' ', c->free ? ' ' : '*',
+			c->resident ? 'r' : ' ', c->free ? ' ' : (c->user ? '*' : '-'),
 			c->address, c->address + c->size - 1, c->size);
 		c = c->next;
 	}
 }
 
+/* A resident area no longer used by anybody, its content may be reused */
+static inline bool target_working_area_is_idle(const struct working_area *area)
+{
+	return area->resident && !area->free && !area->user;
+}
+
 /* Reduce area to size bytes, create a new free area from the remaining bytes, if any. */
 static void target_split_working_area(struct working_area *area, uint32_t size)
 {
@@ -1949,17 +2165,12 @@ static void target_split_working_area(struct working_area *area, uint32_t size)
 		new_wa->next = area->next;
 		new_wa->size = area->size - size;
 		new_wa->address = area->address + size;
-		new_wa->backup = NULL;
+		new_wa->resident = false;
 		new_wa->user = NULL;
 		new_wa->free = true;
 
 		area->next = new_wa;
 		area->size = size;
-
-		/* If backup memory was allocated to this area, it has the wrong size
-		 * now so free it and it will be reallocated if/when needed */
-		free(area->backup);
-		area->backup = NULL;
 	}
 }
 
@@ -1979,19 +2190,221 @@ static void target_merge_working_areas(struct target *target)
 			/* Remove the last */
 			struct working_area *to_be_freed = c->next;
 			c->next = c->next->next;
-			free(to_be_freed->backup);
 			free(to_be_freed);
-
-			/* If backup memory was allocated to the remaining area, it's has
-			 * the wrong size now */
-			free(c->backup);
-			c->backup = NULL;
 		} else {
 			c = c->next;
 		}
 	}
 }
 
+/* Return idle resident areas overlapping [address, address + size) to the
+ * allocation pool. Returns true if any area was released. */
+static bool target_release_resident_working_areas(struct target *target,
+		target_addr_t address, target_addr_t size)
+{
+	bool released = false;
+
+	for (struct working_area *c = target->working_areas; c; c = c->next) {
+		if (!target_working_area_is_idle(c))
+			continue;
+		if (c->address >= address + size || address >= c->address + c->size)
+			continue;
+
+		LOG_DEBUG("released resident working area at address " TARGET_ADDR_FMT, c->address);
+		c->resident = false;
+		c->free = true;
+		released = true;
+	}
+
+	if (released)
+		target_merge_working_areas(target);
+
+	return released;
+}
+
+static void target_release_all_resident_working_areas(struct target *target)
+{
+	target_release_resident_working_areas(target, 0, (target_addr_t)-1);
+}
+
+/* Save [address, address + size) of the working area, unless it has already
+ * been saved earlier in this session. Only words not saved yet are read. */
+static int target_backup_working_area(struct target *target, target_addr_t address, uint32_t size)
+{
+	uint32_t words = ALIGN_DOWN(target->working_area_size, 4) / 4;
+
+	if (!target->working_area_backup) {
+		target->working_area_backup = malloc(words * 4);
+		target->working_area_backed_up = calloc(BITS_TO_LONGS(words), sizeof(unsigned long));
+		if (!target->working_area_backup || !target->working_area_backed_up) {
+			free(target->working_area_backup);
+			free(target->working_area_backed_up);
+			target->working_area_backup = NULL;
+			target->working_area_backed_up = NULL;
+			return ERROR_FAIL;
+		}
+	}
+
+	uint32_t first = (address - target->working_area) / 4;
+	uint32_t last = first + size / 4;
+	assert(last <= words);
+
+	for (uint32_t i = first; i < last; ) {
+		if (test_bit(i, target->working_area_backed_up)) {
+			i++;
+			continue;
+		}
+
+		uint32_t j = i;
+		while (j < last && !test_bit(j, target->working_area_backed_up))
+			j++;
+
+		int retval = target_read_memory(target, target->working_area + 4 * i, 4, j - i,
+				target->working_area_backup + 4 * i);
+		if (retval != ERROR_OK)
+			return retval;
+
+		for (; i < j; i++)
+			set_bit(i, target->working_area_backed_up);
+	}
+
+	return ERROR_OK;
+}
+
+/* Write back the content saved for [address, address + size), if any */
+static int target_restore_working_area(struct target *target, target_addr_t address, uint32_t size)
+{
+	int retval = ERROR_OK;
+
+	if (!target->working_area_backed_up)
+		return ERROR_OK;
+
+	uint32_t first = (address - target->working_area) / 4;
+	uint32_t last = first + size / 4;
+
+	for (uint32_t i = first; i < last; ) {
+		if (!test_bit(i, target->working_area_backed_up)) {
+			i++;
+			continue;
+		}
+
+		uint32_t j = i;
+		while (j < last && test_bit(j, target->working_area_backed_up))
+			j++;
+
+		/* cleared first, so target_write_memory() doesn't restore them again */
+		for (uint32_t k = i; k < j; k++)
+			clear_bit(k, target->working_area_backed_up);
+
+		int ret = target_write_memory(target, target->working_area + 4 * i, 4, j - i,
+				target->working_area_backup + 4 * i);
+		if (ret != ERROR_OK) {
+			LOG_ERROR("failed to restore %" PRIu32 " bytes of working area at address " TARGET_ADDR_FMT,
+					4 * (j - i), target->working_area + 4 * i);
+			retval = ret;
+		}
+		i = j;
+	}
+
+	return retval;
+}
+
+/* Write back the saved content of free areas overlapping
+ * [address, address + size), in whole words */
+static int target_restore_free_working_areas(struct target *target,
+		target_addr_t address, target_addr_t size)
+{
+	int retval = ERROR_OK;
+
+	if (!target->working_area_backed_up)
+		return ERROR_OK;
+
+	for (struct working_area *c = target->working_areas; c; c = c->next) {
+		if (!c->free)
+			continue;
+		if (c->address >= address + size || address >= c->address + c->size)
+			continue;
+
+		target_addr_t start = ALIGN_DOWN(MAX(address, c->address), 4);
+		target_addr_t end = ALIGN_UP(MIN(address + size, c->address + c->size), 4);
+		int ret = target_restore_working_area(target, start, end - start);
+		if (ret != ERROR_OK)
+			retval = ret;
+	}
+
+	return retval;
+}
+
+/* Free and idle resident areas hold scratch data or an algorithm, show the
+ * saved content for them instead, as it will be there once restored. */
+static void target_overlay_working_area_backup(struct target *target,
+		target_addr_t address, uint32_t size, uint8_t *buffer)
+{
+	if (!target->working_area_backed_up)
+		return;
+
+	for (struct working_area *c = target->working_areas; c; c = c->next) {
+		if (!c->free && !target_working_area_is_idle(c))
+			continue;
+
+		target_addr_t start = MAX(address, c->address);
+		target_addr_t end = MIN(address + size, c->address + c->size);
+		for (target_addr_t a = start; a < end; a++) {
+			uint32_t offset = a - target->working_area;
+			if (test_bit(offset / 4, target->working_area_backed_up))
+				buffer[a - address] = target->working_area_backup[offset];
+		}
+	}
+}
+
+static void target_drop_working_area_backup(struct target *target)
+{
+	free(target->working_area_backup);
+	free(target->working_area_backed_up);
+	target->working_area_backup = NULL;
+	target->working_area_backed_up = NULL;
+}
+
+/* End of the working area session, the target is going to run code not under
+ * our control. Resident content is forgotten and the saved memory content is
+ * written back to all areas not in use anymore. */
+static int target_end_working_area_session(struct target *target)
+{
+	target_release_all_resident_working_areas(target);
+
+	return target_restore_free_working_areas(target, 0, (target_addr_t)-1);
+}
+
+/* Best fit: the smallest free area large enough, the lowest address on ties.
+ * This leaves large blocks for buffers when code, stack and buffers are
+ * allocated together. */
+static struct working_area *target_find_free_working_area(struct target *target, uint32_t size)
+{
+	struct working_area *best = NULL;
+
+	for (struct working_area *c = target->working_areas; c; c = c->next) {
+		if (!c->free || c->size < size)
+			continue;
+		if (!best || c->size < best->size)
+			best = c;
+		if (best->size == size)
+			break;
+	}
+
+	return best;
+}
+
+static uint32_t target_working_area_in_use(struct target *target)
+{
+	uint32_t in_use = 0;
+
+	for (struct working_area *c = target->working_areas; c; c = c->next)
+		if (!c->free)
+			in_use += c->size;
+
+	return in_use;
+}
+
 int target_alloc_working_area_try(struct target *target, uint32_t size, struct working_area **area)
 {
 	/* Reevaluate working area address based on MMU state*/
@@ -2033,7 +2446,7 @@ int target_alloc_working_area_try(struct target *target, uint32_t size, struct w
 			new_wa->next = NULL;
 			new_wa->size = ALIGN_DOWN(target->working_area_size, 4); /* 4-byte align */
 			new_wa->address = target->working_area;
-			new_wa->backup = NULL;
+			new_wa->resident = false;
 			new_wa->user = NULL;
 			new_wa->free = true;
 		}
@@ -2044,17 +2457,18 @@ int target_alloc_working_area_try(struct target *target, uint32_t size, struct w
 	/* only allocate multiples of 4 byte */
 	size = ALIGN_UP(size, 4);
 
-	struct working_area *c = target->working_areas;
+	struct working_area *c = target_find_free_working_area(target, size);
 
-	/* Find the first large enough working area */
-	while (c) {
-		if (c->free && c->size >= size)
-			break;
-		c = c->next;
+	/* Make room by dropping resident content nobody uses at the moment */
+	if (!c) {
+		target_release_all_resident_working_areas(target);
+		c = target_find_free_working_area(target, size);
 	}
 
-	if (!c)
+	if (!c) {
+		target->working_area_stats.failures++;
 		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+	}
 
 	/* Split the working area into the requested size */
 	target_split_working_area(c, size);
@@ -2063,13 +2477,7 @@ int target_alloc_working_area_try(struct target *target, uint32_t size, struct w
 			  size, c->address);
 
 	if (target->backup_working_area) {
-		if (!c->backup) {
-			c->backup = malloc(c->size);
-			if (!c->backup)
-				return ERROR_FAIL;
-		}
-
-		int retval = target_read_memory(target, c->address, 4, c->size / 4, c->backup);
+		int retval = target_backup_working_area(target, c->address, c->size);
 		if (retval != ERROR_OK)
 			return retval;
 	}
@@ -2081,6 +2489,10 @@ int target_alloc_working_area_try(struct target *target, uint32_t size, struct w
 	/* user pointer */
 	c->user = area;
 
+	target->working_area_stats.allocs++;
+	target->working_area_stats.peak = MAX(target->working_area_stats.peak,
+			target_working_area_in_use(target));
+
 	print_wa_layout(target);
 
 	return ERROR_OK;
@@ -2097,56 +2509,83 @@ int target_alloc_working_area(struct target *target, uint32_t size, struct worki
 
 }
 
-static int target_restore_working_area(struct target *target, struct working_area *area)
+int target_alloc_working_area_max(struct target *target,
+		uint32_t min_size, uint32_t max_size, struct working_area **area)
 {
-	int retval = ERROR_OK;
+	uint32_t size = MIN(ALIGN_DOWN(max_size, 4), target_get_working_area_avail(target));
 
-	if (target->backup_working_area && area->backup) {
-		retval = target_write_memory(target, area->address, 4, area->size / 4, area->backup);
-		if (retval != ERROR_OK)
-			LOG_ERROR("failed to restore %" PRIu32 " bytes of working area at address " TARGET_ADDR_FMT,
-					area->size, area->address);
+	if (size < min_size || size == 0) {
+		target->working_area_stats.failures++;
+		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
 	}
 
-	return retval;
+	return target_alloc_working_area_try(target, size, area);
 }
 
-/* Restore the area's backup memory, if any, and return the area to the allocation pool */
-static int target_free_working_area_restore(struct target *target, struct working_area *area, int restore)
+int target_alloc_working_area_resident(struct target *target,
+		const uint8_t *content, uint32_t size, struct working_area **area)
 {
-	if (!area || area->free)
-		return ERROR_OK;
+	uint32_t crc = crc32_le(CRC32_POLY_LE, 0xffffffff, content, size);
 
-	int retval = ERROR_OK;
-	if (restore) {
-		retval = target_restore_working_area(target, area);
-		/* REVISIT: Perhaps the area should be freed even if restoring fails. */
-		if (retval != ERROR_OK)
-			return retval;
+	for (struct working_area *c = target->working_areas; c; c = c->next) {
+		if (target_working_area_is_idle(c) && c->size == ALIGN_UP(size, 4) &&
+				c->resident_crc == crc) {
+			LOG_DEBUG("reusing resident working area of %" PRIu32 " bytes at address " TARGET_ADDR_FMT,
+					c->size, c->address);
+			*area = c;
+			c->user = area;
+			target->working_area_stats.resident_hits++;
+			return ERROR_OK;
+		}
+	}
+
+	int retval = target_alloc_working_area(target, size, area);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = target_write_buffer(target, (*area)->address, size, content);
+	if (retval != ERROR_OK) {
+		target_free_working_area(target, *area);
+		return retval;
 	}
 
-	area->free = true;
+	(*area)->resident = true;
+	(*area)->resident_crc = crc;
+
+	return ERROR_OK;
+}
+
+/* Return the area to the allocation pool. Resident areas keep their content
+ * and stay allocated until released. */
+int target_free_working_area(struct target *target, struct working_area *area)
+{
+	if (!area || area->free)
+		return ERROR_OK;
 
-	LOG_DEBUG("freed %" PRIu32 " bytes of working area at address " TARGET_ADDR_FMT,
-			area->size, area->address);
+	if (area->resident) {
+		LOG_DEBUG("keeping %" PRIu32 " bytes of resident working area at address " TARGET_ADDR_FMT,
+				area->size, area->address);
+	} else {
+		/* the saved content is kept for the next allocation and written
+		 * back once the session ends or the memory is written */
+		area->free = true;
+		LOG_DEBUG("freed %" PRIu32 " bytes of working area at address " TARGET_ADDR_FMT,
+				area->size, area->address);
+	}
 
 	/* mark user pointer invalid */
 	/* TODO: Is this really safe? It points to some previous caller's memory.
 	 * How could we know that the area pointer is still in that place and not
 	 * some other vital data? What's the purpose of this, anyway? */
-	*area->user = NULL;
+	if (area->user)
+		*area->user = NULL;
 	area->user = NULL;
 
 	target_merge_working_areas(target);
 
 	print_wa_layout(target);
 
-	return retval;
-}
-
-int target_free_working_area(struct target *target, struct working_area *area)
-{
-	return target_free_working_area_restore(target, area, 1);
+	return ERROR_OK;
 }
 
 /* free resources and restore memory, if restoring memory fails,
@@ -2158,21 +2597,26 @@ static void target_free_all_working_areas_restore(struct target *target, int res
 
 	LOG_DEBUG("freeing all working areas");
 
-	/* Loop through all areas, restoring the allocated ones and marking them as free */
+	/* Loop through all areas marking them as free */
 	while (c) {
 		if (!c->free) {
-			if (restore)
-				target_restore_working_area(target, c);
 			c->free = true;
-			*c->user = NULL; /* Same as above */
+			if (c->user)
+				*c->user = NULL; /* Same as above */
 			c->user = NULL;
 		}
+		c->resident = false;
 		c = c->next;
 	}
 
 	/* Run a merge pass to combine all areas into one */
 	target_merge_working_areas(target);
 
+	if (restore && target->working_areas)
+		target_restore_working_area(target, target->working_areas->address,
+				target->working_areas->size);
+	target_drop_working_area_backup(target);
+
 	print_wa_layout(target);
 }
 
@@ -2183,7 +2627,6 @@ void target_free_all_working_areas(struct target *target)
 	/* Now we have none or only one working area marked as free */
 	if (target->working_areas) {
 		/* Free the last one to allow on-the-fly moving and resizing */
-		free(target->working_areas->backup);
 		free(target->working_areas);
 		target->working_areas = NULL;
 	}
@@ -2194,13 +2637,20 @@ uint32_t target_get_working_area_avail(struct target *target)
 {
 	struct working_area *c = target->working_areas;
 	uint32_t max_size = 0;
+	uint32_t size = 0;
 
 	if (!c)
 		return ALIGN_DOWN(target->working_area_size, 4);
 
+	/* idle resident areas are released on demand */
 	while (c) {
-		if (c->free && max_size < c->size)
-			max_size = c->size;
+		if (c->free || target_working_area_is_idle(c))
+			size += c->size;
+		else
+			size = 0;
+
+		if (max_size < size)
+			max_size = size;
 
 		c = c->next;
 	}
@@ -2265,13 +2715,14 @@ void target_quit(void)
 	}
 	target_event_callbacks = NULL;
 
-	struct target_timer_callback *pt = target_timer_callbacks;
-	while (pt) {
-		struct target_timer_callback *t = pt->next;
-		free(pt);
-		pt = t;
-	}
-	target_timer_callbacks = NULL;
+	target_free_all_jobs();
+
+	for (unsigned int i = 0; i < target_timer_heap_len; i++)
+		free(target_timer_heap[i]);
+	free(target_timer_heap);
+	target_timer_heap = NULL;
+	target_timer_heap_len = 0;
+	target_timer_heap_size = 0;
 
 	for (struct target *target = all_targets; target;) {
 		struct target *tmp;
@@ -2508,16 +2959,27 @@ int target_checksum_memory(struct target *target, target_addr_t address, uint32_
 		LOG_TARGET_INFO(target, "doesn't support fast checksum_memory, using slow read memory");
 	}
 
-	uint8_t *buffer = malloc(size);
+	/* read back in bounded pieces, large flash banks needn't fit in host memory */
+	uint32_t chunk = MIN(size, TARGET_CHECKSUM_READ_CHUNK);
+	uint8_t *buffer = malloc(chunk);
 	if (!buffer) {
-		LOG_ERROR("error allocating buffer for section (%" PRIu32 " bytes)", size);
+		LOG_ERROR("error allocating buffer for section (%" PRIu32 " bytes)", chunk);
 		return ERROR_FAIL;
 	}
 
-	retval = target_read_buffer(target, address, size, buffer);
+	uint32_t checksum = 0xffffffff;
+	retval = ERROR_OK;
+	while (size > 0 && retval == ERROR_OK) {
+		uint32_t n = MIN(size, chunk);
+		retval = target_read_buffer(target, address, n, buffer);
+		if (retval == ERROR_OK)
+			retval = image_update_checksum(buffer, n, &checksum);
+		address += n;
+		size -= n;
+	}
 
 	if (retval == ERROR_OK)
-		retval = image_calculate_checksum(buffer, size, crc);
+		*crc = checksum;
 
 	free(buffer);
 	return retval;
@@ -2809,6 +3271,9 @@ COMMAND_HANDLER(handle_targets_command)
 	return retval;
 }
 
+/* timeval_ms() when the polling statistics were last reset */
+static int64_t polling_stats_start;
+
 /* every 300ms we check for reset & powerdropout and issue a "reset halt" if so. */
 
 static int power_dropout;
@@ -2871,15 +3336,126 @@ static int sense_handler(void)
 	return ERROR_OK;
 }
 
-/* process target state changes */
-static int handle_target(void *priv)
+/* Poll the target on the next tick at the base rate */
+static void target_poll_reset_interval(struct target *target)
 {
-	Jim_Interp *interp = (Jim_Interp *)priv;
-	int retval = ERROR_OK;
+	target->polling.interval = polling_interval;
+	target->polling.next = 0;
+}
 
-	if (!is_jtag_poll_safe()) {
-		/* polling is disabled currently */
-		return ERROR_OK;
+/* Poll the target at the base rate again. Halting or resuming one SMP core
+ * acts on the whole group, so its siblings are included. */
+static void target_poll_soon(struct target *target)
+{
+	if (target->smp) {
+		struct target_list *head;
+		foreach_smp_target(head, target->smp_targets)
+			target_poll_reset_interval(head->target);
+	} else {
+		target_poll_reset_interval(target);
+	}
+}
+
+/* Running targets, or ones that just changed state, are polled at the
+ * base rate. Halted and unexamined targets with nothing going on are
+ * polled less and less often, down to TARGET_IDLE_POLLING_INTERVAL.
+ */
+static void target_update_polling(struct target *target, enum target_state prev_state)
+{
+	struct target_polling *polling = &target->polling;
+
+	polling->polls++;
+	if (polling->interval < (unsigned int)polling_interval)
+		polling->interval = polling_interval;
+
+	bool idle = target->state == prev_state &&
+		(target->state == TARGET_HALTED || !target_was_examined(target));
+	if (idle)
+		polling->interval = MIN(2 * polling->interval, TARGET_IDLE_POLLING_INTERVAL);
+	else
+		polling->interval = polling_interval;
+
+	/* half a tick early, so the next tick past the interval polls it */
+	polling->next = timeval_ms() + polling->interval - polling_interval / 2;
+}
+
+/* Whether handle_target() polls the target on this pass */
+static bool target_poll_due(struct target *target)
+{
+	if (!target_active_polled(target) || !target->tap->enabled)
+		return false;
+
+	if (target->backoff.times > target->backoff.count)
+		return false;
+
+	if (!target_timer_forced && timeval_ms() < target->polling.next)
+		return false;
+
+	return !power_dropout && !srst_asserted;
+}
+
+/* target being polled by handle_target(), see target_poll_take_prefetch() */
+static struct target *target_polling_current;
+
+/**
+ * Returns true if the status read by poll_prefetch() for @a target may be
+ * used by the poll in progress, and consumes it either way.
+ *
+ * Only the top-level poll of handle_target() gets them. Polls nested in the
+ * poll of another target, e.g. of SMP siblings halted by it, must read the
+ * status again since it may have changed after the prefetch.
+ */
+bool target_poll_take_prefetch(struct target *target)
+{
+	bool prefetched = target->polling.prefetched;
+
+	target->polling.prefetched = false;
+	return prefetched && target == target_polling_current;
+}
+
+/* Queue the status reads of all due targets before running any queue, so
+ * targets sharing a debug port get them all in one go */
+static void target_poll_prefetch_all(void)
+{
+	struct target *target;
+	bool failed = false;
+
+	for (target = all_targets; target; target = target->next) {
+		target->polling.prefetched = false;
+
+		if (!target->type->poll_prefetch || !target_was_examined(target) ||
+				!target_poll_due(target))
+			continue;
+
+		if (target->type->poll_prefetch(target) != ERROR_OK)
+			failed = true;
+		target->polling.prefetched = true;
+	}
+
+	/* run every queue now, even after a failure, so that no read is left
+	 * queued for a poll which might not happen */
+	for (target = all_targets; target; target = target->next) {
+		if (target->polling.prefetched &&
+				target->type->poll_prefetch_run(target) != ERROR_OK)
+			failed = true;
+	}
+
+	/* the polls read the status again themselves */
+	if (failed) {
+		for (target = all_targets; target; target = target->next)
+			target->polling.prefetched = false;
+	}
+}
+
+/* process target state changes */
+static int handle_target(void *priv)
+{
+	Jim_Interp *interp = (Jim_Interp *)priv;
+	int retval = ERROR_OK;
+
+	if (!is_jtag_poll_safe()) {
+		/* polling is disabled currently */
+		return ERROR_OK;
 	}
 
 	/* we do not want to recurse here... */
@@ -2926,6 +3502,14 @@ static int handle_target(void *priv)
 		recursive = 0;
 	}
 
+	if (!is_jtag_poll_safe())
+		return retval;
+
+	if (!polling_stats_start)
+		polling_stats_start = timeval_ms();
+
+	target_poll_prefetch_all();
+
 	/* Poll targets for state changes unless that's globally disabled.
 	 * Skip targets that are currently disabled.
 	 */
@@ -2946,10 +3530,27 @@ static int handle_target(void *priv)
 		}
 		target->backoff.count = 0;
 
+		if (!target_timer_forced && timeval_ms() < target->polling.next)
+			continue;
+
 		/* only poll target if we've got power and srst isn't asserted */
 		if (!power_dropout && !srst_asserted) {
+			enum target_state state = target->state;
+
+			struct duration poll_time;
+			duration_start(&poll_time);
+
 			/* polling may fail silently until the target has been examined */
+			target_polling_current = target;
 			retval = target_poll(target);
+			target_polling_current = NULL;
+			target_update_polling(target, state);
+
+			if (duration_measure(&poll_time) == ERROR_OK) {
+				int64_t us = duration_elapsed(&poll_time) * 1000000;
+				target->polling.time_sum += us;
+				target->polling.time_max = MAX(target->polling.time_max, us);
+			}
 			if (retval != ERROR_OK) {
 				/* 100ms polling interval. Increase interval between polling up to 5000ms */
 				if (target->backoff.times * polling_interval < 5000) {
@@ -2969,7 +3570,7 @@ static int handle_target(void *priv)
 				if (retval != ERROR_OK) {
 					LOG_TARGET_ERROR(target, "Examination failed, GDB will be halted. Polling again in %dms",
 						 target->backoff.times * polling_interval);
-					return retval;
+					break;
 				}
 			}
 
@@ -2978,6 +3579,10 @@ static int handle_target(void *priv)
 		}
 	}
 
+	/* don't let a later poll use status reads from this pass */
+	for (struct target *target = all_targets; target; target = target->next)
+		target->polling.prefetched = false;
+
 	return retval;
 }
 
@@ -3477,178 +4082,646 @@ static int target_fill_mem(struct target *target,
 		/* avoid GDB timeouts */
 		keep_alive();
 
-		if (openocd_is_shutdown_pending()) {
-			retval = ERROR_SERVER_INTERRUPTED;
-			break;
-		}
+		if (openocd_is_shutdown_pending()) {
+			retval = ERROR_SERVER_INTERRUPTED;
+			break;
+		}
+	}
+	free(target_buf);
+
+	return retval;
+}
+
+
+COMMAND_HANDLER(handle_mw_command)
+{
+	if (CMD_ARGC < 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	bool physical = strcmp(CMD_ARGV[0], "phys") == 0;
+	target_write_fn fn;
+	if (physical) {
+		CMD_ARGC--;
+		CMD_ARGV++;
+		fn = target_write_phys_memory;
+	} else
+		fn = target_write_memory;
+	if ((CMD_ARGC < 2) || (CMD_ARGC > 3))
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	target_addr_t address;
+	COMMAND_PARSE_ADDRESS(CMD_ARGV[0], address);
+
+	uint64_t value;
+	COMMAND_PARSE_NUMBER(u64, CMD_ARGV[1], value);
+
+	unsigned int count = 1;
+	if (CMD_ARGC == 3)
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[2], count);
+
+	struct target *target = get_current_target(CMD_CTX);
+	unsigned int wordsize;
+	switch (CMD_NAME[2]) {
+	case 'd':
+		wordsize = 8;
+		break;
+	case 'w':
+		wordsize = 4;
+		break;
+	case 'h':
+		wordsize = 2;
+		break;
+	case 'b':
+		wordsize = 1;
+		break;
+	default:
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	return target_fill_mem(target, address, fn, wordsize, value, count);
+}
+
+static COMMAND_HELPER(parse_load_image_command, struct image *image,
+		target_addr_t *min_address, target_addr_t *max_address)
+{
+	if (CMD_ARGC < 1 || CMD_ARGC > 5)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	/* a base address isn't always necessary,
+	 * default to 0x0 (i.e. don't relocate) */
+	if (CMD_ARGC >= 2) {
+		target_addr_t addr;
+		COMMAND_PARSE_ADDRESS(CMD_ARGV[1], addr);
+		image->base_address = addr;
+		image->base_address_set = true;
+	} else
+		image->base_address_set = false;
+
+	image->start_address_set = false;
+
+	if (CMD_ARGC >= 4)
+		COMMAND_PARSE_ADDRESS(CMD_ARGV[3], *min_address);
+	if (CMD_ARGC == 5) {
+		COMMAND_PARSE_ADDRESS(CMD_ARGV[4], *max_address);
+		/* use size (given) to find max (required) */
+		*max_address += *min_address;
+	}
+
+	if (*min_address > *max_address)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(start_load_image_job);
+
+COMMAND_HANDLER(handle_load_image_command)
+{
+	uint8_t *buffer;
+	size_t buf_cnt;
+	uint32_t image_size;
+	target_addr_t min_address = 0;
+	target_addr_t max_address = -1;
+	struct image image;
+
+	if (CMD_ARGC > 0 && !strcmp(CMD_ARGV[0], "-bg")) {
+		CMD_ARGC--;
+		CMD_ARGV++;
+		return CALL_COMMAND_HANDLER(start_load_image_job);
+	}
+
+	int retval = CALL_COMMAND_HANDLER(parse_load_image_command,
+			&image, &min_address, &max_address);
+	if (retval != ERROR_OK)
+		return retval;
+
+	struct target *target = get_current_target(CMD_CTX);
+
+	struct duration bench;
+	duration_start(&bench);
+
+	if (image_open(&image, CMD_ARGV[0], (CMD_ARGC >= 3) ? CMD_ARGV[2] : NULL) != ERROR_OK)
+		return ERROR_FAIL;
+
+	image_size = 0x0;
+	retval = ERROR_OK;
+	for (unsigned int i = 0; i < image.num_sections; i++) {
+		buffer = malloc(image.sections[i].size);
+		if (!buffer) {
+			command_print(CMD,
+						  "error allocating buffer for section (%d bytes)",
+						  (int)(image.sections[i].size));
+			retval = ERROR_FAIL;
+			break;
+		}
+
+		retval = image_read_section(&image, i, 0x0, image.sections[i].size, buffer, &buf_cnt);
+		if (retval != ERROR_OK) {
+			free(buffer);
+			break;
+		}
+
+		uint32_t offset = 0;
+		uint32_t length = buf_cnt;
+
+		/* DANGER!!! beware of unsigned comparison here!!! */
+
+		if ((image.sections[i].base_address + buf_cnt >= min_address) &&
+				(image.sections[i].base_address < max_address)) {
+
+			if (image.sections[i].base_address < min_address) {
+				/* clip addresses below */
+				offset += min_address-image.sections[i].base_address;
+				length -= offset;
+			}
+
+			if (image.sections[i].base_address + buf_cnt > max_address)
+				length -= (image.sections[i].base_address + buf_cnt)-max_address;
+
+			retval = target_write_buffer(target,
+					image.sections[i].base_address + offset, length, buffer + offset);
+			if (retval != ERROR_OK) {
+				free(buffer);
+				break;
+			}
+			image_size += length;
+			command_print(CMD, "%u bytes written at address " TARGET_ADDR_FMT "",
+					(unsigned int)length,
+					image.sections[i].base_address + offset);
+		}
+
+		free(buffer);
+	}
+
+	if ((retval == ERROR_OK) && (duration_measure(&bench) == ERROR_OK)) {
+		command_print(CMD, "downloaded %" PRIu32 " bytes "
+				"in %fs (%0.3f KiB/s)", image_size,
+				duration_elapsed(&bench), duration_kbps(&bench, image_size));
+	}
+
+	image_close(&image);
+
+	return retval;
+
+}
+
+/* Upper bound on the time a background job may hold the server loop */
+#define TARGET_JOB_SLICE_MS	50
+/* Number of finished jobs whose result 'jobs result' can report */
+#define TARGET_JOB_HISTORY	16
+/* Chunk size of load_image and verify_image jobs */
+#define TARGET_JOB_IMAGE_CHUNK	16384
+
+enum target_job_type {
+	TARGET_JOB_DUMP,
+	TARGET_JOB_LOAD,
+	TARGET_JOB_VERIFY,
+};
+
+/**
+ * A long running memory transfer that is advanced in bounded slices from a
+ * timer callback, so the servers stay responsive while it runs.
+ */
+struct target_job {
+	struct list_head lh;
+	unsigned int id;
+	enum target_job_type type;
+	const char *name;
+	struct target *target;
+	struct fileio *fileio;		/* dump_image destination */
+	struct image *image;		/* load_image and verify_image source */
+	unsigned int section;		/* current image section */
+	uint32_t section_offset;	/* next offset in the current section */
+	target_addr_t min_address;	/* load_image address window */
+	target_addr_t max_address;
+	uint8_t *buffer;
+	uint32_t buf_size;
+	target_addr_t address;		/* next dump_image address */
+	target_addr_t total;
+	target_addr_t remaining;
+	struct duration bench;
+	int retval;
+};
+
+/* Outcome of a finished job */
+struct target_job_result {
+	struct list_head lh;
+	unsigned int id;
+	int retval;
+	bool cancelled;
+};
+
+static OOCD_LIST_HEAD(target_jobs);
+static OOCD_LIST_HEAD(target_job_results);
+static unsigned int target_job_num_results;
+static unsigned int target_job_next_id = 1;
+
+static int target_jobs_timer_callback(void *priv);
+
+static void target_job_add(struct command_invocation *cmd, struct target_job *job)
+{
+	job->id = target_job_next_id++;
+	duration_start(&job->bench);
+
+	if (list_empty(&target_jobs))
+		target_register_timer_callback(target_jobs_timer_callback, 1,
+			TARGET_TIMER_TYPE_PERIODIC, NULL);
+	list_add_tail(&job->lh, &target_jobs);
+
+	command_print(cmd, "%u", job->id);
+}
+
+static void target_job_free(struct target_job *job)
+{
+	list_del(&job->lh);
+	if (job->fileio)
+		fileio_close(job->fileio);
+	if (job->image) {
+		image_close(job->image);
+		free(job->image);
+	}
+	free(job->buffer);
+	free(job);
+
+	if (list_empty(&target_jobs))
+		target_unregister_timer_callback(target_jobs_timer_callback, NULL);
+}
+
+static void target_job_add_result(struct target_job *job, int retval, bool cancelled)
+{
+	struct target_job_result *result = malloc(sizeof(*result));
+	if (!result) {
+		LOG_ERROR("Out of memory");
+		return;
+	}
+
+	result->id = job->id;
+	result->retval = retval;
+	result->cancelled = cancelled;
+	list_add_tail(&result->lh, &target_job_results);
+
+	if (++target_job_num_results > TARGET_JOB_HISTORY) {
+		struct target_job_result *oldest = list_first_entry(&target_job_results,
+				struct target_job_result, lh);
+		list_del(&oldest->lh);
+		free(oldest);
+		target_job_num_results--;
+	}
+}
+
+static void target_job_finish(struct target_job *job, int retval)
+{
+	static const char * const verb[] = {
+		[TARGET_JOB_DUMP] = "dumped",
+		[TARGET_JOB_LOAD] = "downloaded",
+		[TARGET_JOB_VERIFY] = "verified",
+	};
+	struct target *target = job->target;
+	target_addr_t done = job->total - job->remaining;
+
+	if (retval == ERROR_OK && duration_measure(&job->bench) == ERROR_OK)
+		LOG_TARGET_INFO(target, "job %u: %s %s %" PRIu64 " bytes in %fs (%0.3f KiB/s)",
+			job->id, job->name, verb[job->type], (uint64_t)done,
+			duration_elapsed(&job->bench), duration_kbps(&job->bench, done));
+	else
+		LOG_TARGET_ERROR(target, "job %u: %s failed after %" PRIu64 " bytes",
+			job->id, job->name, (uint64_t)done);
+
+	target_job_add_result(job, retval, false);
+	target_job_free(job);
+}
+
+static int target_job_dump_chunk(struct target_job *job)
+{
+	size_t size_written;
+	uint32_t this_run_size = MIN(job->remaining, job->buf_size);
+	int retval = target_read_buffer(job->target, job->address, this_run_size, job->buffer);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = fileio_write(job->fileio, this_run_size, job->buffer, &size_written);
+	if (retval != ERROR_OK)
+		return retval;
+
+	job->remaining -= this_run_size;
+	job->address += this_run_size;
+
+	return ERROR_OK;
+}
+
+/* The part [*start, *end) of an image section the job has to handle, clipped
+ * to the address window of load_image. Returns false if there is none. */
+static bool target_job_section_window(struct target_job *job, unsigned int i,
+		uint32_t *start, uint32_t *end)
+{
+	struct imagesection *section = &job->image->sections[i];
+
+	*start = 0;
+	*end = section->size;
+
+	if (job->type == TARGET_JOB_LOAD) {
+		/* same clipping as the foreground load_image */
+		if (section->base_address + section->size < job->min_address ||
+				section->base_address >= job->max_address)
+			return false;
+		if (section->base_address < job->min_address)
+			*start = job->min_address - section->base_address;
+		if (section->base_address + section->size > job->max_address)
+			*end = job->max_address - section->base_address;
+	}
+
+	return *start < *end;
+}
+
+static int target_job_image_chunk(struct target_job *job)
+{
+	struct image *image = job->image;
+	uint32_t start, end;
+
+	/* skip to the next section with something left to do */
+	while (job->section < image->num_sections) {
+		if (target_job_section_window(job, job->section, &start, &end) &&
+				job->section_offset < end)
+			break;
+		job->section++;
+		job->section_offset = 0;
+	}
+	if (job->section == image->num_sections) {
+		job->remaining = 0;
+		return ERROR_OK;
+	}
+
+	uint32_t offset = MAX(job->section_offset, start);
+	target_addr_t address = image->sections[job->section].base_address + offset;
+	size_t size_read;
+
+	int retval = image_read_section(image, job->section, offset,
+			MIN(end - offset, job->buf_size), job->buffer, &size_read);
+	if (retval != ERROR_OK)
+		return retval;
+	if (size_read == 0)
+		return ERROR_FAIL;
+
+	if (job->type == TARGET_JOB_LOAD) {
+		retval = target_write_buffer(job->target, address, size_read, job->buffer);
+	} else {
+		uint32_t checksum, mem_checksum;
+
+		retval = image_calculate_checksum(job->buffer, size_read, &checksum);
+		if (retval == ERROR_OK)
+			retval = target_checksum_memory(job->target, address, size_read, &mem_checksum);
+		if (retval == ERROR_OK && checksum != mem_checksum) {
+			LOG_TARGET_ERROR(job->target, "job %u: checksum mismatch in %zu bytes at address "
+					TARGET_ADDR_FMT, job->id, size_read, address);
+			retval = ERROR_FAIL;
+		}
+	}
+	if (retval != ERROR_OK)
+		return retval;
+
+	job->section_offset = offset + size_read;
+	job->remaining -= MIN(job->remaining, size_read);
+
+	return ERROR_OK;
+}
+
+static int target_job_step(struct target_job *job)
+{
+	int64_t deadline = timeval_ms() + TARGET_JOB_SLICE_MS;
+
+	while (job->remaining > 0 && timeval_ms() < deadline) {
+		int retval;
+
+		if (job->type == TARGET_JOB_DUMP)
+			retval = target_job_dump_chunk(job);
+		else
+			retval = target_job_image_chunk(job);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	return ERROR_OK;
+}
+
+static int target_jobs_timer_callback(void *priv)
+{
+	struct target_job *job, *tmp;
+	OOCD_LIST_HEAD(finished);
+
+	/* don't interleave with reset or event handler sequences */
+	if (!is_jtag_poll_safe() || target_event_handler_running())
+		return ERROR_OK;
+
+	list_for_each_entry_safe(job, tmp, &target_jobs, lh) {
+		/* paused while the target runs */
+		if (job->target->state != TARGET_HALTED)
+			continue;
+
+		job->retval = target_job_step(job);
+		if (job->retval != ERROR_OK || job->remaining == 0)
+			list_move_tail(&job->lh, &finished);
 	}
-	free(target_buf);
 
-	return retval;
-}
+	/* Report only after the walk, job-done handlers may start or cancel jobs */
+	list_for_each_entry_safe(job, tmp, &finished, lh) {
+		struct target *target = job->target;
+
+		target_job_finish(job, job->retval);
+		target_call_event_callbacks(target, TARGET_EVENT_JOB_DONE);
+	}
 
+	return ERROR_OK;
+}
 
-COMMAND_HANDLER(handle_mw_command)
+static void target_job_cancel(struct target_job *job)
 {
-	if (CMD_ARGC < 2)
-		return ERROR_COMMAND_SYNTAX_ERROR;
-	bool physical = strcmp(CMD_ARGV[0], "phys") == 0;
-	target_write_fn fn;
-	if (physical) {
-		CMD_ARGC--;
-		CMD_ARGV++;
-		fn = target_write_phys_memory;
-	} else
-		fn = target_write_memory;
-	if ((CMD_ARGC < 2) || (CMD_ARGC > 3))
-		return ERROR_COMMAND_SYNTAX_ERROR;
+	LOG_TARGET_INFO(job->target, "job %u: %s cancelled", job->id, job->name);
+	target_job_add_result(job, ERROR_FAIL, true);
+	target_job_free(job);
+}
 
-	target_addr_t address;
-	COMMAND_PARSE_ADDRESS(CMD_ARGV[0], address);
+static void target_cancel_all_jobs(void)
+{
+	struct target_job *job, *tmp;
+	OOCD_LIST_HEAD(cancelled);
 
-	uint64_t value;
-	COMMAND_PARSE_NUMBER(u64, CMD_ARGV[1], value);
+	/* job-done handlers may start new jobs, which must survive */
+	list_splice_init(&target_jobs, &cancelled);
 
-	unsigned int count = 1;
-	if (CMD_ARGC == 3)
-		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[2], count);
+	list_for_each_entry_safe(job, tmp, &cancelled, lh) {
+		struct target *target = job->target;
 
-	struct target *target = get_current_target(CMD_CTX);
-	unsigned int wordsize;
-	switch (CMD_NAME[2]) {
-	case 'd':
-		wordsize = 8;
-		break;
-	case 'w':
-		wordsize = 4;
-		break;
-	case 'h':
-		wordsize = 2;
-		break;
-	case 'b':
-		wordsize = 1;
-		break;
-	default:
-		return ERROR_COMMAND_SYNTAX_ERROR;
+		target_job_cancel(job);
+		target_call_event_callbacks(target, TARGET_EVENT_JOB_DONE);
 	}
-
-	return target_fill_mem(target, address, fn, wordsize, value, count);
 }
 
-static COMMAND_HELPER(parse_load_image_command, struct image *image,
-		target_addr_t *min_address, target_addr_t *max_address)
+static void target_free_all_jobs(void)
 {
-	if (CMD_ARGC < 1 || CMD_ARGC > 5)
-		return ERROR_COMMAND_SYNTAX_ERROR;
+	struct target_job *job, *tmp;
+	struct target_job_result *result, *tmp_result;
 
-	/* a base address isn't always necessary,
-	 * default to 0x0 (i.e. don't relocate) */
-	if (CMD_ARGC >= 2) {
-		target_addr_t addr;
-		COMMAND_PARSE_ADDRESS(CMD_ARGV[1], addr);
-		image->base_address = addr;
-		image->base_address_set = true;
-	} else
-		image->base_address_set = false;
+	list_for_each_entry_safe(job, tmp, &target_jobs, lh)
+		target_job_free(job);
 
-	image->start_address_set = false;
+	list_for_each_entry_safe(result, tmp_result, &target_job_results, lh) {
+		list_del(&result->lh);
+		free(result);
+	}
+	target_job_num_results = 0;
+}
 
-	if (CMD_ARGC >= 4)
-		COMMAND_PARSE_ADDRESS(CMD_ARGV[3], *min_address);
-	if (CMD_ARGC == 5) {
-		COMMAND_PARSE_ADDRESS(CMD_ARGV[4], *max_address);
-		/* use size (given) to find max (required) */
-		*max_address += *min_address;
+/* Start a background job on the sections of an opened image, which it takes
+ * ownership of. */
+static COMMAND_HELPER(target_job_start_image, enum target_job_type type,
+		struct image *image, target_addr_t min_address, target_addr_t max_address)
+{
+	struct target_job *job = calloc(1, sizeof(*job));
+	uint8_t *buffer = malloc(TARGET_JOB_IMAGE_CHUNK);
+	if (!job || !buffer) {
+		LOG_ERROR("Out of memory");
+		free(job);
+		free(buffer);
+		image_close(image);
+		free(image);
+		return ERROR_FAIL;
 	}
 
-	if (*min_address > *max_address)
-		return ERROR_COMMAND_SYNTAX_ERROR;
+	job->type = type;
+	job->name = (type == TARGET_JOB_LOAD) ? "load_image" : "verify_image";
+	job->target = get_current_target(CMD_CTX);
+	job->image = image;
+	job->min_address = min_address;
+	job->max_address = max_address;
+	job->buffer = buffer;
+	job->buf_size = TARGET_JOB_IMAGE_CHUNK;
 
+	for (unsigned int i = 0; i < image->num_sections; i++) {
+		uint32_t start, end;
+
+		if (target_job_section_window(job, i, &start, &end))
+			job->total += end - start;
+	}
+	job->remaining = job->total;
+
+	target_job_add(CMD, job);
 	return ERROR_OK;
 }
 
-COMMAND_HANDLER(handle_load_image_command)
+COMMAND_HANDLER(start_load_image_job)
 {
-	uint8_t *buffer;
-	size_t buf_cnt;
-	uint32_t image_size;
 	target_addr_t min_address = 0;
 	target_addr_t max_address = -1;
-	struct image image;
+	struct image *image = malloc(sizeof(*image));
+	if (!image) {
+		LOG_ERROR("Out of memory");
+		return ERROR_FAIL;
+	}
 
 	int retval = CALL_COMMAND_HANDLER(parse_load_image_command,
-			&image, &min_address, &max_address);
-	if (retval != ERROR_OK)
+			image, &min_address, &max_address);
+	if (retval == ERROR_OK)
+		retval = image_open(image, CMD_ARGV[0], (CMD_ARGC >= 3) ? CMD_ARGV[2] : NULL);
+	if (retval != ERROR_OK) {
+		free(image);
 		return retval;
+	}
 
-	struct target *target = get_current_target(CMD_CTX);
+	return CALL_COMMAND_HANDLER(target_job_start_image, TARGET_JOB_LOAD,
+			image, min_address, max_address);
+}
 
-	struct duration bench;
-	duration_start(&bench);
+COMMAND_HANDLER(start_verify_image_job)
+{
+	if (CMD_ARGC < 1 || CMD_ARGC > 3)
+		return ERROR_COMMAND_SYNTAX_ERROR;
 
-	if (image_open(&image, CMD_ARGV[0], (CMD_ARGC >= 3) ? CMD_ARGV[2] : NULL) != ERROR_OK)
+	target_addr_t addr = 0;
+	if (CMD_ARGC >= 2)
+		COMMAND_PARSE_ADDRESS(CMD_ARGV[1], addr);
+
+	struct image *image = malloc(sizeof(*image));
+	if (!image) {
+		LOG_ERROR("Out of memory");
 		return ERROR_FAIL;
+	}
 
-	image_size = 0x0;
-	retval = ERROR_OK;
-	for (unsigned int i = 0; i < image.num_sections; i++) {
-		buffer = malloc(image.sections[i].size);
-		if (!buffer) {
-			command_print(CMD,
-						  "error allocating buffer for section (%d bytes)",
-						  (int)(image.sections[i].size));
-			retval = ERROR_FAIL;
-			break;
-		}
+	image->base_address = addr;
+	image->base_address_set = CMD_ARGC >= 2;
+	image->start_address_set = false;
 
-		retval = image_read_section(&image, i, 0x0, image.sections[i].size, buffer, &buf_cnt);
-		if (retval != ERROR_OK) {
-			free(buffer);
-			break;
-		}
+	int retval = image_open(image, CMD_ARGV[0], (CMD_ARGC == 3) ? CMD_ARGV[2] : NULL);
+	if (retval != ERROR_OK) {
+		free(image);
+		return retval;
+	}
 
-		uint32_t offset = 0;
-		uint32_t length = buf_cnt;
+	return CALL_COMMAND_HANDLER(target_job_start_image, TARGET_JOB_VERIFY,
+			image, 0, (target_addr_t)-1);
+}
 
-		/* DANGER!!! beware of unsigned comparison here!!! */
+COMMAND_HANDLER(handle_jobs_command)
+{
+	struct target_job *job;
 
-		if ((image.sections[i].base_address + buf_cnt >= min_address) &&
-				(image.sections[i].base_address < max_address)) {
+	if (CMD_ARGC == 2 && !strcmp(CMD_ARGV[0], "cancel")) {
+		unsigned int id;
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[1], id);
 
-			if (image.sections[i].base_address < min_address) {
-				/* clip addresses below */
-				offset += min_address-image.sections[i].base_address;
-				length -= offset;
+		list_for_each_entry(job, &target_jobs, lh) {
+			if (job->id == id) {
+				target_job_cancel(job);
+				return ERROR_OK;
 			}
+		}
 
-			if (image.sections[i].base_address + buf_cnt > max_address)
-				length -= (image.sections[i].base_address + buf_cnt)-max_address;
+		command_print(CMD, "no job %u", id);
+		return ERROR_FAIL;
+	}
 
-			retval = target_write_buffer(target,
-					image.sections[i].base_address + offset, length, buffer + offset);
-			if (retval != ERROR_OK) {
-				free(buffer);
-				break;
-			}
-			image_size += length;
-			command_print(CMD, "%u bytes written at address " TARGET_ADDR_FMT "",
-					(unsigned int)length,
-					image.sections[i].base_address + offset);
+	if (CMD_ARGC >= 1 && !strcmp(CMD_ARGV[0], "result")) {
+		struct target_job_result *result = NULL, *r;
+
+		if (CMD_ARGC > 2)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+
+		if (CMD_ARGC == 2) {
+			unsigned int id;
+			COMMAND_PARSE_NUMBER(uint, CMD_ARGV[1], id);
+			list_for_each_entry(r, &target_job_results, lh)
+				if (r->id == id)
+					result = r;
+		} else if (!list_empty(&target_job_results)) {
+			result = list_last_entry(&target_job_results, struct target_job_result, lh);
 		}
 
-		free(buffer);
-	}
+		if (!result) {
+			command_print(CMD, "no finished job");
+			return ERROR_FAIL;
+		}
 
-	if ((retval == ERROR_OK) && (duration_measure(&bench) == ERROR_OK)) {
-		command_print(CMD, "downloaded %" PRIu32 " bytes "
-				"in %fs (%0.3f KiB/s)", image_size,
-				duration_elapsed(&bench), duration_kbps(&bench, image_size));
+		command_print(CMD, "%u %s", result->id,
+			result->cancelled ? "cancelled" :
+			(result->retval == ERROR_OK) ? "done" : "failed");
+		return ERROR_OK;
 	}
 
-	image_close(&image);
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
 
-	return retval;
+	list_for_each_entry(job, &target_jobs, lh) {
+		target_addr_t done = job->total - job->remaining;
+		float elapsed = 0;
+
+		if (duration_measure(&job->bench) == ERROR_OK)
+			elapsed = duration_elapsed(&job->bench);
+
+		command_print(CMD, "%3u %-12s %-20s %3u%% %10.3f KiB/s",
+			job->id, job->name, target_name(job->target),
+			(unsigned int)(job->total ? done * 100 / job->total : 100),
+			elapsed > 0 ? done / 1024.0 / elapsed : 0.0);
+	}
 
+	return ERROR_OK;
 }
 
 COMMAND_HANDLER(handle_dump_image_command)
@@ -3659,6 +4732,13 @@ COMMAND_HANDLER(handle_dump_image_command)
 	target_addr_t address, size;
 	struct duration bench;
 	struct target *target = get_current_target(CMD_CTX);
+	bool background = false;
+
+	if (CMD_ARGC > 0 && !strcmp(CMD_ARGV[0], "-bg")) {
+		background = true;
+		CMD_ARGC--;
+		CMD_ARGV++;
+	}
 
 	if (CMD_ARGC != 3)
 		return ERROR_COMMAND_SYNTAX_ERROR;
@@ -3677,6 +4757,29 @@ COMMAND_HANDLER(handle_dump_image_command)
 		return retval;
 	}
 
+	if (background) {
+		struct target_job *job = calloc(1, sizeof(*job));
+		if (!job) {
+			LOG_ERROR("Out of memory");
+			fileio_close(fileio);
+			free(buffer);
+			return ERROR_FAIL;
+		}
+
+		job->type = TARGET_JOB_DUMP;
+		job->name = "dump_image";
+		job->target = target;
+		job->fileio = fileio;
+		job->buffer = buffer;
+		job->buf_size = buf_size;
+		job->address = address;
+		job->total = size;
+		job->remaining = size;
+
+		target_job_add(CMD, job);
+		return ERROR_OK;
+	}
+
 	duration_start(&bench);
 
 	while (size > 0) {
@@ -3740,6 +4843,13 @@ static COMMAND_HELPER(handle_verify_image_command_internal, enum verify_mode ver
 		return ERROR_FAIL;
 	}
 
+	/* in the background only checksums are compared, no binary diff */
+	if (verify != IMAGE_TEST && !strcmp(CMD_ARGV[0], "-bg")) {
+		CMD_ARGC--;
+		CMD_ARGV++;
+		return CALL_COMMAND_HANDLER(start_verify_image_job);
+	}
+
 	struct duration bench;
 	duration_start(&bench);
 
@@ -4616,6 +5726,9 @@ COMMAND_HANDLER(handle_target_write_memory)
 /* FIX? should we propagate errors here rather than printing them
  * and continuing?
  */
+/* nesting depth of target event handlers being run */
+static unsigned int target_event_handler_depth;
+
 void target_handle_event(struct target *target, enum target_event e)
 {
 	struct target_event_action *teap, *tmp;
@@ -4650,7 +5763,9 @@ void target_handle_event(struct target *target, enum target_event e)
 			 * Prevent the body to get deallocated by Jim.
 			 */
 			Jim_IncrRefCount(teap->body);
+			target_event_handler_depth++;
 			retval = Jim_EvalObj(teap->interp, teap->body);
+			target_event_handler_depth--;
 			Jim_DecrRefCount(teap->interp, teap->body);
 
 			cmd_ctx->current_target_override = saved_target_override;
@@ -4813,6 +5928,14 @@ bool target_has_event_action(const struct target *target, enum target_event even
 	return false;
 }
 
+/**
+ * Returns true while the Tcl handler of any target event is running.
+ */
+bool target_event_handler_running(void)
+{
+	return target_event_handler_depth > 0;
+}
+
 enum target_cfg_param {
 	TCFG_TYPE,
 	TCFG_EVENT,
@@ -5455,6 +6578,42 @@ COMMAND_HANDLER(handle_target_current_state)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(handle_target_working_area)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	struct target *target = get_current_target(CMD_CTX);
+	struct working_area_stats *stats = &target->working_area_stats;
+	uint32_t size = ALIGN_DOWN(target->working_area_size, 4);
+	uint32_t in_use = target_working_area_in_use(target);
+	unsigned int fragments = 0;
+
+	if (!target->working_areas) {
+		command_print(CMD, "working area of %" PRIu32 " bytes, not in use", size);
+	} else {
+		command_print(CMD, "working area " TARGET_ADDR_FMT ", %" PRIu32 " bytes, backup %s",
+				target->working_area, size, target->backup_working_area ? "on" : "off");
+		for (struct working_area *c = target->working_areas; c; c = c->next) {
+			const char *state = c->free ? "free" : (c->user ? "in use" : "resident");
+			command_print(CMD, "  " TARGET_ADDR_FMT "-" TARGET_ADDR_FMT " %8" PRIu32 " bytes %s%s",
+					c->address, c->address + c->size - 1, c->size, state,
+					c->resident && c->user ? ", resident" : "");
+			if (c->free)
+				fragments++;
+		}
+	}
+
+	command_print(CMD, "in use %" PRIu32 " bytes (%" PRIu32 "%%), peak %" PRIu32
+			" bytes, largest available block %" PRIu32 " bytes, %u free fragment(s)",
+			in_use, size ? (uint32_t)((uint64_t)in_use * 100 / size) : 0, stats->peak,
+			target_get_working_area_avail(target), fragments);
+	command_print(CMD, "allocations %u, failed %u, resident reuses %u",
+			stats->allocs, stats->failures, stats->resident_hits);
+
+	return ERROR_OK;
+}
+
 COMMAND_HANDLER(handle_target_debug_reason)
 {
 	if (CMD_ARGC != 0)
@@ -5606,6 +6765,13 @@ static const struct command_registration target_instance_command_handlers[] = {
 		.help = "displays the current state of this target",
 		.usage = "",
 	},
+	{
+		.name = "working_area",
+		.mode = COMMAND_EXEC,
+		.handler = handle_target_working_area,
+		.help = "displays the working area layout and allocation statistics",
+		.usage = "",
+	},
 	{
 		.name = "debug_reason",
 		.mode = COMMAND_EXEC,
@@ -6216,6 +7382,89 @@ COMMAND_HANDLER(handle_fast_load_command)
 	return retval;
 }
 
+static int timer_callback_seq_compare(const void *a, const void *b)
+{
+	const struct target_timer_callback *ca = *(const struct target_timer_callback **)a;
+	const struct target_timer_callback *cb = *(const struct target_timer_callback **)b;
+
+	return (ca->seq > cb->seq) - (ca->seq < cb->seq);
+}
+
+COMMAND_HANDLER(handle_timer_stats_command)
+{
+	bool reset = false;
+
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC == 1) {
+		if (strcmp(CMD_ARGV[0], "reset"))
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		reset = true;
+	}
+
+	struct target_timer_callback **list = NULL;
+	unsigned int num = target_timer_heap_len;
+	if (num) {
+		list = malloc(num * sizeof(*list));
+		if (!list) {
+			LOG_ERROR("Out of memory");
+			return ERROR_FAIL;
+		}
+		memcpy(list, target_timer_heap, num * sizeof(*list));
+		qsort(list, num, sizeof(*list), timer_callback_seq_compare);
+	}
+
+	for (unsigned int i = 0; i < num; i++) {
+		struct target_timer_stats *stats = &list[i]->stats;
+
+		if (reset) {
+			memset(stats, 0, sizeof(*stats));
+			continue;
+		}
+
+		command_print(CMD, "%p(%p) %s %u ms: %u calls", list[i]->callback, list[i]->priv,
+				list[i]->type == TARGET_TIMER_TYPE_PERIODIC ? "every" : "once after",
+				list[i]->time_ms, stats->calls);
+		if (!stats->calls)
+			continue;
+		command_print(CMD, "    latency min/avg/max %" PRId64 "/%" PRId64 "/%" PRId64
+				" ms, jitter %" PRId64 " ms, run time avg/max %" PRId64 "/%" PRId64 " us",
+				stats->latency_min, stats->latency_sum / stats->calls, stats->latency_max,
+				stats->latency_max - stats->latency_min,
+				stats->run_time_sum / stats->calls, stats->run_time_max);
+	}
+	free(list);
+
+	int64_t elapsed_ms = polling_stats_start ? timeval_ms() - polling_stats_start : 0;
+	if (reset)
+		polling_stats_start = timeval_ms();
+
+	for (struct target *target = all_targets; target; target = target->next) {
+		struct target_polling *polling = &target->polling;
+
+		if (reset) {
+			polling->polls = 0;
+			polling->time_sum = 0;
+			polling->time_max = 0;
+			continue;
+		}
+		command_print(CMD, "%s: polled every %u ms, %u polls", target_name(target),
+				MAX(polling->interval, (unsigned int)polling_interval),
+				polling->polls);
+		if (!polling->polls || elapsed_ms <= 0)
+			continue;
+		/* polls are adapter bound, their run time is the share of the
+		 * adapter they take away from everything else */
+		int64_t share = polling->time_sum * 10 / elapsed_ms;	/* 1/100 % */
+		command_print(CMD, "    poll time avg/max %" PRId64 "/%" PRId64
+				" us, %" PRId64 ".%02" PRId64 "%% of the adapter time",
+				polling->time_sum / polling->polls, polling->time_max,
+				share / 100, share % 100);
+	}
+
+	return ERROR_OK;
+}
+
 static const struct command_registration target_command_handlers[] = {
 	{
 		.name = "targets",
@@ -6232,6 +7481,14 @@ static const struct command_registration target_command_handlers[] = {
 		.chain = target_subcommand_handlers,
 		.usage = "",
 	},
+	{
+		.name = "timer_stats",
+		.handler = handle_timer_stats_command,
+		.mode = COMMAND_EXEC,
+		.help = "report latency, jitter and run time of timer callbacks, "
+			"and the current polling interval of each target",
+		.usage = "['reset']",
+	},
 	COMMAND_REGISTRATION_DONE
 };
 
@@ -6646,26 +7903,34 @@ static const struct command_registration target_exec_command_handlers[] = {
 		.name = "load_image",
 		.handler = handle_load_image_command,
 		.mode = COMMAND_EXEC,
-		.usage = "filename [address ['bin'|'ihex'|'elf'|'s19' "
+		.usage = "['-bg'] filename [address ['bin'|'ihex'|'elf'|'s19' "
 			"[min_address [max_length]]]]",
 	},
 	{
 		.name = "dump_image",
 		.handler = handle_dump_image_command,
 		.mode = COMMAND_EXEC,
-		.usage = "filename address size",
+		.usage = "['-bg'] filename address size",
+	},
+	{
+		.name = "jobs",
+		.handler = handle_jobs_command,
+		.mode = COMMAND_EXEC,
+		.help = "list background jobs with their progress, cancel one "
+			"or report the outcome of a finished one",
+		.usage = "['cancel' job_id | 'result' [job_id]]",
 	},
 	{
 		.name = "verify_image_checksum",
 		.handler = handle_verify_image_checksum_command,
 		.mode = COMMAND_EXEC,
-		.usage = "filename [offset [type]]",
+		.usage = "['-bg'] filename [offset [type]]",
 	},
 	{
 		.name = "verify_image",
 		.handler = handle_verify_image_command,
 		.mode = COMMAND_EXEC,
-		.usage = "filename [offset [type]]",
+		.usage = "['-bg'] filename [offset [type]]",
 	},
 	{
 		.name = "test_image",
@@ -31,6 +31,7 @@ struct trace;
 struct command_context;
 struct command_invocation;
 struct breakpoint;
+struct breakpoint_index;
 struct watchpoint;
 struct mem_param;
 struct reg_param;
@@ -89,11 +90,19 @@ struct working_area {
 	target_addr_t address;
 	uint32_t size;
 	bool free;
-	uint8_t *backup;
+	bool resident;			/* content is kept after release, see target_alloc_working_area_resident() */
+	uint32_t resident_crc;	/* crc32 of the resident content */
 	struct working_area **user;
 	struct working_area *next;
 };
 
+struct working_area_stats {
+	unsigned int allocs;			/* successful allocations */
+	unsigned int failures;			/* allocations failed for lack of space */
+	unsigned int resident_hits;		/* allocations served by resident content */
+	uint32_t peak;					/* maximum number of bytes allocated at once */
+};
+
 struct gdb_service {
 	struct target *target;
 	/*  field for smp display  */
@@ -109,6 +118,16 @@ struct backoff_timer {
 	int count;
 };
 
+/* adaptive polling state, see handle_target() */
+struct target_polling {
+	unsigned int interval;	/* current interval in ms */
+	int64_t next;	/* output of timeval_ms() when the target is due */
+	unsigned int polls;	/* number of polls issued */
+	int64_t time_sum;	/* us spent in background polls */
+	int64_t time_max;
+	bool prefetched;	/* poll_prefetch() read this pass's status */
+};
+
 /* split target registers into multiple class */
 enum target_register_class {
 	REG_CLASS_ALL,
@@ -160,13 +179,17 @@ struct target {
 	target_addr_t working_area_phys;			/* physical address */
 	uint32_t working_area_size;			/* size in bytes */
 	bool backup_working_area;			/* whether the content of the working area has to be preserved */
+	uint8_t *working_area_backup;		/* content of the working area saved during this session */
+	unsigned long *working_area_backed_up;	/* bitmap of the words saved in working_area_backup */
 	struct working_area *working_areas;/* list of allocated working areas */
+	struct working_area_stats working_area_stats;
 	enum target_debug_reason debug_reason;/* reason why the target entered debug state */
 	enum target_endianness endianness;	/* target endianness */
 	/* also see: target_state_name() */
 	enum target_state state;			/* the current backend-state (running, halted, ...) */
 	struct reg_cache *reg_cache;		/* the first register cache of the target (core regs) */
 	struct breakpoint *breakpoints;		/* list of breakpoints */
+	struct breakpoint_index *breakpoint_index;	/* breakpoints sorted by address */
 	struct watchpoint *watchpoints;		/* list of watchpoints */
 	struct trace *trace_info;			/* generic trace information */
 	struct debug_msg_receiver *dbgmsg;	/* list of debug message receivers */
@@ -194,6 +217,7 @@ struct target {
 	bool rtos_auto_detect;				/* A flag that indicates that the RTOS has been specified as "auto"
 										 * and must be detected when symbols are offered */
 	struct backoff_timer backoff;
+	struct target_polling polling;
 	unsigned int smp;					/* Unique non-zero number for each SMP group */
 	struct list_head *smp_targets;		/* list all targets in this smp group/cluster
 										 * The head of the list is shared between the
@@ -201,6 +225,9 @@ struct target {
 	bool smp_halt_event_postponed;		/* Some SMP implementations (currently Cortex-M) stores
 										 * 'halted' events and emits them after all targets of
 										 * the SMP group has been polled */
+	bool smp_nonstop;					/* SMP group temporarily decoupled for gdb non-stop
+										 * mode; smp is cleared so that cores halt and resume
+										 * individually, but they are still shown as threads */
 
 	/* the gdb service is there in case of smp, we have only one gdb server
 	 * for all smp target
@@ -295,6 +322,8 @@ enum target_event {
 
 	TARGET_EVENT_TRACE_CONFIG,
 
+	TARGET_EVENT_JOB_DONE,		/* a background job on this target finished */
+
 	TARGET_EVENT_SEMIHOSTING_USER_CMD_0X100 = 0x100, /* semihosting allows user cmds from 0x100 to 0x1ff */
 	TARGET_EVENT_SEMIHOSTING_USER_CMD_0X101 = 0x101,
 	TARGET_EVENT_SEMIHOSTING_USER_CMD_0X102 = 0x102,
@@ -306,6 +335,7 @@ enum target_event {
 };
 
 bool target_has_event_action(const struct target *target, enum target_event event);
+bool target_event_handler_running(void);
 
 struct target_event_callback {
 	int (*callback)(struct target *target, enum target_event event, void *priv);
@@ -330,6 +360,16 @@ enum target_timer_type {
 	TARGET_TIMER_TYPE_PERIODIC
 };
 
+/* timing of timer callback invocations, see 'timer_stats' */
+struct target_timer_stats {
+	unsigned int calls;
+	int64_t latency_min;	/* ms past the due time */
+	int64_t latency_max;
+	int64_t latency_sum;
+	int64_t run_time_max;	/* us spent in the callback */
+	int64_t run_time_sum;
+};
+
 struct target_timer_callback {
 	int (*callback)(void *priv);
 	unsigned int time_ms;
@@ -337,7 +377,9 @@ struct target_timer_callback {
 	bool removed;
 	int64_t when;	/* output of timeval_ms() */
 	void *priv;
-	struct target_timer_callback *next;
+	unsigned int heap_index;	/* position in the timer heap, UINT_MAX while running */
+	unsigned int seq;	/* registration order, breaks ties between equal deadlines */
+	struct target_timer_stats stats;
 };
 
 struct target_memory_check_block {
@@ -389,6 +431,7 @@ int target_unregister_trace_callback(
  * yet it is possible to detect error conditions.
  */
 int target_poll(struct target *target);
+bool target_poll_take_prefetch(struct target *target);
 int target_resume(struct target *target, bool current, target_addr_t address,
 		bool handle_breakpoints, bool debug_execution);
 int target_halt(struct target *target);
@@ -489,6 +532,14 @@ int target_add_hybrid_breakpoint(struct target *target,
 
 int target_remove_breakpoint(struct target *target,
 		struct breakpoint *breakpoint);
+/**
+ * Insert (@a set true) or remove all software breakpoints of @a target in
+ * one batch.
+ *
+ * This routine is a wrapper for target->type->update_sw_breakpoints and
+ * does nothing for targets that do not provide it.
+ */
+int target_update_sw_breakpoints(struct target *target, bool set);
 /**
  * Add the @a watchpoint for @a target.
  *
@@ -680,6 +731,13 @@ int target_read_buffer(struct target *target,
 		target_addr_t address, uint32_t size, uint8_t *buffer);
 int target_checksum_memory(struct target *target,
 		target_addr_t address, uint32_t size, uint32_t *crc);
+
+/**
+ * Largest block an on-target CRC algorithm should cover in one run.
+ * Longer areas are checksummed in several runs, carrying the CRC over,
+ * so that each run's timeout stays bounded and keep_alive() is called.
+ */
+#define TARGET_CHECKSUM_ALGO_CHUNK (4 * 1024 * 1024)
 int target_blank_check_memory(struct target *target,
 		struct target_memory_check_block *blocks, unsigned int num_blocks,
 		uint8_t erased_value, unsigned int *checked);
@@ -748,12 +806,36 @@ int target_alloc_working_area(struct target *target,
  */
 int target_alloc_working_area_try(struct target *target,
 		uint32_t size, struct working_area **area);
+/**
+ * Allocate the largest working area available, but no more than @a max_size
+ * bytes. Fails if less than @a min_size bytes are available. Meant for data
+ * buffers, which are more efficient the larger they are.
+ * @returns ERROR_OK or ERROR_TARGET_RESOURCE_NOT_AVAILABLE, without logging
+ * an error in the latter case
+ */
+int target_alloc_working_area_max(struct target *target,
+		uint32_t min_size, uint32_t max_size, struct working_area **area);
+/**
+ * Allocate a working area and load @a content into it, e.g. the code of a
+ * flash algorithm. If an area holding identical content is still resident
+ * from a previous call, it is reused without writing target memory again.
+ *
+ * Resident areas stay allocated after target_free_working_area() until the
+ * target resumes or resets, their memory is written by other means or the
+ * space is needed for another allocation.
+ */
+int target_alloc_working_area_resident(struct target *target,
+		const uint8_t *content, uint32_t size, struct working_area **area);
 /**
  * Free a working area.
- * Restore target data if area backup is configured.
+ * If area backup is configured, the saved target data is kept, so that the
+ * next allocation of the same memory doesn't need to save it again. It is
+ * restored when the target resumes or steps, or before that memory is
+ * written by target_write_memory(); reads of it return the saved data
+ * meanwhile.
  * @param target
  * @param area Pointer to the area to be freed or NULL
- * @returns ERROR_OK if successful; error code if restore failed
+ * @returns ERROR_OK
  */
 int target_free_working_area(struct target *target, struct working_area *area);
 void target_free_all_working_areas(struct target *target);
@@ -827,6 +909,8 @@ int target_profiling_default(struct target *target, uint32_t *samples, uint32_t
 extern bool get_target_reset_nag(void);
 
 #define TARGET_DEFAULT_POLLING_INTERVAL		100
+/* halted targets with nothing going on are polled at most this rarely */
+#define TARGET_IDLE_POLLING_INTERVAL		800
 
 const char *target_debug_reason_str(enum target_debug_reason reason);
 
@@ -32,6 +32,16 @@ struct target_type {
 
 	/* poll current target status */
 	int (*poll)(struct target *target);
+	/**
+	 * Optional. Queues the status reads of the next poll() without running
+	 * the queue. Background polling calls it for all due targets first and
+	 * then poll_prefetch_run() for each of them, so targets sharing a
+	 * debug port get their reads in one round trip. poll() uses the values
+	 * read only if target_poll_take_prefetch() says so.
+	 */
+	int (*poll_prefetch)(struct target *target);
+	/** Runs the queue poll_prefetch() added to, required along with it. */
+	int (*poll_prefetch_run)(struct target *target);
 	/* Invoked only from target_arch_state().
 	 * Issue USER() w/architecture specific status.  */
 	int (*arch_state)(struct target *target);
@@ -166,6 +176,18 @@ struct target_type {
 	 */
 	int (*remove_breakpoint)(struct target *target, struct breakpoint *breakpoint);
 
+	/**
+	 * Optional. Inserts (@a set true) or removes all software breakpoints
+	 * of @a target that are not yet in that state, as one batch with the
+	 * cache maintenance done once for the whole batch.
+	 *
+	 * Targets providing this method only validate and record software
+	 * breakpoints in add_breakpoint(). They must insert them on every
+	 * restart of the core, including restarts of SMP siblings and
+	 * algorithm runs.
+	 */
+	int (*update_sw_breakpoints)(struct target *target, bool set);
+
 	/* add watchpoint ... see add_breakpoint() comment above. */
 	int (*add_watchpoint)(struct target *target, struct watchpoint *watchpoint);
 
@@ -17,6 +17,7 @@
 #include <helper/align.h>
 #include <target/register.h>
 #include <target/algorithm.h>
+#include <target/image.h>
 
 #include "xtensa_chip.h"
 #include "xtensa.h"
@@ -2309,8 +2310,107 @@ int xtensa_write_buffer(struct target *target, target_addr_t address, uint32_t c
 
 int xtensa_checksum_memory(struct target *target, target_addr_t address, uint32_t count, uint32_t *checksum)
 {
-	LOG_WARNING("not implemented yet");
-	return ERROR_FAIL;
+	struct xtensa *xtensa = target_to_xtensa(target);
+	struct working_area *crc_algorithm;
+	struct xtensa_algorithm algorithm_info;
+	struct reg_param reg_params[4];
+	uint32_t crc = 0xffffffff;
+	bool use_table = true;
+	int retval;
+
+	static const uint8_t xtensa_crc_code[] = {
+#include "../../../contrib/loaders/checksum/xtensa_crc.inc"
+	};
+	static const uint8_t xtensa_crc_table_code[] = {
+#include "../../../contrib/loaders/checksum/xtensa_crc_table.inc"
+	};
+	const uint32_t table_offset = ALIGN_UP(sizeof(xtensa_crc_table_code), 4);
+	/* both loaders end with a 3 byte "break 1, 15" */
+	const uint32_t break_size = 3;
+	target_addr_t exit_point;
+
+	/* The loaders are assembled for little endian cores.  Small blocks
+	 * are faster to read back, target_checksum_memory() does that if we fail. */
+	if (XT_ISBE(xtensa) || count < sizeof(xtensa_crc_code) * 4)
+		return ERROR_FAIL;
+
+	/* Prefer the table driven loader, it needs another 1 KiB of working area */
+	retval = target_alloc_working_area_try(target, table_offset + 256 * 4, &crc_algorithm);
+	if (retval != ERROR_OK) {
+		use_table = false;
+		retval = target_alloc_working_area(target, sizeof(xtensa_crc_code), &crc_algorithm);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	if (crc_algorithm->address + crc_algorithm->size > address &&
+			crc_algorithm->address < address + count) {
+		target_free_working_area(target, crc_algorithm);
+		return ERROR_FAIL;
+	}
+
+	if (use_table) {
+		uint8_t table[256 * 4];
+		target_buffer_set_u32_array(target, table, 256, image_crc32_table());
+		retval = target_write_buffer(target, crc_algorithm->address,
+			sizeof(xtensa_crc_table_code), xtensa_crc_table_code);
+		if (retval == ERROR_OK)
+			retval = target_write_buffer(target, crc_algorithm->address + table_offset,
+				sizeof(table), table);
+	} else {
+		retval = target_write_buffer(target, crc_algorithm->address,
+			sizeof(xtensa_crc_code), xtensa_crc_code);
+	}
+	if (retval != ERROR_OK) {
+		target_free_working_area(target, crc_algorithm);
+		return retval;
+	}
+
+	exit_point = crc_algorithm->address - break_size +
+		(use_table ? sizeof(xtensa_crc_table_code) : sizeof(xtensa_crc_code));
+
+	algorithm_info.core_mode = XT_MODE_ANY;
+
+	init_reg_param(&reg_params[0], "a2", 32, PARAM_IN_OUT);
+	init_reg_param(&reg_params[1], "a3", 32, PARAM_OUT);
+	init_reg_param(&reg_params[2], "a4", 32, PARAM_OUT);
+	init_reg_param(&reg_params[3], "a5", 32, PARAM_OUT);
+	buf_set_u32(reg_params[3].value, 0, 32,
+		use_table ? crc_algorithm->address + table_offset : 0x04c11db7);
+
+	while (count > 0) {
+		uint32_t n = MIN(count, TARGET_CHECKSUM_ALGO_CHUNK);
+
+		buf_set_u32(reg_params[0].value, 0, 32, crc);
+		buf_set_u32(reg_params[1].value, 0, 32, address);
+		buf_set_u32(reg_params[2].value, 0, 32, n);
+
+		/* 20 second timeout/megabyte */
+		unsigned int timeout = 20000 * (1 + (n / (1024 * 1024)));
+
+		retval = target_run_algorithm(target, 0, NULL, 4, reg_params,
+			crc_algorithm->address, exit_point, timeout, &algorithm_info);
+		if (retval != ERROR_OK) {
+			LOG_TARGET_ERROR(target, "error executing xtensa crc algorithm");
+			break;
+		}
+
+		crc = buf_get_u32(reg_params[0].value, 0, 32);
+		address += n;
+		count -= n;
+	}
+
+	if (retval == ERROR_OK)
+		*checksum = crc;
+
+	destroy_reg_param(&reg_params[0]);
+	destroy_reg_param(&reg_params[1]);
+	destroy_reg_param(&reg_params[2]);
+	destroy_reg_param(&reg_params[3]);
+
+	target_free_working_area(target, crc_algorithm);
+
+	return retval;
 }
 
 int xtensa_poll(struct target *target)